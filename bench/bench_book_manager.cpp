@@ -0,0 +1,104 @@
+#include "../src/include/book_manager.hpp"
+#include <json.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Builds a deterministic stream of book frames: one snapshot per instrument
+// followed by `updates` change messages spread round-robin over instruments.
+static vector<nlohmann::json> make_frames(size_t instruments, size_t updates)
+{
+    vector<nlohmann::json> frames;
+    frames.reserve(instruments + updates);
+    vector<int64_t> change_ids(instruments, 1);
+    mt19937 rng(42);
+    uniform_int_distribution<int> level(0, 19);
+    uniform_real_distribution<double> size(0.0, 10.0);
+
+    for (size_t i = 0; i < instruments; ++i)
+    {
+        nlohmann::json bids = nlohmann::json::array();
+        nlohmann::json asks = nlohmann::json::array();
+        for (int l = 0; l < 20; ++l)
+        {
+            bids.push_back({"new", 50000.0 - l * 0.5, 1.0 + l});
+            asks.push_back({"new", 50000.5 + l * 0.5, 1.0 + l});
+        }
+        frames.push_back({{"type", "snapshot"},
+                          {"instrument_name", "BENCH-" + to_string(i)},
+                          {"timestamp", 0},
+                          {"change_id", change_ids[i]},
+                          {"bids", bids},
+                          {"asks", asks}});
+    }
+
+    for (size_t u = 0; u < updates; ++u)
+    {
+        size_t i = u % instruments;
+        int64_t prev = change_ids[i]++;
+        double amount = size(rng);
+        frames.push_back({{"type", "change"},
+                          {"instrument_name", "BENCH-" + to_string(i)},
+                          {"timestamp", static_cast<int64_t>(u)},
+                          {"prev_change_id", prev},
+                          {"change_id", change_ids[i]},
+                          {"bids", {{amount < 1.0 ? "delete" : "change", 50000.0 - level(rng) * 0.5, amount < 1.0 ? 0.0 : amount}}},
+                          {"asks", {{"change", 50000.5 + level(rng) * 0.5, size(rng) + 1.0}}}});
+    }
+    return frames;
+}
+
+int main(int argc, char **argv)
+{
+    size_t instruments = argc > 1 ? strtoul(argv[1], nullptr, 10) : 500;
+    size_t updates = argc > 2 ? strtoul(argv[2], nullptr, 10) : 500000;
+    size_t max_workers = max<size_t>(1, argc > 3 ? strtoul(argv[3], nullptr, 10) : thread::hardware_concurrency());
+
+    cout << "BookManager throughput: " << instruments << " instruments, " << updates << " updates" << endl;
+    cout << setw(8) << "workers" << setw(16) << "updates/sec" << setw(12) << "ns/update" << setw(12) << "retries" << endl;
+
+    for (size_t workers = 1;; workers = min(workers * 2, max_workers))
+    {
+        vector<nlohmann::json> frames = make_frames(instruments, updates);
+        uint64_t total = frames.size();
+
+        BookManager manager(workers, 1 << 16, 10);
+        manager.start();
+
+        uint64_t retries = 0;
+        auto start = chrono::steady_clock::now();
+        for (auto &frame : frames)
+        {
+            // submit() only moves from the frame when it is queued
+            while (!manager.submit(std::move(frame)))
+            {
+                retries++;
+                this_thread::yield();
+            }
+        }
+        while (manager.processed() < total)
+        {
+            this_thread::yield();
+        }
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        manager.stop();
+
+        double per_sec = elapsed > 0 ? total * 1e9 / elapsed : 0.0;
+        cout << setw(8) << workers
+             << setw(16) << fixed << setprecision(0) << per_sec
+             << setw(12) << setprecision(1) << (double)elapsed / total
+             << setw(12) << retries << endl;
+
+        if (workers == max_workers)
+        {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,415 @@
+#include "../src/include/deribit.hpp"
+#include "../src/include/frame_recorder.hpp"
+#include "../src/include/order_book.hpp"
+#include "../src/include/replay.hpp"
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Counts every heap allocation so the hot path's allocations per message
+// can be reported next to its throughput. Every replaceable form is defined
+// so none bypasses the count, and all of them release through one
+// out-of-line function: with free() inlined into callers, GCC pairs it with
+// the operator new it cannot see through and warns -Wmismatched-new-delete.
+static atomic<uint64_t> allocations{0};
+
+static void *counted_alloc(size_t size, size_t alignment = 0)
+{
+    allocations.fetch_add(1, memory_order_relaxed);
+    size = size ? size : 1;
+    if (alignment == 0)
+    {
+        return malloc(size);
+    }
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+[[gnu::noinline]] static void counted_free(void *p) noexcept
+{
+    free(p);
+}
+
+void *operator new(size_t size)
+{
+    if (void *p = counted_alloc(size))
+    {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, align_val_t alignment)
+{
+    if (void *p = counted_alloc(size, static_cast<size_t>(alignment)))
+    {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size, align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    return counted_alloc(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+    return counted_alloc(size);
+}
+
+void *operator new(size_t size, align_val_t alignment, const nothrow_t &) noexcept
+{
+    return counted_alloc(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, align_val_t alignment, const nothrow_t &) noexcept
+{
+    return counted_alloc(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, size_t) noexcept { counted_free(p); }
+void operator delete(void *p, const nothrow_t &) noexcept { counted_free(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { counted_free(p); }
+void operator delete(void *p, align_val_t) noexcept { counted_free(p); }
+void operator delete[](void *p, align_val_t) noexcept { counted_free(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { counted_free(p); }
+void operator delete[](void *p, size_t, align_val_t) noexcept { counted_free(p); }
+void operator delete(void *p, align_val_t, const nothrow_t &) noexcept { counted_free(p); }
+void operator delete[](void *p, align_val_t, const nothrow_t &) noexcept { counted_free(p); }
+
+static string notification(const string &channel, const nlohmann::json &data)
+{
+    return nlohmann::json({{"jsonrpc", "2.0"}, {"method", "subscription"}, {"params", {{"channel", channel}, {"data", data}}}}).dump();
+}
+
+static string instrument(size_t i)
+{
+    return "BENCH-" + to_string(i);
+}
+
+// Synthetic frames spread round-robin over `channels` instruments. Book
+// streams start with one snapshot per instrument and then change existing
+// levels, so steady-state book maintenance does not grow the maps.
+static vector<string> make_frames(const string &type, size_t channels, size_t messages)
+{
+    vector<string> frames;
+    frames.reserve(messages + channels);
+    mt19937 rng(42);
+    uniform_int_distribution<int> level(0, 19);
+    uniform_real_distribution<double> size(1.0, 10.0);
+    vector<int64_t> change_ids(channels, 1);
+
+    if (type == "book")
+    {
+        for (size_t i = 0; i < channels; ++i)
+        {
+            nlohmann::json bids = nlohmann::json::array();
+            nlohmann::json asks = nlohmann::json::array();
+            for (int l = 0; l < 20; ++l)
+            {
+                bids.push_back({"new", 50000.0 - l * 0.5, 1.0 + l});
+                asks.push_back({"new", 50000.5 + l * 0.5, 1.0 + l});
+            }
+            frames.push_back(notification("book." + instrument(i) + ".100ms",
+                                          {{"type", "snapshot"}, {"instrument_name", instrument(i)}, {"timestamp", 0}, {"change_id", 1}, {"bids", bids}, {"asks", asks}}));
+        }
+    }
+
+    for (size_t m = 0; m < messages; ++m)
+    {
+        size_t i = m % channels;
+        int64_t ts = 1700000000000 + static_cast<int64_t>(m);
+        if (type == "book")
+        {
+            int64_t prev = change_ids[i]++;
+            frames.push_back(notification("book." + instrument(i) + ".100ms",
+                                          {{"type", "change"}, {"instrument_name", instrument(i)}, {"timestamp", ts}, {"prev_change_id", prev}, {"change_id", change_ids[i]}, {"bids", {{"change", 50000.0 - level(rng) * 0.5, size(rng)}}}, {"asks", {{"change", 50000.5 + level(rng) * 0.5, size(rng)}}}}));
+        }
+        else if (type == "ticker")
+        {
+            double mark = 50000.0 + size(rng);
+            frames.push_back(notification("ticker." + instrument(i) + ".100ms",
+                                          {{"instrument_name", instrument(i)}, {"timestamp", ts}, {"state", "open"}, {"mark_price", mark}, {"index_price", mark - 1.0}, {"best_bid_price", mark - 0.5}, {"best_bid_amount", size(rng)}, {"best_ask_price", mark + 0.5}, {"best_ask_amount", size(rng)}, {"open_interest", 1000.0}, {"funding_8h", 0.0001}, {"stats", {{"high", mark + 100}, {"low", mark - 100}, {"volume", 1234.5}}}}));
+        }
+        else if (type == "trades")
+        {
+            frames.push_back(notification("trades." + instrument(i) + ".100ms",
+                                          nlohmann::json::array({{{"trade_id", to_string(m)}, {"trade_seq", m}, {"instrument_name", instrument(i)}, {"timestamp", ts}, {"price", 50000.0 + size(rng)}, {"amount", size(rng)}, {"direction", m % 2 ? "buy" : "sell"}, {"tick_direction", 0}, {"index_price", 50000.0}, {"mark_price", 50000.0}}})));
+        }
+        else
+        {
+            // user.orders channels are keyed by kind and currency, not instrument
+            frames.push_back(notification("user.orders.BENCH." + to_string(i) + ".raw",
+                                          {{"order_id", to_string(m)}, {"instrument_name", instrument(i)}, {"creation_timestamp", ts}, {"last_update_timestamp", ts}, {"order_state", "open"}, {"order_type", "limit"}, {"direction", "buy"}, {"price", 50000.0}, {"amount", 10.0}, {"filled_amount", 0.0}, {"average_price", 0.0}, {"time_in_force", "good_til_cancelled"}, {"post_only", false}, {"label", ""}}));
+        }
+    }
+    return frames;
+}
+
+struct Result
+{
+    uint64_t messages = 0;
+    double seconds = 0.0;
+    uint64_t allocations = 0;
+};
+
+static Result run(Deribit &client, const vector<string> &frames, size_t warmup)
+{
+    for (size_t i = 0; i < warmup && i < frames.size(); ++i)
+    {
+        client.handle_message(frames[i]);
+    }
+
+    Result result;
+    uint64_t before = allocations.load();
+    auto start = chrono::steady_clock::now();
+    for (size_t i = warmup; i < frames.size(); ++i)
+    {
+        client.handle_message(frames[i]);
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.allocations = allocations.load() - before;
+    result.messages = frames.size() - warmup;
+    return result;
+}
+
+static void print(const string &type, size_t channels, const Result &r)
+{
+    cout << setw(12) << type << setw(10) << channels
+         << setw(14) << fixed << setprecision(0) << r.messages / r.seconds
+         << setw(12) << setprecision(1) << r.seconds * 1e9 / r.messages
+         << setw(14) << setprecision(2) << double(r.allocations) / r.messages << endl;
+}
+
+// Registers the handlers a typical consumer would: books are applied to
+// local OrderBooks, tickers/trades/orders read a field.
+static void subscribe(Deribit &client, const string &type, size_t channels,
+                      unordered_map<string, OrderBook> &books, double &sink)
+{
+    vector<string> symbols;
+    for (size_t i = 0; i < channels; ++i)
+    {
+        symbols.push_back(instrument(i));
+    }
+
+    if (type == "book")
+    {
+        for (const auto &symbol : symbols)
+        {
+            books.emplace(symbol, OrderBook(symbol));
+        }
+        client.watch_order_book_for_symbols([&books](const nlohmann::json &data)
+                                            { books.find(data["instrument_name"].get_ref<const string &>())->second.apply(data); },
+                                            symbols);
+    }
+    else if (type == "ticker")
+    {
+        client.watch_tickers([&sink](const nlohmann::json &data)
+                             { sink += data["mark_price"].get<double>(); },
+                             symbols);
+    }
+    else if (type == "trades")
+    {
+        client.watch_trades_for_symbols([&sink](const nlohmann::json &data)
+                                        { sink += data[0]["price"].get<double>(); },
+                                        symbols);
+    }
+    else
+    {
+        for (size_t i = 0; i < channels; ++i)
+        {
+            client.watch_orders([&sink](const nlohmann::json &data)
+                                { sink += data["price"].get<double>(); },
+                                "", 0, 0, {{"kind", "BENCH"}, {"currency", to_string(i)}});
+        }
+    }
+}
+
+static vector<string> split(const string &channel)
+{
+    vector<string> parts;
+    stringstream stream(channel);
+    string part;
+    while (getline(stream, part, '.'))
+    {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+// Result bucket of a recorded channel: its first segment, or the first two
+// for user.* streams. Frames that are not notifications go to "other".
+static string channel_type(const string &channel)
+{
+    auto parts = split(channel);
+    if (parts.empty())
+    {
+        return "other";
+    }
+    if (parts[0] == "user" && parts.size() > 1)
+    {
+        return "user." + parts[1];
+    }
+    return parts[0];
+}
+
+// Subscribes the same handlers as subscribe() on every recorded channel
+// that maps onto a watch_* call, mirroring tools/replay.cpp. Returns how
+// many channels got a handler.
+static size_t subscribe_recorded(Deribit &client, const set<string> &channels,
+                                 unordered_map<string, OrderBook> &books, double &sink)
+{
+    auto book_handler = [&books](const nlohmann::json &data)
+    {
+        const string &name = data["instrument_name"].get_ref<const string &>();
+        books.try_emplace(name, name).first->second.apply(data);
+    };
+
+    size_t subscribed = 0;
+    for (const auto &channel : channels)
+    {
+        auto parts = split(channel);
+        if (parts.size() == 3 && parts[0] == "ticker")
+        {
+            client.watch_ticker([&sink](const nlohmann::json &data)
+                                { sink += data.value("mark_price", 0.0); },
+                                parts[1], {{"interval", parts[2]}});
+        }
+        else if (parts.size() == 3 && parts[0] == "trades")
+        {
+            client.watch_trades([&sink](const nlohmann::json &data)
+                                { sink += data[0].value("price", 0.0); },
+                                parts[1], 0, 0, {{"interval", parts[2]}});
+        }
+        else if (parts.size() == 3 && parts[0] == "book")
+        {
+            client.watch_order_book(book_handler, parts[1], 0, {{"interval", parts[2]}});
+        }
+        else if (parts.size() == 5 && parts[0] == "book")
+        {
+            client.watch_order_book(book_handler, parts[1], 0,
+                                    {{"useDepthEndpoint", true}, {"group", parts[2]}, {"depth", parts[3]}, {"interval", parts[4]}});
+        }
+        else if (parts.size() == 5 && parts[0] == "user" && parts[1] == "orders")
+        {
+            client.watch_orders([&sink](const nlohmann::json &data)
+                                { sink += data.value("price", 0.0); },
+                                "", 0, 0, {{"kind", parts[2]}, {"currency", parts[3]}, {"interval", parts[4]}});
+        }
+        else if (parts.size() == 5 && parts[0] == "user" && parts[1] == "trades")
+        {
+            client.watch_my_trades([&sink](const nlohmann::json &data)
+                                   { sink += data[0].value("price", 0.0); },
+                                   "", {{"kind", parts[2]}, {"currency", parts[3]}, {"interval", parts[4]}});
+        }
+        else if (parts.size() == 4 && parts[0] == "user" && parts[1] == "trades")
+        {
+            client.watch_my_trades([&sink](const nlohmann::json &data)
+                                   { sink += data[0].value("price", 0.0); },
+                                   parts[2], {{"interval", parts[3]}});
+        }
+        else
+        {
+            continue;
+        }
+        subscribed++;
+    }
+    return subscribed;
+}
+
+int main(int argc, char **argv)
+{
+    size_t messages = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+    size_t max_channels = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1024;
+    string recording = argc > 3 ? argv[3] : "";
+    double sink = 0.0;
+
+    cout << "Deribit dispatch throughput (handle_message, " << messages << " messages)" << endl;
+    cout << setw(12) << "channel" << setw(10) << "channels" << setw(14) << "msgs/sec" << setw(12) << "ns/msg" << setw(14) << "allocs/msg" << endl;
+
+    for (string type : {"book", "ticker", "trades", "user.orders"})
+    {
+        for (size_t channels = 1; channels <= max_channels; channels *= 16)
+        {
+            vector<string> frames = make_frames(type, channels, messages);
+            Deribit client({{"offline", true}});
+            unordered_map<string, OrderBook> books;
+            subscribe(client, type, channels, books, sink);
+            print(type, channels, run(client, frames, channels));
+        }
+    }
+
+    if (!recording.empty())
+    {
+        // Recorded traffic with handlers on every channel it carries, run
+        // per channel type and then as the original interleaved stream
+        vector<string> frames;
+        map<string, vector<string>> frames_by_type;
+        map<string, set<string>> channels_by_type;
+        set<string> channels;
+        for (const auto &path : ReplayDriver::segments(recording))
+        {
+            FrameReader reader(path);
+            FrameRecord record;
+            while (reader.next(record))
+            {
+                if (record.direction != FrameRecorder::Inbound)
+                {
+                    continue;
+                }
+                string type = "other";
+                auto frame = nlohmann::json::parse(record.payload.begin(), record.payload.end(), nullptr, false);
+                if (frame.is_object() && frame.value("method", "") == "subscription")
+                {
+                    string channel = frame["params"].value("channel", "");
+                    type = channel_type(channel);
+                    channels_by_type[type].insert(channel);
+                    channels.insert(channel);
+                }
+                frames_by_type[type].emplace_back(record.payload);
+                frames.emplace_back(record.payload);
+            }
+        }
+
+        for (const auto &[type, type_frames] : frames_by_type)
+        {
+            Deribit client({{"offline", true}});
+            unordered_map<string, OrderBook> books;
+            size_t subscribed = subscribe_recorded(client, channels_by_type[type], books, sink);
+            print(type, subscribed, run(client, type_frames, 0));
+        }
+
+        Deribit client({{"offline", true}});
+        unordered_map<string, OrderBook> books;
+        size_t subscribed = subscribe_recorded(client, channels, books, sink);
+        print("recorded", subscribed, run(client, frames, 0));
+    }
+
+    return sink == 42.0 ? 1 : 0;
+}
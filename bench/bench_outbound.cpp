@@ -0,0 +1,243 @@
+#include "../src/include/latency_histogram.hpp"
+#include "../src/include/outbound_scheduler.hpp"
+#include "../src/include/tsc_clock.hpp"
+#include <boost/asio.hpp>
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Simulated socket: frames handed to the transport reach the wire one at a
+// time at a fixed bandwidth, like a websocket write queue in front of a
+// saturated link.
+class Wire
+{
+public:
+    Wire(double bytes_per_second, LatencyHistogram &cancels)
+        : ns_per_byte(1e9 / bytes_per_second), cancels(cancels), sender([this]()
+                                                                        { run(); })
+    {
+    }
+
+    ~Wire()
+    {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_one();
+        sender.join();
+    }
+
+    void write(string frame)
+    {
+        {
+            lock_guard<mutex> lock(mtx);
+            buffered += frame.size();
+            queue.push_back(std::move(frame));
+        }
+        cv.notify_one();
+    }
+
+    size_t backlog()
+    {
+        lock_guard<mutex> lock(mtx);
+        return buffered;
+    }
+
+    uint64_t frames() const { return sent.load(); }
+
+private:
+    double ns_per_byte;
+    LatencyHistogram &cancels;
+    mutex mtx;
+    condition_variable cv;
+    deque<string> queue;
+    size_t buffered = 0;
+    bool stopping = false;
+    atomic<uint64_t> sent{0};
+    thread sender;
+
+    void run()
+    {
+        const TscClock &clock = TscClock::instance();
+        while (true)
+        {
+            string frame;
+            {
+                unique_lock<mutex> lock(mtx);
+                cv.wait(lock, [this]()
+                        { return stopping || !queue.empty(); });
+                if (stopping)
+                {
+                    return;
+                }
+                frame = std::move(queue.front());
+                queue.pop_front();
+            }
+            uint64_t start = TscClock::ticks();
+            while (clock.to_ns(TscClock::ticks() - start) < frame.size() * ns_per_byte)
+            {
+            }
+            if (frame.find("private/cancel") != string::npos)
+            {
+                // Cancel ids carry the tick count at which they were issued
+                uint64_t issued = nlohmann::json::parse(frame)["id"].get<uint64_t>();
+                cancels.record(clock.to_ns(TscClock::ticks() - issued));
+            }
+            sent.fetch_add(1);
+            lock_guard<mutex> lock(mtx);
+            buffered -= frame.size();
+        }
+    }
+};
+
+static string query_frame(uint64_t id)
+{
+    return nlohmann::json({{"jsonrpc", "2.0"}, {"id", id}, {"method", "public/get_order_book"}, {"params", {{"instrument_name", "BTC-PERPETUAL"}, {"depth", 20}}}}).dump();
+}
+
+static string cancel_frame(uint64_t issued)
+{
+    return nlohmann::json({{"jsonrpc", "2.0"}, {"id", issued}, {"method", "private/cancel"}, {"params", {{"order_id", "USDC-123456789"}}}}).dump();
+}
+
+struct Options
+{
+    double seconds = 2.0;
+    double bandwidth = 10e6;
+    size_t producers = 4;
+    size_t max_pending = 1 << 20;
+    size_t max_backlog = 64 << 10;
+};
+
+// Producers keep up to `max_pending` bytes of queries queued while one
+// thread issues a cancel every 2ms; reports cancel issue-to-wire latency.
+static void run(bool scheduled, const Options &options)
+{
+    LatencyHistogram cancels;
+    boost::asio::io_context io;
+    auto guard = boost::asio::make_work_guard(io);
+    thread io_thread([&io]()
+                     { io.run(); });
+
+    uint64_t query_frames = 0;
+    {
+        Wire wire(options.bandwidth, cancels);
+        auto scheduler = make_shared<OutboundScheduler>(
+            [&wire](const string &frame)
+            {
+                wire.write(frame);
+                return true;
+            },
+            [&wire]()
+            { return wire.backlog(); },
+            [&io](function<void()> task, chrono::microseconds delay)
+            {
+                if (delay.count() == 0)
+                {
+                    boost::asio::post(io, std::move(task));
+                    return;
+                }
+                auto timer = make_shared<boost::asio::steady_timer>(io, delay);
+                timer->async_wait([timer, task = std::move(task)](const boost::system::error_code &ec)
+                                  {
+                    if (!ec)
+                    {
+                        task();
+                    } });
+            },
+            options.max_backlog);
+
+        size_t query_size = query_frame(0).size();
+        auto send = [&](OutboundScheduler::Priority priority, string frame)
+        {
+            if (scheduled)
+            {
+                scheduler->enqueue(priority, std::move(frame));
+            }
+            else
+            {
+                wire.write(std::move(frame));
+            }
+        };
+        auto pending = [&]()
+        {
+            return wire.backlog() + (scheduled ? scheduler->depth() * query_size : 0);
+        };
+
+        atomic<bool> stop{false};
+        vector<thread> producers;
+        for (size_t p = 0; p < options.producers; ++p)
+        {
+            producers.emplace_back([&, p]()
+                                   {
+                uint64_t id = p << 40;
+                while (!stop.load(memory_order_relaxed))
+                {
+                    if (pending() > options.max_pending)
+                    {
+                        this_thread::yield();
+                        continue;
+                    }
+                    send(OutboundScheduler::Priority::Bulk, query_frame(id++));
+                } });
+        }
+
+        uint64_t before = wire.frames();
+        auto deadline = chrono::steady_clock::now() + chrono::duration<double>(options.seconds);
+        while (chrono::steady_clock::now() < deadline)
+        {
+            send(OutboundScheduler::Priority::Urgent, cancel_frame(TscClock::ticks()));
+            this_thread::sleep_for(chrono::milliseconds(2));
+        }
+        stop = true;
+        for (auto &producer : producers)
+        {
+            producer.join();
+        }
+        // Let the queued cancels reach the wire before it shuts down
+        while (pending() > 0)
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        query_frames = wire.frames() - before;
+    }
+    guard.reset();
+    io_thread.join();
+
+    auto snapshot = cancels.snapshot();
+    cout << setw(10) << (scheduled ? "scheduled" : "direct")
+         << setw(10) << snapshot.count
+         << setw(12) << fixed << setprecision(1) << snapshot.percentile(0.5) / 1e3
+         << setw(12) << snapshot.percentile(0.99) / 1e3
+         << setw(12) << snapshot.max / 1e3
+         << setw(14) << setprecision(0) << query_frames / options.seconds << endl;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    options.seconds = argc > 1 ? atof(argv[1]) : options.seconds;
+    options.bandwidth = argc > 2 ? atof(argv[2]) * 1e6 : options.bandwidth;
+    options.producers = argc > 3 ? strtoul(argv[3], nullptr, 10) : options.producers;
+
+    cout << "Cancel latency under saturating query load (" << options.bandwidth / 1e6 << " MB/s link, "
+         << options.producers << " query threads, " << (options.max_pending >> 10) << " KiB queued)" << endl;
+    cout << setw(10) << "mode" << setw(10) << "cancels" << setw(12) << "p50 us" << setw(12) << "p99 us"
+         << setw(12) << "max us" << setw(14) << "frames/sec" << endl;
+    run(false, options);
+    run(true, options);
+    return 0;
+}
@@ -0,0 +1,223 @@
+#include "include/account_cache.hpp"
+#include <algorithm>
+#include <mutex>
+
+void AccountCache::set_markets(std::shared_ptr<const MarketRegistry> registry)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    markets = std::move(registry);
+    for (auto it = unlisted.begin(); it != unlisted.end();)
+    {
+        MarketRegistry::MarketId market = resolve(it->first);
+        if (market == MarketRegistry::npos)
+        {
+            ++it;
+            continue;
+        }
+        open_positions[market] = std::move(it->second);
+        it = unlisted.erase(it);
+    }
+}
+
+MarketRegistry::MarketId AccountCache::resolve(const std::string &instrument) const
+{
+    return markets ? markets->id(instrument) : MarketRegistry::npos;
+}
+
+const AccountCache::Position *AccountCache::find(const std::string &instrument) const
+{
+    MarketRegistry::MarketId market = resolve(instrument);
+    if (market != MarketRegistry::npos)
+    {
+        auto it = open_positions.find(market);
+        return it == open_positions.end() ? nullptr : &it->second;
+    }
+    auto it = unlisted.find(instrument);
+    return it == unlisted.end() ? nullptr : &it->second;
+}
+
+bool AccountCache::apply_balance(const nlohmann::json &summary, uint64_t since)
+{
+    if (!summary.is_object())
+    {
+        return false;
+    }
+    std::string currency = summary.value("currency", "");
+    if (currency.empty())
+    {
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    if (written(balance_versions, currency) > since)
+    {
+        return false;
+    }
+    summaries[currency] = summary;
+    balance_versions[currency] = ++current_version;
+    return true;
+}
+
+size_t AccountCache::apply_positions(const std::string &currency, const nlohmann::json &positions)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    if (!positions.is_array())
+    {
+        return store_position(currency, positions) ? 1 : 0;
+    }
+    size_t applied = 0;
+    for (const auto &position : positions)
+    {
+        applied += store_position(currency, position) ? 1 : 0;
+    }
+    return applied;
+}
+
+void AccountCache::replace_positions(const std::string &currency, const nlohmann::json &positions, uint64_t since)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    auto stale = [this, &currency, since](const auto &entry)
+    {
+        return entry.second.currency == currency && written(position_versions, entry.second.instrument) <= since;
+    };
+    std::erase_if(open_positions, stale);
+    std::erase_if(unlisted, stale);
+    for (const auto &position : positions)
+    {
+        if (position.is_object() && written(position_versions, position.value("instrument_name", "")) <= since)
+        {
+            store_position(currency, position);
+        }
+    }
+}
+
+uint64_t AccountCache::version() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return current_version;
+}
+
+uint64_t AccountCache::written(const std::unordered_map<std::string, uint64_t> &versions, const std::string &key) const
+{
+    auto it = versions.find(key);
+    return it == versions.end() ? 0 : it->second;
+}
+
+std::optional<nlohmann::json> AccountCache::balance(const std::string &currency) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    auto it = summaries.find(currency);
+    if (it == summaries.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::map<std::string, nlohmann::json> AccountCache::balances() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return std::map<std::string, nlohmann::json>(summaries.begin(), summaries.end());
+}
+
+std::optional<nlohmann::json> AccountCache::position(const std::string &instrument) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    const Position *found = find(instrument);
+    if (!found)
+    {
+        return std::nullopt;
+    }
+    return found->position;
+}
+
+std::optional<nlohmann::json> AccountCache::position(MarketRegistry::MarketId market) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    auto it = open_positions.find(market);
+    if (it == open_positions.end())
+    {
+        return std::nullopt;
+    }
+    return it->second.position;
+}
+
+std::vector<nlohmann::json> AccountCache::positions(const std::string &currency) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    std::vector<const Position *> selected;
+    for (const auto &entry : open_positions)
+    {
+        if (currency.empty() || entry.second.currency == currency)
+        {
+            selected.push_back(&entry.second);
+        }
+    }
+    for (const auto &entry : unlisted)
+    {
+        if (currency.empty() || entry.second.currency == currency)
+        {
+            selected.push_back(&entry.second);
+        }
+    }
+    std::sort(selected.begin(), selected.end(), [](const Position *a, const Position *b)
+              { return a->instrument < b->instrument; });
+
+    std::vector<nlohmann::json> result;
+    result.reserve(selected.size());
+    for (const Position *position : selected)
+    {
+        result.push_back(position->position);
+    }
+    return result;
+}
+
+size_t AccountCache::position_count() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return open_positions.size() + unlisted.size();
+}
+
+void AccountCache::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    summaries.clear();
+    open_positions.clear();
+    unlisted.clear();
+    balance_versions.clear();
+    position_versions.clear();
+}
+
+bool AccountCache::store_position(const std::string &currency, const nlohmann::json &position)
+{
+    if (!position.is_object())
+    {
+        return false;
+    }
+    std::string instrument = position.value("instrument_name", "");
+    if (instrument.empty())
+    {
+        return false;
+    }
+    MarketRegistry::MarketId market = resolve(instrument);
+    position_versions[instrument] = ++current_version;
+    if (position.value("size", 0.0) == 0.0)
+    {
+        if (market == MarketRegistry::npos)
+        {
+            unlisted.erase(instrument);
+        }
+        else
+        {
+            open_positions.erase(market);
+        }
+    }
+    else if (market == MarketRegistry::npos)
+    {
+        unlisted[instrument] = Position{instrument, currency, position};
+    }
+    else
+    {
+        open_positions[market] = Position{instrument, currency, position};
+    }
+    return true;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 class Exchange
 {
@@ -16,17 +17,36 @@ public:
     virtual nlohmann::json load_markets(bool reload = false, const nlohmann::json &params = nlohmann::json::object()) = 0;
     virtual nlohmann::json fetch_markets(const nlohmann::json &params = nlohmann::json::object()) = 0;
     virtual nlohmann::json fetch_balance(const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual nlohmann::json fetch_positions(const std::vector<std::string> &symbols = {}, const nlohmann::json &params = nlohmann::json::object()) = 0;
     virtual nlohmann::json fetch_ticker(const std::string &symbol) = 0;
     virtual nlohmann::json fetch_order_book(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) = 0;
     virtual nlohmann::json fetch_orders(const std::string &symbol, int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual nlohmann::json fetch_open_orders(const std::string &symbol = "", int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) = 0;
     virtual nlohmann::json fetch_order(const std::string &id, const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) = 0;
     virtual nlohmann::json create_order(const std::string &symbol, const std::string &type, const std::string &side, double amount, std::optional<double> price = std::nullopt, const nlohmann::json &params = nlohmann::json::object()) = 0;
     virtual nlohmann::json cancel_order(const std::string &id, const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual nlohmann::json edit_order(const std::string &id, const std::string &symbol, const std::string &type, const std::string &side, double amount, std::optional<double> price = std::nullopt, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual nlohmann::json cancel_orders(const std::vector<std::string> &ids, const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual nlohmann::json cancel_all_orders(const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) = 0;
 
+    virtual void watch_ticker(std::function<void(const nlohmann::json &)> handler, const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual void watch_trades(std::function<void(const nlohmann::json &)> handler, const std::string &symbol, int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) = 0;
     virtual void watch_orders(std::function<void(const nlohmann::json &)> handler, const std::string &symbol = "", int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) = 0;
     virtual void watch_order_book(
         std::function<void(const nlohmann::json &)> handler,
         const std::string &symbol,
         int limit = 0,
         const nlohmann::json &params = nlohmann::json::object()) = 0;
+
+    virtual void watch_tickers(std::function<void(const nlohmann::json &)> handler, const std::vector<std::string> &symbols, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual void watch_trades_for_symbols(std::function<void(const nlohmann::json &)> handler, const std::vector<std::string> &symbols, int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual void watch_order_book_for_symbols(std::function<void(const nlohmann::json &)> handler, const std::vector<std::string> &symbols, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) = 0;
+
+    virtual void unwatch_ticker(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual void unwatch_tickers(const std::vector<std::string> &symbols, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual void unwatch_trades(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual void unwatch_trades_for_symbols(const std::vector<std::string> &symbols, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual void unwatch_order_book(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual void unwatch_order_book_for_symbols(const std::vector<std::string> &symbols, const nlohmann::json &params = nlohmann::json::object()) = 0;
+    virtual void unwatch_orders(const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) = 0;
 };
@@ -0,0 +1,195 @@
+#include "include/black76.hpp"
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+    constexpr double inv_sqrt_2pi = 0.3989422804014327;
+    constexpr double min_vol = 1e-4;
+    constexpr double max_vol = 10.0;
+
+    // Cephes-style exp: Cody-Waite reduction, Pade approximant, and the
+    // 2^n scale built directly in the exponent bits.
+    inline double fast_exp(double x)
+    {
+        constexpr double log2e = 1.4426950408889634;
+        constexpr double ln2_hi = 6.93145751953125e-1;
+        constexpr double ln2_lo = 1.42860682030941723212e-6;
+        constexpr double shifter = 6755399441055744.0; // 1.5 * 2^52
+
+        x = x < -708.0 ? -708.0 : x;
+        x = x > 709.0 ? 709.0 : x;
+
+        double kd = x * log2e + shifter;
+        double n = kd - shifter;
+        uint64_t bits = std::bit_cast<uint64_t>(kd);
+        double r = x - n * ln2_hi - n * ln2_lo;
+
+        double rr = r * r;
+        double p = r * ((1.26177193074810590878e-4 * rr + 3.02994407707441961300e-2) * rr + 9.99999999999999999910e-1);
+        double q = ((3.00198505138664455042e-6 * rr + 2.52448340349684104192e-3) * rr + 2.27265548208155028766e-1) * rr + 2.0;
+        double e = 1.0 + 2.0 * p / (q - p);
+
+        double scale = std::bit_cast<double>((bits + 1023) << 52);
+        return e * scale;
+    }
+
+    inline double norm_pdf(double x)
+    {
+        return inv_sqrt_2pi * fast_exp(-0.5 * x * x);
+    }
+
+    // Hart (1968) double precision cumulative normal, both branches evaluated
+    // and selected so the loop stays vectorizable.
+    inline double cdf(double x)
+    {
+        double a = x < 0.0 ? -x : x;
+        double e = fast_exp(-0.5 * a * a);
+
+        double num = 3.52624965998911e-02 * a + 0.700383064443688;
+        num = num * a + 6.37396220353165;
+        num = num * a + 33.912866078383;
+        num = num * a + 112.079291497871;
+        num = num * a + 221.213596169931;
+        num = num * a + 220.206867912376;
+        double den = 8.83883476483184e-02 * a + 1.75566716318264;
+        den = den * a + 16.064177579207;
+        den = den * a + 86.7807322029461;
+        den = den * a + 296.564248779674;
+        den = den * a + 637.333633378831;
+        den = den * a + 793.826512519948;
+        den = den * a + 440.413735824752;
+        double near = e * num / den;
+
+        double frac = a + 0.65;
+        frac = a + 4.0 / frac;
+        frac = a + 3.0 / frac;
+        frac = a + 2.0 / frac;
+        frac = a + 1.0 / frac;
+        double far = e / frac / 2.506628274631;
+
+        double tail = a < 7.07106781186547 ? near : far;
+        tail = a > 37.0 ? 0.0 : tail;
+        return x > 0.0 ? 1.0 - tail : tail;
+    }
+
+    // Undiscounted Black-76 value and d1 for one lane.
+    inline double forward_value(double f, double k, double lnfk, double t, double sqrt_t, double s, double sigma, double &d1)
+    {
+        double sd = sigma * sqrt_t;
+        d1 = (lnfk + 0.5 * sigma * sigma * t) / sd;
+        double d2 = d1 - sd;
+        return s * (f * cdf(s * d1) - k * cdf(s * d2));
+    }
+}
+
+namespace black76
+{
+    double norm_cdf(double x)
+    {
+        return cdf(x);
+    }
+
+    void price(const Inputs &in, const double *sigma, double *__restrict out)
+    {
+        for (size_t i = 0; i < in.count; ++i)
+        {
+            double d1;
+            double value = forward_value(in.forward[i], in.strike[i], in.log_moneyness[i], in.time[i],
+                                         in.sqrt_time[i], in.sign[i], sigma[i], d1);
+            out[i] = in.discount[i] * value;
+        }
+    }
+
+    void implied_vol(const Inputs &in, const double *premium, double *sigma, int iterations)
+    {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+
+        // Lanes are solved in fixed-size blocks so every Newton/bisection
+        // step is one vectorizable pass over the block.
+        constexpr size_t block = 16;
+        double target[block], sig[block], lo[block], hi[block];
+
+        for (size_t base = 0; base < in.count; base += block)
+        {
+            size_t width = in.count - base < block ? in.count - base : block;
+            const double *__restrict f = in.forward + base;
+            const double *__restrict k = in.strike + base;
+            const double *__restrict s = in.sign + base;
+            const double *__restrict t = in.time + base;
+            const double *__restrict sqrt_t = in.sqrt_time + base;
+            const double *__restrict lnfk = in.log_moneyness + base;
+
+            for (size_t j = 0; j < width; ++j)
+            {
+                target[j] = premium[base + j] / in.discount[base + j];
+
+                // Brenner-Subrahmanyam ATM estimate unless a usable previous value exists
+                double guess = sigma[base + j];
+                bool warm = (guess > min_vol) & (guess < max_vol);
+                double initial = 2.5066282746310002 * target[j] / (f[j] * (sqrt_t[j] > 0.0 ? sqrt_t[j] : 1.0));
+                double start = warm ? guess : initial;
+                start = start > min_vol ? start : min_vol;
+                sig[j] = start < max_vol ? start : max_vol;
+                lo[j] = min_vol;
+                hi[j] = max_vol;
+            }
+
+            for (int it = 0; it < iterations; ++it)
+            {
+                for (size_t j = 0; j < width; ++j)
+                {
+                    double d1;
+                    double value = forward_value(f[j], k[j], lnfk[j], t[j], sqrt_t[j], s[j], sig[j], d1);
+                    double diff = value - target[j];
+                    bool above = diff > 0.0;
+                    double upper = above ? sig[j] : hi[j];
+                    double lower = above ? lo[j] : sig[j];
+
+                    double vega = f[j] * norm_pdf(d1) * sqrt_t[j];
+                    vega = vega > 1e-300 ? vega : 1e-300;
+                    double step = sig[j] - diff / vega;
+                    double mid = 0.5 * (lower + upper);
+                    // Newton while it stays inside the bracket, bisection otherwise
+                    bool inside = (step >= lower) & (step <= upper);
+                    sig[j] = inside ? step : mid;
+                    lo[j] = lower;
+                    hi[j] = upper;
+                }
+            }
+
+            for (size_t j = 0; j < width; ++j)
+            {
+                double intrinsic = s[j] * (f[j] - k[j]);
+                intrinsic = intrinsic > 0.0 ? intrinsic : 0.0;
+                double upper = s[j] > 0.0 ? f[j] : k[j];
+                // NaN inputs fail every comparison and end up invalid
+                bool valid = (target[j] > intrinsic) & (target[j] < upper) & (t[j] > 0.0) & (f[j] > 0.0) & (k[j] > 0.0);
+                sigma[base + j] = valid ? sig[j] : nan;
+            }
+        }
+    }
+
+    void greeks(const Inputs &in, const double *sigma, double rate,
+                double *__restrict delta, double *__restrict gamma, double *__restrict vega, double *__restrict theta)
+    {
+        for (size_t i = 0; i < in.count; ++i)
+        {
+            double f = in.forward[i];
+            double s = in.sign[i];
+            double sig = sigma[i];
+            double sqrt_t = in.sqrt_time[i];
+            double disc = in.discount[i];
+
+            double d1;
+            double value = disc * forward_value(f, in.strike[i], in.log_moneyness[i], in.time[i], sqrt_t, s, sig, d1);
+            double pdf = norm_pdf(d1);
+
+            delta[i] = disc * s * cdf(s * d1);
+            gamma[i] = disc * pdf / (f * sig * sqrt_t);
+            vega[i] = disc * f * pdf * sqrt_t / 100.0;
+            theta[i] = (rate * value - disc * f * pdf * sig / (2.0 * sqrt_t)) / 365.0;
+        }
+    }
+}
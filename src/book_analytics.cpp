@@ -0,0 +1,122 @@
+#include "include/book_analytics.hpp"
+#include <cmath>
+
+BookAnalytics::BookAnalytics(size_t imbalance_levels, double vwap_size)
+    : levels(imbalance_levels == 0 ? 1 : imbalance_levels), fill_size(vwap_size)
+{
+}
+
+void BookAnalytics::on_clear()
+{
+    bid = Window();
+    ask = Window();
+}
+
+void BookAnalytics::track(Window &window, bool is_bid, double price, double old_amount, double new_amount)
+{
+    auto at_or_better = [is_bid](double p, double boundary)
+    {
+        return is_bid ? p >= boundary : p <= boundary;
+    };
+
+    if (!window.depth_dirty)
+    {
+        bool window_full = window.depth_count >= levels;
+        if (!window_full || at_or_better(price, window.depth_boundary))
+        {
+            if (old_amount != 0.0 && new_amount != 0.0)
+            {
+                window.depth += new_amount - old_amount;
+            }
+            else
+            {
+                // A level entered or left the top N; membership must be rebuilt
+                window.depth_dirty = true;
+            }
+        }
+    }
+
+    if (!window.fill_dirty && (!window.fill_complete || at_or_better(price, window.fill_boundary)))
+    {
+        window.fill_dirty = true;
+    }
+}
+
+void BookAnalytics::on_level(bool is_bid, double price, double old_amount, double new_amount)
+{
+    track(is_bid ? bid : ask, is_bid, price, old_amount, new_amount);
+}
+
+template <typename Levels>
+void BookAnalytics::refresh(Window &window, const Levels &side)
+{
+    if (window.depth_dirty)
+    {
+        window.depth = 0.0;
+        window.depth_count = 0;
+        window.depth_boundary = 0.0;
+        for (auto it = side.begin(); it != side.end() && window.depth_count < levels; ++it)
+        {
+            window.depth += it->second;
+            window.depth_boundary = it->first;
+            window.depth_count++;
+        }
+        window.depth_dirty = false;
+    }
+
+    if (window.fill_dirty)
+    {
+        double remaining = fill_size;
+        double notional = 0.0;
+        window.fill_complete = false;
+        window.fill_boundary = 0.0;
+        for (auto it = side.begin(); it != side.end(); ++it)
+        {
+            double take = std::min(remaining, it->second);
+            notional += take * it->first;
+            remaining -= take;
+            window.fill_boundary = it->first;
+            if (remaining <= 0.0)
+            {
+                window.fill_complete = true;
+                break;
+            }
+        }
+        window.fill_vwap = window.fill_complete && fill_size > 0.0 ? notional / fill_size : NAN;
+        window.fill_dirty = false;
+    }
+}
+
+void BookAnalytics::on_update(const OrderBook &book)
+{
+    const auto &bids = book.bid_side();
+    const auto &asks = book.ask_side();
+
+    refresh(bid, bids);
+    refresh(ask, asks);
+
+    BookSignals signals;
+    if (!bids.empty())
+    {
+        signals.best_bid = bids.begin()->first;
+    }
+    if (!asks.empty())
+    {
+        signals.best_ask = asks.begin()->first;
+    }
+    if (!bids.empty() && !asks.empty())
+    {
+        double bid_size = bids.begin()->second;
+        double ask_size = asks.begin()->second;
+        signals.microprice = (signals.best_bid * ask_size + signals.best_ask * bid_size) / (bid_size + ask_size);
+    }
+
+    signals.bid_depth = bid.depth;
+    signals.ask_depth = ask.depth;
+    double total = bid.depth + ask.depth;
+    signals.imbalance = total > 0.0 ? (bid.depth - ask.depth) / total : 0.0;
+    signals.vwap_buy = ask.fill_vwap;
+    signals.vwap_sell = bid.fill_vwap;
+
+    current = signals;
+}
@@ -0,0 +1,415 @@
+#include "include/book_manager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace
+{
+    constexpr size_t virtual_nodes_per_shard = 64;
+    // How long an incremental frame may spin on the io thread for room in a
+    // full shard queue before it is dropped and the book resynced
+    constexpr auto incremental_spin = std::chrono::microseconds(5);
+
+    uint64_t fnv1a(const std::string &value)
+    {
+        uint64_t hash = 1469598103934665603ULL;
+        for (unsigned char c : value)
+        {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
+BookManager::BookManager(size_t workers, size_t queue_capacity, size_t snapshot_depth)
+    : snapshot_depth(snapshot_depth)
+{
+    if (workers == 0)
+    {
+        workers = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < workers; ++i)
+    {
+        shards.push_back(std::make_unique<Shard>(queue_capacity));
+        for (size_t v = 0; v < virtual_nodes_per_shard; ++v)
+        {
+            ring.emplace_back(fnv1a("shard-" + std::to_string(i) + "#" + std::to_string(v)), i);
+        }
+    }
+    std::sort(ring.begin(), ring.end());
+}
+
+BookManager::~BookManager()
+{
+    stop();
+}
+
+void BookManager::start()
+{
+    if (running.exchange(true))
+    {
+        return;
+    }
+    for (auto &shard : shards)
+    {
+        Shard *s = shard.get();
+        s->worker = std::thread([this, s]()
+                                { run_worker(*s); });
+    }
+}
+
+void BookManager::stop()
+{
+    if (!running.exchange(false))
+    {
+        return;
+    }
+    for (auto &shard : shards)
+    {
+        if (shard->worker.joinable())
+        {
+            shard->worker.join();
+        }
+    }
+}
+
+size_t BookManager::shard_for(const std::string &instrument) const
+{
+    uint64_t hash = fnv1a(instrument);
+    auto it = std::upper_bound(ring.begin(), ring.end(), std::make_pair(hash, size_t(0)),
+                               [](const auto &a, const auto &b)
+                               { return a.first < b.first; });
+    if (it == ring.end())
+    {
+        it = ring.begin();
+    }
+    return it->second;
+}
+
+bool BookManager::submit(const nlohmann::json &data)
+{
+    return submit(nlohmann::json(data));
+}
+
+bool BookManager::submit(nlohmann::json &&data)
+{
+    return push(std::move(data), false);
+}
+
+bool BookManager::push(nlohmann::json &&data, bool wait)
+{
+    auto name_it = data.find("instrument_name");
+    if (name_it == data.end() || !name_it->is_string())
+    {
+        return false;
+    }
+
+    const std::string &instrument = name_it->get_ref<const std::string &>();
+    Shard &shard = *shards[shard_for(instrument)];
+    shard.submitted.fetch_add(1, std::memory_order_relaxed);
+    if (shard.queue.try_push(std::move(data)))
+    {
+        return true;
+    }
+    if (wait)
+    {
+        // try_push leaves the frame in place when the queue is full
+        shard.waits.fetch_add(1, std::memory_order_relaxed);
+        auto deadline = std::chrono::steady_clock::now() + incremental_spin;
+        while (running.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline)
+        {
+            if (shard.queue.try_push(std::move(data)))
+            {
+                return true;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(shard.lost_mtx);
+            shard.lost.insert(instrument);
+        }
+        shard.has_lost.store(true, std::memory_order_release);
+    }
+    shard.dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void BookManager::set_ladder_groups(const std::vector<double> &groups)
+{
+    for (double group : groups)
+    {
+        if (!(group > 0.0))
+        {
+            throw std::invalid_argument("Ladder group must be positive");
+        }
+    }
+    ladder_groups = groups;
+}
+
+void BookManager::set_analytics(size_t imbalance_levels, double vwap_size)
+{
+    analytics_enabled = true;
+    analytics_levels = imbalance_levels;
+    analytics_vwap_size = vwap_size;
+}
+
+void BookManager::set_markets(std::shared_ptr<const MarketRegistry> registry)
+{
+    markets = std::move(registry);
+}
+
+uint64_t BookManager::key(Shard &shard, const std::string &instrument)
+{
+    MarketRegistry::MarketId market = markets ? markets->id(instrument) : MarketRegistry::npos;
+    if (market != MarketRegistry::npos)
+    {
+        return market;
+    }
+    auto it = shard.unlisted.find(instrument);
+    if (it != shard.unlisted.end())
+    {
+        return it->second;
+    }
+    std::lock_guard<std::mutex> lock(shard.slots_mtx);
+    uint64_t next = (uint64_t(1) << 32) + shard.unlisted.size();
+    shard.unlisted.emplace(instrument, next);
+    return next;
+}
+
+std::function<void(const nlohmann::json &)> BookManager::handler()
+{
+    return [this](const nlohmann::json &data)
+    {
+        // Only the incremental channel carries a type
+        push(nlohmann::json(data), data.contains("type"));
+    };
+}
+
+void BookManager::set_resync_handler(std::function<void(const std::string &)> handler)
+{
+    resync_handler = std::move(handler);
+}
+
+void BookManager::set_update_handler(std::function<void(const OrderBook &)> handler)
+{
+    update_handler = std::move(handler);
+}
+
+void BookManager::run_worker(Shard &shard)
+{
+    nlohmann::json data;
+    size_t idle = 0;
+    while (true)
+    {
+        if (shard.has_lost.load(std::memory_order_acquire))
+        {
+            resync_lost(shard);
+        }
+        if (shard.queue.try_pop(data))
+        {
+            idle = 0;
+            apply(shard, data);
+            continue;
+        }
+
+        if (!running.load(std::memory_order_acquire))
+        {
+            break;
+        }
+
+        if (++idle < 64)
+        {
+            continue;
+        }
+        if (idle < 1024)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+void BookManager::apply(Shard &shard, const nlohmann::json &data)
+{
+    const std::string &instrument = data["instrument_name"].get_ref<const std::string &>();
+    uint64_t book_key = key(shard, instrument);
+
+    auto it = shard.books.find(book_key);
+    if (it == shard.books.end())
+    {
+        auto slot = std::make_shared<BookSlot>();
+        {
+            std::lock_guard<std::mutex> lock(shard.slots_mtx);
+            shard.slots[book_key] = slot;
+        }
+        it = shard.books.emplace(book_key, BookState{OrderBook(instrument), slot, {}, nullptr}).first;
+        for (double group : ladder_groups)
+        {
+            it->second.ladders.push_back(std::make_unique<DepthLadder>(group));
+            it->second.book.add_listener(it->second.ladders.back().get());
+        }
+        if (analytics_enabled)
+        {
+            it->second.analytics = std::make_unique<BookAnalytics>(analytics_levels, analytics_vwap_size);
+            it->second.book.add_listener(it->second.analytics.get());
+        }
+    }
+
+    BookState &state = it->second;
+    uint64_t gaps_before = state.book.gaps();
+    bool applied = state.book.apply(data);
+    bool gap = state.book.gaps() != gaps_before;
+    if (applied || gap)
+    {
+        publish(state);
+        if (applied && update_handler)
+        {
+            update_handler(state.book);
+        }
+    }
+    if (gap)
+    {
+        shard.gaps.fetch_add(state.book.gaps() - gaps_before, std::memory_order_relaxed);
+        if (resync_handler)
+        {
+            resync_handler(instrument);
+        }
+    }
+    shard.processed.fetch_add(1, std::memory_order_release);
+}
+
+void BookManager::publish(BookState &state)
+{
+    auto snap = std::make_shared<BookSnapshot>(state.book.snapshot(snapshot_depth));
+    snap->ladders.reserve(state.ladders.size());
+    for (const auto &ladder : state.ladders)
+    {
+        snap->ladders.push_back(ladder->view(snapshot_depth));
+    }
+    if (state.analytics)
+    {
+        snap->signals = state.analytics->signals();
+    }
+    state.slot->latest.store(std::move(snap), std::memory_order_release);
+}
+
+void BookManager::resync_lost(Shard &shard)
+{
+    std::unordered_set<std::string> lost;
+    {
+        std::lock_guard<std::mutex> lock(shard.lost_mtx);
+        lost.swap(shard.lost);
+        shard.has_lost.store(false, std::memory_order_relaxed);
+    }
+    for (const auto &instrument : lost)
+    {
+        // A book already out of sync has its resync under way
+        auto it = shard.books.find(key(shard, instrument));
+        if (it != shard.books.end())
+        {
+            if (!it->second.book.in_sync())
+            {
+                continue;
+            }
+            it->second.book.invalidate();
+            publish(it->second);
+        }
+        shard.gaps.fetch_add(1, std::memory_order_relaxed);
+        if (resync_handler)
+        {
+            resync_handler(instrument);
+        }
+    }
+}
+
+std::shared_ptr<const BookSnapshot> BookManager::snapshot(const std::string &instrument) const
+{
+    const Shard &shard = *shards[shard_for(instrument)];
+    MarketRegistry::MarketId market = markets ? markets->id(instrument) : MarketRegistry::npos;
+    if (market != MarketRegistry::npos)
+    {
+        return snapshot(shard, market);
+    }
+    uint64_t unlisted_key;
+    {
+        std::lock_guard<std::mutex> lock(shard.slots_mtx);
+        auto it = shard.unlisted.find(instrument);
+        if (it == shard.unlisted.end())
+        {
+            return nullptr;
+        }
+        unlisted_key = it->second;
+    }
+    return snapshot(shard, unlisted_key);
+}
+
+std::shared_ptr<const BookSnapshot> BookManager::snapshot(MarketRegistry::MarketId market) const
+{
+    if (!markets || market >= markets->size())
+    {
+        return nullptr;
+    }
+    return snapshot(*shards[shard_for(std::string(markets->name(market)))], market);
+}
+
+std::shared_ptr<const BookSnapshot> BookManager::snapshot(const Shard &shard, uint64_t book_key) const
+{
+    std::shared_ptr<BookSlot> slot;
+    {
+        std::lock_guard<std::mutex> lock(shard.slots_mtx);
+        auto it = shard.slots.find(book_key);
+        if (it == shard.slots.end())
+        {
+            return nullptr;
+        }
+        slot = it->second;
+    }
+    return slot->latest.load(std::memory_order_acquire);
+}
+
+uint64_t BookManager::processed() const
+{
+    uint64_t total = 0;
+    for (const auto &shard : shards)
+    {
+        total += shard->processed.load(std::memory_order_acquire);
+    }
+    return total;
+}
+
+uint64_t BookManager::dropped() const
+{
+    uint64_t total = 0;
+    for (const auto &shard : shards)
+    {
+        total += shard->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+nlohmann::json BookManager::stats() const
+{
+    nlohmann::json result = nlohmann::json::array();
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        const Shard &shard = *shards[i];
+        size_t instruments;
+        {
+            std::lock_guard<std::mutex> lock(shard.slots_mtx);
+            instruments = shard.slots.size();
+        }
+        result.push_back({{"shard", i},
+                          {"instruments", instruments},
+                          {"queueDepth", shard.queue.size()},
+                          {"submitted", shard.submitted.load(std::memory_order_relaxed)},
+                          {"processed", shard.processed.load(std::memory_order_relaxed)},
+                          {"dropped", shard.dropped.load(std::memory_order_relaxed)},
+                          {"waits", shard.waits.load(std::memory_order_relaxed)},
+                          {"gaps", shard.gaps.load(std::memory_order_relaxed)}});
+    }
+    return result;
+}
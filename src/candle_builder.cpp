@@ -0,0 +1,165 @@
+#include "include/candle_builder.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+CandleBuilder::CandleBuilder(std::vector<int64_t> timeframes_ms, size_t history)
+    : frames(std::move(timeframes_ms)), capacity(history)
+{
+    if (frames.empty() || capacity == 0)
+    {
+        throw std::runtime_error("CandleBuilder needs at least one timeframe and a non-zero history");
+    }
+    for (int64_t frame : frames)
+    {
+        if (frame <= 0)
+        {
+            throw std::runtime_error("Invalid candle timeframe: " + std::to_string(frame));
+        }
+    }
+}
+
+void CandleBuilder::set_close_handler(CloseHandler handler)
+{
+    on_close = std::move(handler);
+}
+
+CandleBuilder::Series &CandleBuilder::series_for(const std::string &instrument)
+{
+    auto it = index.find(instrument);
+    if (it != index.end())
+    {
+        return series[it->second];
+    }
+
+    Series s;
+    s.instrument = instrument;
+    s.rings.resize(frames.size());
+    s.history.resize(frames.size() * capacity);
+    index.emplace(instrument, series.size());
+    series.push_back(std::move(s));
+    return series.back();
+}
+
+const CandleBuilder::Series *CandleBuilder::find(const std::string &instrument) const
+{
+    auto it = index.find(instrument);
+    return it == index.end() ? nullptr : &series[it->second];
+}
+
+size_t CandleBuilder::frame_index(int64_t timeframe_ms) const
+{
+    auto it = std::find(frames.begin(), frames.end(), timeframe_ms);
+    if (it == frames.end())
+    {
+        throw std::runtime_error("Unknown candle timeframe: " + std::to_string(timeframe_ms));
+    }
+    return it - frames.begin();
+}
+
+void CandleBuilder::close_bar(Series &s, size_t frame)
+{
+    Ring &ring = s.rings[frame];
+    s.history[frame * capacity + ring.head] = ring.open_bar;
+    ring.head = (ring.head + 1) % capacity;
+    ring.count = std::min(ring.count + 1, capacity);
+    ring.active = false;
+
+    if (on_close)
+    {
+        on_close(s.instrument, frames[frame], ring.open_bar);
+    }
+}
+
+void CandleBuilder::add_trade(const std::string &instrument, int64_t timestamp, double price, double amount)
+{
+    Series &s = series_for(instrument);
+    for (size_t f = 0; f < frames.size(); ++f)
+    {
+        Ring &ring = s.rings[f];
+        int64_t start = timestamp - timestamp % frames[f];
+
+        if (ring.active && start != ring.open_bar.start)
+        {
+            if (start < ring.open_bar.start)
+            {
+                late++;
+                continue;
+            }
+            close_bar(s, f);
+        }
+
+        Candle &bar = ring.open_bar;
+        if (!ring.active)
+        {
+            bar = Candle{start, price, price, price, price, 0.0, 0};
+            ring.active = true;
+        }
+        bar.high = std::max(bar.high, price);
+        bar.low = std::min(bar.low, price);
+        bar.close = price;
+        bar.volume += amount;
+        bar.trades++;
+    }
+}
+
+void CandleBuilder::on_trades(const nlohmann::json &trades)
+{
+    for (const auto &trade : trades)
+    {
+        add_trade(trade["instrument_name"].get_ref<const std::string &>(),
+                  trade["timestamp"].get<int64_t>(),
+                  trade["price"].get<double>(),
+                  trade["amount"].get<double>());
+    }
+}
+
+std::function<void(const nlohmann::json &)> CandleBuilder::handler()
+{
+    return [this](const nlohmann::json &trades)
+    {
+        on_trades(trades);
+    };
+}
+
+void CandleBuilder::flush(int64_t now_ms)
+{
+    for (auto &s : series)
+    {
+        for (size_t f = 0; f < frames.size(); ++f)
+        {
+            Ring &ring = s.rings[f];
+            if (ring.active && ring.open_bar.start + frames[f] <= now_ms)
+            {
+                close_bar(s, f);
+            }
+        }
+    }
+}
+
+std::vector<Candle> CandleBuilder::candles(const std::string &instrument, int64_t timeframe_ms, size_t limit) const
+{
+    std::vector<Candle> result;
+    size_t f = frame_index(timeframe_ms);
+    const Series *s = find(instrument);
+    if (!s)
+    {
+        return result;
+    }
+
+    const Ring &ring = s->rings[f];
+    size_t n = limit == 0 ? ring.count : std::min(limit, ring.count);
+    result.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t pos = (ring.head + capacity - n + i) % capacity;
+        result.push_back(s->history[f * capacity + pos]);
+    }
+    return result;
+}
+
+const Candle *CandleBuilder::current(const std::string &instrument, int64_t timeframe_ms) const
+{
+    size_t f = frame_index(timeframe_ms);
+    const Series *s = find(instrument);
+    return s && s->rings[f].active ? &s->rings[f].open_bar : nullptr;
+}
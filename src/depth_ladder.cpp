@@ -0,0 +1,88 @@
+#include "include/depth_ladder.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // Tolerance for prices that sit exactly on a bucket boundary but carry
+    // binary floating point error (e.g. 0.1 * 3).
+    constexpr double boundary_epsilon = 1e-9;
+
+    template <typename Buckets>
+    std::vector<BookLevel> top_buckets(const Buckets &buckets, double group, size_t depth)
+    {
+        std::vector<BookLevel> result;
+        size_t count = depth == 0 ? buckets.size() : std::min(depth, buckets.size());
+        result.reserve(count);
+        for (auto it = buckets.begin(); it != buckets.end() && result.size() < count; ++it)
+        {
+            result.push_back({it->first * group, it->second.amount});
+        }
+        return result;
+    }
+}
+
+DepthLadder::DepthLadder(double group) : group_size(group)
+{
+    if (!(group > 0.0))
+    {
+        throw std::invalid_argument("DepthLadder group must be positive");
+    }
+}
+
+int64_t DepthLadder::bucket_index(bool is_bid, double price) const
+{
+    double scaled = price / group_size;
+    return is_bid ? static_cast<int64_t>(std::floor(scaled + boundary_epsilon))
+                  : static_cast<int64_t>(std::ceil(scaled - boundary_epsilon));
+}
+
+template <typename Buckets>
+void DepthLadder::adjust(Buckets &buckets, int64_t index, double old_amount, double new_amount)
+{
+    Bucket &bucket = buckets[index];
+    bucket.amount += new_amount - old_amount;
+    if (old_amount == 0.0)
+    {
+        bucket.levels++;
+    }
+    if (new_amount == 0.0)
+    {
+        bucket.levels--;
+    }
+
+    // Drop the bucket once its last level is gone instead of trusting the
+    // accumulated sum to return to exactly zero.
+    if (bucket.levels == 0)
+    {
+        buckets.erase(index);
+    }
+}
+
+void DepthLadder::on_clear()
+{
+    bid_buckets.clear();
+    ask_buckets.clear();
+}
+
+void DepthLadder::on_level(bool is_bid, double price, double old_amount, double new_amount)
+{
+    int64_t index = bucket_index(is_bid, price);
+    if (is_bid)
+    {
+        adjust(bid_buckets, index, old_amount, new_amount);
+    }
+    else
+    {
+        adjust(ask_buckets, index, old_amount, new_amount);
+    }
+}
+
+LadderView DepthLadder::view(size_t depth) const
+{
+    LadderView result;
+    result.group = group_size;
+    result.bids = top_buckets(bid_buckets, group_size, depth);
+    result.asks = top_buckets(ask_buckets, group_size, depth);
+    return result;
+}
@@ -1,4 +1,7 @@
 #include "include/deribit.hpp"
+#include "include/metrics_server.hpp"
+#include "include/thread_pool.hpp"
+#include "include/tsc_clock.hpp"
 #include <iostream>
 #include <chrono>
 #include <thread>
@@ -7,6 +10,74 @@
 #include <sstream>
 #include <iomanip>
 #include <unordered_set>
+#include <algorithm>
+#include <optional>
+#include <boost/asio/steady_timer.hpp>
+
+namespace
+{
+    // SAX consumer that reads the top level "id" of a reply and stops at
+    // "result", so a large result is never tokenized here. Replies with
+    // the id after the result, errors and notifications yield nothing.
+    struct ReplyIdPeek
+    {
+        using json = nlohmann::json;
+
+        int depth = 0;
+        bool at_id = false;
+        std::optional<int> id;
+        bool found = false;
+
+        bool value()
+        {
+            at_id = false;
+            return depth == 1;
+        }
+        bool null() { return value(); }
+        bool boolean(bool) { return value(); }
+        bool number_integer(json::number_integer_t val)
+        {
+            if (at_id)
+            {
+                id = static_cast<int>(val);
+            }
+            return value();
+        }
+        bool number_unsigned(json::number_unsigned_t val)
+        {
+            if (at_id)
+            {
+                id = static_cast<int>(val);
+            }
+            return value();
+        }
+        bool number_float(json::number_float_t, const json::string_t &) { return value(); }
+        bool string(json::string_t &) { return value(); }
+        bool binary(json::binary_t &) { return false; }
+        bool start_object(std::size_t) { return ++depth == 1; }
+        bool end_object() { return false; }
+        bool start_array(std::size_t) { return false; }
+        bool end_array() { return false; }
+        bool key(json::string_t &name)
+        {
+            if (name == "result")
+            {
+                found = id.has_value();
+                return false;
+            }
+            at_id = name == "id";
+            return name != "error" && name != "method";
+        }
+        bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) { return false; }
+    };
+
+    std::optional<int> reply_id(std::string_view payload)
+    {
+        ReplyIdPeek peek;
+        nlohmann::json::sax_parse(payload.begin(), payload.end(), &peek);
+        return peek.found ? peek.id : std::nullopt;
+    }
+}
 
 Deribit::Deribit(const nlohmann::json &config)
 {
@@ -14,6 +85,8 @@ Deribit::Deribit(const nlohmann::json &config)
     secret = config.value("secret", "");
     password = config.value("password", "");
     is_test = config.value("is_test", true);
+    offline = config.value("offline", false);
+    subscribe_batch_size = std::max<size_t>(1, config.value("subscribe_batch_size", 500));
     url = is_test ? "wss://test.deribit.com/ws/api/v2" : "wss://www.deribit.com/ws/api/v2";
 
     client.clear_access_channels(websocketpp::log::alevel::all);
@@ -23,10 +96,292 @@ Deribit::Deribit(const nlohmann::json &config)
     client.set_message_handler(std::bind(&Deribit::on_message, this, std::placeholders::_1, std::placeholders::_2));
     client.set_fail_handler(std::bind(&Deribit::on_fail, this, std::placeholders::_1));
     client.set_close_handler(std::bind(&Deribit::on_close, this, std::placeholders::_1));
+
+    // Optional hand-off so slow handlers do not stall the io thread
+    if (config.contains("dispatch_queue"))
+    {
+        const auto &options = config["dispatch_queue"];
+        dispatch_queue = std::make_unique<DispatchQueue>(
+            [this](const std::string &channel, const nlohmann::json &data)
+            { subscriptions.dispatch(channel, data); },
+            options.value("capacity", 65536));
+        for (const auto &prefix : options.value("conflate", nlohmann::json::array({"ticker.", "quote."})))
+        {
+            dispatch_queue->set_policy(prefix.get<std::string>(), DispatchQueue::Policy::ConflateLatest);
+        }
+        dispatch_queue->set_gap_handler([this](const std::string &channel)
+                                        { resync_channel(channel); });
+        dispatch_queue->start();
+    }
+
+    if (config.contains("recorder"))
+    {
+        const auto &options = config["recorder"];
+        recorder = std::make_unique<FrameRecorder>(options.value("directory", "frames"),
+                                                   options.value("prefix", "deribit"),
+                                                   options.value("segment_size", size_t(64) << 20));
+    }
+
+    if (config.contains("rate_limit"))
+    {
+        limiter = std::make_unique<RateLimiter>(config["rate_limit"]);
+    }
+
+    if (config.contains("outbound"))
+    {
+        outbound = std::make_shared<OutboundScheduler>(
+            [this](const std::string &frame)
+            {
+                websocketpp::lib::error_code ec;
+                client.send(connection_hdl, frame, websocketpp::frame::opcode::text, ec);
+                if (ec)
+                {
+                    std::cerr << "Send failed: " << ec.message() << std::endl;
+                }
+                return !ec;
+            },
+            [this]() -> size_t
+            {
+                websocketpp::lib::error_code ec;
+                auto con = client.get_con_from_hdl(connection_hdl, ec);
+                return ec ? 0 : con->get_buffered_amount();
+            },
+            [this](std::function<void()> task, std::chrono::microseconds delay)
+            {
+                auto &io = client.get_io_service();
+                if (delay.count() == 0)
+                {
+                    io.post(std::move(task));
+                    return;
+                }
+                auto timer = std::make_shared<boost::asio::steady_timer>(io, delay);
+                timer->async_wait([timer, task = std::move(task)](const boost::system::error_code &ec)
+                                  {
+                    if (!ec)
+                    {
+                        task();
+                    } });
+            },
+            config["outbound"].value("max_backlog", size_t(64) << 10),
+            std::chrono::microseconds(config["outbound"].value("retry_delay_us", 250)));
+    }
+
+    if (config.contains("market_cache"))
+    {
+        const auto &options = config["market_cache"];
+        market_cache_path = options.value("path", "markets.bin");
+        market_cache_ttl_ms = options.value("ttl", int64_t(86400)) * 1000;
+    }
+
+    if (config.contains("metrics"))
+    {
+        const auto &options = config["metrics"];
+        metrics_server = std::make_unique<MetricsServer>([this]()
+                                                         { return metrics_text(); },
+                                                         options.value("port", 9464),
+                                                         options.value("address", "127.0.0.1"));
+    }
+}
+
+std::string Deribit::metrics_text()
+{
+    using prometheus::family;
+    using prometheus::label;
+    using prometheus::sample;
+    auto load = [](const std::atomic<uint64_t> &counter)
+    {
+        return static_cast<double>(counter.load(std::memory_order_relaxed));
+    };
+
+    std::string out;
+    family(out, "deribit_connected", "gauge", "1 while the websocket connection is open.");
+    sample(out, "deribit_connected", is_connected() ? 1 : 0);
+    family(out, "deribit_connects_total", "counter", "Websocket connections opened.");
+    sample(out, "deribit_connects_total", load(counters.connects));
+    family(out, "deribit_reconnects_total", "counter", "Connections opened after the first one.");
+    sample(out, "deribit_reconnects_total", std::max(load(counters.connects) - 1.0, 0.0));
+    family(out, "deribit_disconnects_total", "counter", "Websocket connections closed.");
+    sample(out, "deribit_disconnects_total", load(counters.disconnects));
+    family(out, "deribit_connection_failures_total", "counter", "Failed connection attempts.");
+    sample(out, "deribit_connection_failures_total", load(counters.connection_failures));
+
+    family(out, "deribit_frames_total", "counter", "Websocket frames by direction.");
+    sample(out, "deribit_frames_total", load(counters.frames_in), label("direction", "in"));
+    sample(out, "deribit_frames_total", load(counters.frames_out), label("direction", "out"));
+    family(out, "deribit_bytes_total", "counter", "Websocket payload bytes by direction.");
+    sample(out, "deribit_bytes_total", load(counters.bytes_in), label("direction", "in"));
+    sample(out, "deribit_bytes_total", load(counters.bytes_out), label("direction", "out"));
+    family(out, "deribit_message_errors_total", "counter", "Inbound frames that failed to parse or whose handler threw.");
+    sample(out, "deribit_message_errors_total", load(counters.message_errors));
+    family(out, "deribit_exchange_errors_total", "counter", "Unsolicited error frames from the exchange.");
+    sample(out, "deribit_exchange_errors_total", load(counters.exchange_errors));
+    family(out, "deribit_unrouted_messages_total", "counter", "Notifications for channels with no registration.");
+    sample(out, "deribit_unrouted_messages_total", load(counters.unrouted));
+
+    std::string messages, bytes;
+    subscriptions.visit_stats([&](const std::string &channel, const SubscriptionRegistry::ChannelStats &stats)
+                              {
+        std::string labels = label("channel", channel);
+        sample(messages, "deribit_channel_messages_total", load(stats.messages), labels);
+        sample(bytes, "deribit_channel_bytes_total", load(stats.bytes), labels); });
+    family(out, "deribit_channel_messages_total", "counter", "Notifications received per subscription channel.");
+    out += messages;
+    family(out, "deribit_channel_bytes_total", "counter", "Notification payload bytes per subscription channel.");
+    out += bytes;
+
+    family(out, "deribit_auth_refreshes_total", "counter", "Successful authentications and token refreshes.");
+    sample(out, "deribit_auth_refreshes_total", load(counters.auth_refreshes));
+    family(out, "deribit_auth_failures_total", "counter", "Failed authentication attempts.");
+    sample(out, "deribit_auth_failures_total", load(counters.auth_failures));
+
+    family(out, "deribit_rpc_in_flight", "gauge", "Requests awaiting a response.");
+    sample(out, "deribit_rpc_in_flight", rpc_metrics.in_flight());
+    family(out, "deribit_rpc_max_in_flight", "gauge", "Peak requests awaiting a response since the last reset.");
+    sample(out, "deribit_rpc_max_in_flight", rpc_metrics.max_in_flight());
+
+    std::string requests, errors, timeouts, latency, queueing;
+    rpc_metrics.visit([&](const std::string &name, const RpcMetrics::Method &method)
+                      {
+        std::string labels = label("method", name);
+        sample(requests, "deribit_rpc_requests_total", load(method.requests), labels);
+        sample(errors, "deribit_rpc_errors_total", load(method.errors), labels);
+        sample(timeouts, "deribit_rpc_timeouts_total", load(method.timeouts), labels);
+        auto snapshot = method.latency.snapshot();
+        for (double q : {0.5, 0.9, 0.99, 0.999})
+        {
+            char quantile[16];
+            std::snprintf(quantile, sizeof(quantile), "%g", q);
+            sample(latency, "deribit_rpc_latency_seconds", snapshot.percentile(q) / 1e9, labels + "," + label("quantile", quantile));
+        }
+        sample(latency, "deribit_rpc_latency_seconds_sum", snapshot.sum / 1e9, labels);
+        sample(latency, "deribit_rpc_latency_seconds_count", snapshot.count, labels);
+        auto queued = method.queueing.snapshot();
+        sample(queueing, "deribit_rpc_queueing_seconds_sum", queued.sum / 1e9, labels);
+        sample(queueing, "deribit_rpc_queueing_seconds_count", queued.count, labels); });
+    family(out, "deribit_rpc_requests_total", "counter", "JSON-RPC requests sent per method.");
+    out += requests;
+    family(out, "deribit_rpc_errors_total", "counter", "JSON-RPC error responses or send failures per method.");
+    out += errors;
+    family(out, "deribit_rpc_timeouts_total", "counter", "JSON-RPC requests that timed out per method.");
+    out += timeouts;
+    family(out, "deribit_rpc_latency_seconds", "summary", "Frame write to response latency per method.");
+    out += latency;
+    family(out, "deribit_rpc_queueing_seconds", "summary", "Time from issuing a request to writing its frame, per method.");
+    out += queueing;
+
+    if (dispatch_queue)
+    {
+        auto stats = dispatch_queue->stats();
+        family(out, "deribit_dispatch_queue_depth", "gauge", "Notifications waiting for the handler thread.");
+        sample(out, "deribit_dispatch_queue_depth", stats["depth"].get<double>());
+        family(out, "deribit_dispatch_queue_high_water", "gauge", "Deepest the dispatch queue has been.");
+        sample(out, "deribit_dispatch_queue_high_water", stats["highWater"].get<double>());
+        family(out, "deribit_dispatch_queue_dropped_total", "counter", "Notifications dropped because the queue was full.");
+        sample(out, "deribit_dispatch_queue_dropped_total", stats["dropped"].get<double>());
+        family(out, "deribit_dispatch_queue_conflated_total", "counter", "Notifications replaced by a newer one before delivery.");
+        sample(out, "deribit_dispatch_queue_conflated_total", stats["conflated"].get<double>());
+        family(out, "deribit_dispatch_queue_channel_dropped_total", "counter", "Notifications dropped per channel.");
+        for (const auto &[channel, count] : stats["droppedChannels"].items())
+        {
+            sample(out, "deribit_dispatch_queue_channel_dropped_total", count.get<double>(), label("channel", channel));
+        }
+    }
+    if (outbound)
+    {
+        auto stats = outbound->stats();
+        family(out, "deribit_outbound_queue_depth", "gauge", "Frames waiting in the outbound scheduler.");
+        sample(out, "deribit_outbound_queue_depth", stats["depth"].get<double>());
+        family(out, "deribit_outbound_frames_total", "counter", "Frames handed to the socket per priority.");
+        for (const auto &[priority, values] : stats["priorities"].items())
+        {
+            sample(out, "deribit_outbound_frames_total", values["written"].get<double>(), label("priority", priority));
+        }
+    }
+    if (limiter)
+    {
+        auto stats = limiter->stats();
+        family(out, "deribit_rate_limit_credits", "gauge", "Credits left in the local rate limit model per pool.");
+        for (const auto &[pool, values] : stats["pools"].items())
+        {
+            sample(out, "deribit_rate_limit_credits", values["credits"].get<double>(), label("pool", pool));
+        }
+        family(out, "deribit_rate_limit_delayed_total", "counter", "Requests that waited for credits per lane.");
+        for (const auto &[lane, values] : stats["lanes"].items())
+        {
+            sample(out, "deribit_rate_limit_delayed_total", values["delayed"].get<double>(), label("lane", lane));
+        }
+        family(out, "deribit_rate_limit_rejected_total", "counter", "Requests rejected for lack of credits per lane.");
+        for (const auto &[lane, values] : stats["lanes"].items())
+        {
+            sample(out, "deribit_rate_limit_rejected_total", values["rejected"].get<double>(), label("lane", lane));
+        }
+    }
+    if (recorder)
+    {
+        family(out, "deribit_recorder_frames_total", "counter", "Frames written to the frame recorder.");
+        sample(out, "deribit_recorder_frames_total", recorder->records());
+        family(out, "deribit_recorder_dropped_total", "counter", "Frames the recorder rejected.");
+        sample(out, "deribit_recorder_dropped_total", recorder->dropped());
+    }
+    return out;
+}
+
+uint16_t Deribit::metrics_port() const
+{
+    return metrics_server ? metrics_server->port() : 0;
+}
+
+nlohmann::json Deribit::rpc_stats() const
+{
+    return rpc_metrics.snapshot();
+}
+
+void Deribit::reset_rpc_stats()
+{
+    rpc_metrics.reset();
+}
+
+nlohmann::json Deribit::dispatch_stats() const
+{
+    return dispatch_queue ? dispatch_queue->stats() : nlohmann::json::object();
+}
+
+nlohmann::json Deribit::outbound_stats() const
+{
+    return outbound ? outbound->stats() : nlohmann::json::object();
+}
+
+const RateLimiter *Deribit::rate_limiter() const
+{
+    return limiter.get();
+}
+
+const OrderStore &Deribit::order_store() const
+{
+    return orders;
+}
+
+bool Deribit::order_stream_live() const
+{
+    return orders_live.load(std::memory_order_acquire);
 }
 
 Deribit::~Deribit()
 {
+    {
+        std::lock_guard<std::mutex> lock(auth_mtx);
+        auth_stopping = true;
+    }
+    auth_refresh_cv.notify_all();
+    if (auth_refresher.joinable())
+    {
+        auth_refresher.join();
+    }
+    // A refresh still waiting on get_instruments finishes or times out first
+    if (market_refresher.joinable())
+    {
+        market_refresher.join();
+    }
     if (connected)
     {
         client.close(connection_hdl, websocketpp::close::status::normal, "");
@@ -78,6 +433,8 @@ bool Deribit::is_connected()
 void Deribit::on_open(websocketpp::connection_hdl hdl)
 {
     connection_hdl = hdl;
+    connection_id++;
+    counters.connects.fetch_add(1, std::memory_order_relaxed);
     {
         std::lock_guard<std::mutex> lock(mtx);
         connected = true;
@@ -88,42 +445,127 @@ void Deribit::on_open(websocketpp::connection_hdl hdl)
 
 void Deribit::on_message(websocketpp::connection_hdl, message_ptr msg)
 {
-    std::string payload = msg->get_payload();
+    uint64_t received = TscClock::ticks();
+    const std::string &payload = msg->get_payload();
+    if (recorder)
+    {
+        recorder->record(FrameRecorder::Inbound, connection_id, payload, TscClock::instance().to_epoch_ns(received));
+    }
+    handle_message(payload);
+}
+
+void Deribit::handle_message(std::string_view payload)
+{
+    counters.frames_in.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes_in.fetch_add(payload.size(), std::memory_order_relaxed);
     try
     {
-        auto response = nlohmann::json::parse(payload);
+        // Successful replies to raw requests are handed over unparsed
+        if (raw_pending.load(std::memory_order_relaxed) > 0)
+        {
+            if (auto id = reply_id(payload))
+            {
+                std::shared_ptr<ResponseHandler> handler;
+                {
+                    std::lock_guard<std::mutex> lock(pending_requests_mutex);
+                    auto it = pending_requests.find(*id);
+                    if (it != pending_requests.end() && it->second->raw)
+                    {
+                        handler = it->second;
+                    }
+                }
+                if (handler)
+                {
+                    std::lock_guard<std::mutex> lock_handler(handler->mtx);
+                    handler->payload.assign(payload.begin(), payload.end());
+                    handler->received = true;
+                    handler->cv.notify_one();
+                    return;
+                }
+            }
+        }
+
+        auto response = nlohmann::json::parse(payload.begin(), payload.end());
 
         if (response.contains("id") && response["id"].is_number_integer())
         {
             int id = response["id"];
-            std::lock_guard<std::mutex> lock(pending_requests_mutex);
-            auto it = pending_requests.find(id);
-            if (it != pending_requests.end())
+            std::shared_ptr<ResponseHandler> handler;
+            {
+                std::lock_guard<std::mutex> lock(pending_requests_mutex);
+                auto it = pending_requests.find(id);
+                if (it != pending_requests.end())
+                {
+                    handler = it->second;
+                }
+            }
+            if (handler)
             {
-                ResponseHandler &handler = it->second;
-                std::lock_guard<std::mutex> lock_handler(handler.mtx);
-                handler.response = response;
-                handler.received = true;
-                handler.cv.notify_one();
+                std::lock_guard<std::mutex> lock_handler(handler->mtx);
+                handler->response = std::move(response);
+                handler->received = true;
+                handler->cv.notify_one();
             }
         }
         else if (response.contains("method") && response["method"] == "subscription")
         {
-            auto params = response["params"];
-            std::string channel = params["channel"];
-
-            if (subscription_handlers.find(channel) != subscription_handlers.end())
+            auto &params = response["params"];
+            const std::string &channel = params["channel"].get_ref<const std::string &>();
+            // Update the store before any handler can observe the change
+            if (channel.starts_with("user.orders."))
+            {
+                orders.apply_all(params["data"]);
+            }
+            else if (channel.starts_with("user.portfolio."))
             {
-                subscription_handlers[channel](params["data"]);
+                account.apply_balance(params["data"]);
+            }
+            else if (channel.starts_with("user.changes.") && params["data"].is_object())
+            {
+                const auto &changes = params["data"];
+                if (changes.contains("orders"))
+                {
+                    orders.apply_all(changes["orders"]);
+                }
+                if (changes.contains("trades"))
+                {
+                    record_fills(changes["trades"]);
+                }
+                for (const auto &position : changes.value("positions", nlohmann::json::array()))
+                {
+                    account.apply_positions(settle_currency(position.value("instrument_name", "")), position);
+                    fills.on_mark(position.value("instrument_name", ""), position.value("mark_price", 0.0));
+                }
+            }
+            else if (channel.starts_with("user.trades."))
+            {
+                record_fills(params["data"]);
+            }
+            else if (channel.starts_with("ticker.") && params["data"].is_object())
+            {
+                const auto &ticker = params["data"];
+                fills.on_mark(ticker.value("instrument_name", ""), ticker.value("mark_price", 0.0));
+            }
+            // One registry lookup both counts the message and, without a
+            // dispatch queue, runs the handlers
+            if (!subscriptions.route(channel, payload.size(), dispatch_queue ? nullptr : &params["data"]))
+            {
+                counters.unrouted.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (dispatch_queue)
+            {
+                dispatch_queue->push(channel, std::move(params["data"]));
             }
         }
         else if (response.contains("error"))
         {
+            counters.exchange_errors.fetch_add(1, std::memory_order_relaxed);
             std::cerr << "Deribit error: " << response["error"].dump() << std::endl;
         }
     }
     catch (const std::exception &e)
     {
+        counters.message_errors.fetch_add(1, std::memory_order_relaxed);
         std::cerr << "Failed to parse message: " << e.what() << std::endl;
     }
 }
@@ -131,6 +573,7 @@ void Deribit::on_message(websocketpp::connection_hdl, message_ptr msg)
 void Deribit::on_fail(websocketpp::connection_hdl)
 {
     std::cerr << "Connection failed" << std::endl;
+    counters.connection_failures.fetch_add(1, std::memory_order_relaxed);
     {
         std::lock_guard<std::mutex> lock(mtx);
         connected = false;
@@ -142,22 +585,120 @@ void Deribit::on_fail(websocketpp::connection_hdl)
 void Deribit::on_close(websocketpp::connection_hdl)
 {
     std::cerr << "Connection closed" << std::endl;
+    counters.disconnects.fetch_add(1, std::memory_order_relaxed);
+    // Tokens and queued frames belong to the websocket session
+    authenticated.store(false, std::memory_order_release);
+    orders_live.store(false, std::memory_order_release);
+    account_live.store(false, std::memory_order_release);
+    if (outbound)
+    {
+        outbound->clear();
+    }
     {
         std::lock_guard<std::mutex> lock(mtx);
         connected = false;
     }
     cv.notify_one();
+
+    // Replies to in-flight and dropped frames will never arrive on this
+    // connection; fail their waiters now rather than at their timeout
+    std::vector<std::shared_ptr<ResponseHandler>> orphaned;
+    {
+        std::lock_guard<std::mutex> lock(pending_requests_mutex);
+        for (auto &entry : pending_requests)
+        {
+            orphaned.push_back(std::move(entry.second));
+        }
+        pending_requests.clear();
+    }
+    for (auto &handler : orphaned)
+    {
+        fail_request(*handler, "Connection closed");
+    }
+}
+
+void Deribit::fail_request(ResponseHandler &handler, const std::string &message)
+{
+    {
+        std::lock_guard<std::mutex> lock(handler.mtx);
+        if (handler.received)
+        {
+            return;
+        }
+        handler.response = {{"id", handler.id},
+                            {"error", {{"code", -1}, {"message", message}}}};
+        handler.received = true;
+    }
+    handler.cv.notify_one();
 }
 
 void Deribit::send_request(const nlohmann::json &request)
 {
+    send_request(request, nullptr);
+}
+
+void Deribit::mark_sent(ResponseHandler &handler)
+{
+    uint64_t now = TscClock::ticks();
+    handler.sent_at.store(now, std::memory_order_release);
+    rpc_metrics.sent(*handler.stats, TscClock::instance().to_ns(now - handler.issued_at));
+}
+
+void Deribit::send_request(const nlohmann::json &request, const std::shared_ptr<ResponseHandler> &handler)
+{
+    if (offline)
+    {
+        return;
+    }
+
+    std::string method = request.value("method", "");
+    if (limiter && !limiter->acquire(method))
+    {
+        throw std::runtime_error("Rate limit: no credits for " + method);
+    }
+
     if (!is_connected())
     {
         connect();
     }
 
-    websocketpp::lib::error_code ec;
     std::string payload = request.dump();
+    if (recorder)
+    {
+        recorder->record(FrameRecorder::Outbound, connection_id, payload);
+    }
+    counters.frames_out.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes_out.fetch_add(payload.size(), std::memory_order_relaxed);
+    if (outbound)
+    {
+        std::function<void()> on_written, on_failed;
+        if (handler)
+        {
+            std::weak_ptr<ResponseHandler> weak = handler;
+            on_written = [this, weak]()
+            {
+                if (auto sent = weak.lock())
+                {
+                    mark_sent(*sent);
+                }
+            };
+            // Complete the waiter now, as the direct path throws right away
+            on_failed = [this, weak]()
+            {
+                if (auto failed = weak.lock())
+                {
+                    fail_request(*failed, "Send failed");
+                }
+            };
+        }
+        outbound->enqueue(OutboundScheduler::priority(method), std::move(payload), std::move(on_written), std::move(on_failed));
+        return;
+    }
+    if (handler)
+    {
+        mark_sent(*handler);
+    }
+    websocketpp::lib::error_code ec;
     client.send(connection_hdl, payload, websocketpp::frame::opcode::text, ec);
     if (ec)
     {
@@ -167,44 +708,81 @@ void Deribit::send_request(const nlohmann::json &request)
 
 nlohmann::json Deribit::send_request_and_wait(const nlohmann::json &request, int timeout_seconds)
 {
-    int id = request["id"];
+    return wait_response(*send_request_async(request), timeout_seconds);
+}
+
+std::shared_ptr<ResponseHandler> Deribit::send_request_async(const nlohmann::json &request, bool raw)
+{
+    if (offline)
+    {
+        throw std::runtime_error("Request " + request.value("method", "") + " needs a connection but the client is offline");
+    }
+
+    auto handler = std::make_shared<ResponseHandler>();
+    handler->id = request["id"];
+    handler->raw = raw;
+    if (raw)
+    {
+        raw_pending.fetch_add(1, std::memory_order_relaxed);
+    }
     {
         std::lock_guard<std::mutex> lock(pending_requests_mutex);
-        pending_requests.emplace(std::piecewise_construct,
-                                 std::forward_as_tuple(id),
-                                 std::forward_as_tuple());
+        pending_requests[handler->id] = handler;
     }
 
+    handler->stats = &rpc_metrics.method(request.value("method", ""));
+    rpc_metrics.start(*handler->stats);
+    handler->issued_at = TscClock::ticks();
+
     try
     {
-        send_request(request);
+        send_request(request, handler);
     }
     catch (...)
     {
+        // Never reached the exchange, so no round trip to record
+        rpc_metrics.finish(*handler->stats, 0, RpcMetrics::Outcome::Error);
+        if (raw)
+        {
+            raw_pending.fetch_sub(1, std::memory_order_relaxed);
+        }
         std::lock_guard<std::mutex> lock(pending_requests_mutex);
-        pending_requests.erase(id);
+        pending_requests.erase(handler->id);
         throw;
     }
+    return handler;
+}
+
+nlohmann::json Deribit::wait_response(ResponseHandler &handler, int timeout_seconds)
+{
+    return wait_response(handler, std::chrono::steady_clock::now() + std::chrono::seconds(timeout_seconds));
+}
 
-    auto &handler = pending_requests[id];
+nlohmann::json Deribit::wait_response(ResponseHandler &handler, std::chrono::steady_clock::time_point deadline)
+{
     std::unique_lock<std::mutex> lock(handler.mtx);
-    if (handler.cv.wait_for(lock, std::chrono::seconds(timeout_seconds),
-                            [&handler]()
-                            { return handler.received; }))
+    bool received = handler.cv.wait_until(lock, deadline,
+                                          [&handler]()
+                                          { return handler.received; });
+    // Round trip from the frame write; requests that never got written
+    // (connection closed first) fall back to when they were issued
+    uint64_t sent_at = handler.sent_at.load(std::memory_order_acquire);
+    uint64_t elapsed_ns = TscClock::instance().to_ns(TscClock::ticks() - (sent_at ? sent_at : handler.issued_at));
     {
-        nlohmann::json resp = handler.response;
-        {
-            std::lock_guard<std::mutex> lock_map(pending_requests_mutex);
-            pending_requests.erase(id);
-        }
-        return resp;
+        std::lock_guard<std::mutex> lock_map(pending_requests_mutex);
+        pending_requests.erase(handler.id);
     }
-    else
+    if (handler.raw)
     {
-        std::lock_guard<std::mutex> lock_map(pending_requests_mutex);
-        pending_requests.erase(id);
+        raw_pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (!received)
+    {
+        rpc_metrics.finish(*handler.stats, elapsed_ns, RpcMetrics::Outcome::Timeout);
         throw std::runtime_error("Request timed out");
     }
+    rpc_metrics.finish(*handler.stats, elapsed_ns, handler.response.contains("error") ? RpcMetrics::Outcome::Error : RpcMetrics::Outcome::Ok);
+    return std::move(handler.response);
 }
 
 std::string Deribit::generate_signature(const std::string &timestamp, const std::string &nonce)
@@ -228,26 +806,32 @@ std::string Deribit::generate_signature(const std::string &timestamp, const std:
 
 void Deribit::authenticate()
 {
-    std::unique_lock<std::mutex> lock(auth_mtx);
-    long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
-                        std::chrono::system_clock::now().time_since_epoch())
-                        .count();
+    if (offline || authenticated.load(std::memory_order_acquire))
+    {
+        return;
+    }
 
-    if (authenticated && now < auth_expires_at)
+    std::unique_lock<std::mutex> lock(auth_mtx);
+    if (authenticated.load(std::memory_order_relaxed))
     {
         return;
     }
 
     if (auth_in_progress)
     {
-        auth_cv.wait(lock, [this, now]()
-                     { return authenticated && now < auth_expires_at; });
+        auth_cv.wait(lock, [this]()
+                     { return !auth_in_progress; });
+        if (!authenticated.load(std::memory_order_relaxed))
+        {
+            throw std::runtime_error("Authentication failed");
+        }
         return;
     }
 
     auth_in_progress = true;
     lock.unlock();
 
+    long long now = TscClock::instance().epoch_ms();
     std::string timestamp = std::to_string(now);
     std::string nonce = timestamp;
     std::string signature = generate_signature(timestamp, nonce);
@@ -262,272 +846,448 @@ void Deribit::authenticate()
     {
         auto resp = send_request_and_wait(req, 30);
         std::unique_lock<std::mutex> auth_lock(auth_mtx);
-        if (resp.contains("result") && resp["result"].is_object())
-        {
-            auto result = resp["result"];
-            if (result.contains("access_token"))
-            {
-                access_token = result["access_token"];
-                auth_expires_at = now + result.value("expires_in", 0) * 1000;
-                authenticated = true;
-            }
-        }
-        else if (resp.contains("error"))
+        store_auth_result(resp, now);
+        auth_in_progress = false;
+        if (!auth_refresher.joinable())
         {
-            throw std::runtime_error("Authentication failed: " + resp["error"].dump());
+            auth_refresher = std::thread(&Deribit::refresh_auth_loop, this);
         }
-        auth_in_progress = false;
+        auth_refresh_cv.notify_all();
         auth_cv.notify_all();
     }
     catch (const std::exception &e)
     {
+        counters.auth_failures.fetch_add(1, std::memory_order_relaxed);
         std::unique_lock<std::mutex> auth_lock(auth_mtx);
-        authenticated = false;
+        authenticated.store(false, std::memory_order_release);
         auth_in_progress = false;
         auth_cv.notify_all();
         throw;
     }
 }
 
-std::string iso8601(int64_t timestamp)
+// Called with auth_mtx held.
+void Deribit::store_auth_result(const nlohmann::json &response, long long requested_at)
 {
-    if (timestamp < 0)
-    {
-        return "";
-    }
-
-    try
+    if (response.contains("error"))
     {
-        std::time_t seconds = timestamp / 1000;
-        int milliseconds = timestamp % 1000;
-
-        std::ostringstream oss;
-        oss << std::put_time(std::gmtime(&seconds), "%Y-%m-%dT%H:%M:%S")
-            << "." << std::setw(3) << std::setfill('0') << milliseconds
-            << "Z";
-
-        return oss.str();
+        throw std::runtime_error("Authentication failed: " + response["error"].dump());
     }
-    catch (...)
+    auto result = response.value("result", nlohmann::json::object());
+    if (!result.contains("access_token"))
     {
-        return "";
+        throw std::runtime_error("Authentication failed: no access token in " + response.dump());
     }
+    access_token = result["access_token"];
+    refresh_token = result.value("refresh_token", "");
+    auth_issued_at = requested_at;
+    auth_expires_at = requested_at + result.value("expires_in", 0) * 1000LL;
+    authenticated.store(true, std::memory_order_release);
+    counters.auth_refreshes.fetch_add(1, std::memory_order_relaxed);
 }
 
-nlohmann::json Deribit::load_markets(bool reload, const nlohmann::json &params)
+// Renews the session three quarters of the way through each token's
+// lifetime with the refresh_token grant, retrying every second on failure.
+// If the token still runs out, the flag is cleared and the next call
+// re-authenticates in full.
+void Deribit::refresh_auth_loop()
 {
-    if (!reload && !markets.empty() && !markets_by_id.empty())
+    std::unique_lock<std::mutex> lock(auth_mtx);
+    long long retry_at = 0;
+    while (!auth_stopping)
     {
-        return markets;
-    }
-
-    nlohmann::json fresh_markets = fetch_markets(params);
-
-    this->markets = fresh_markets;
-    this->markets_by_id.clear();
+        if (!authenticated.load(std::memory_order_relaxed) || refresh_token.empty())
+        {
+            auth_refresh_cv.wait(lock);
+            continue;
+        }
 
-    for (const auto &market : fresh_markets)
-    {
-        std::string id = market["id"];
-        markets_by_id[id] = market;
-    }
-    return fresh_markets;
-}
+        long long now = TscClock::instance().epoch_ms();
+        long long refresh_at = std::max(auth_issued_at + (auth_expires_at - auth_issued_at) * 3 / 4, retry_at);
+        if (now >= auth_expires_at)
+        {
+            authenticated.store(false, std::memory_order_release);
+            continue;
+        }
+        if (now < refresh_at)
+        {
+            auth_refresh_cv.wait_for(lock, std::chrono::milliseconds(std::min(refresh_at, auth_expires_at) - now));
+            continue;
+        }
 
-nlohmann::json Deribit::fetch_markets(const nlohmann::json &params)
+        nlohmann::json req = {
+            {"jsonrpc", "2.0"},
+            {"id", request_id++},
+            {"method", "public/auth"},
+            {"params", {{"grant_type", "refresh_token"}, {"refresh_token", refresh_token}}}};
+        lock.unlock();
+        try
+        {
+            auto resp = send_request_and_wait(req, 10);
+            lock.lock();
+            store_auth_result(resp, now);
+            retry_at = 0;
+        }
+        catch (const std::exception &e)
+        {
+            counters.auth_failures.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "Token refresh failed: " << e.what() << std::endl;
+            if (!lock.owns_lock())
+            {
+                lock.lock();
+            }
+            retry_at = TscClock::instance().epoch_ms() + 1000;
+        }
+    }
+}
+
+std::string iso8601(int64_t timestamp)
 {
-    nlohmann::json req = {
-        {"jsonrpc", "2.0"},
-        {"id", request_id++},
-        {"method", "public/get_instruments"},
-        {"params", {{"expired", false}}}};
+    if (timestamp < 0)
+    {
+        return "";
+    }
 
-    nlohmann::json response = send_request_and_wait(req, 30);
-    nlohmann::json instruments = response.value("result", nlohmann::json::array());
+    try
+    {
+        std::time_t seconds = timestamp / 1000;
+        int milliseconds = timestamp % 1000;
 
-    nlohmann::json result = nlohmann::json::array();
-    std::unordered_set<std::string> parsedMarkets;
+        std::ostringstream oss;
+        oss << std::put_time(std::gmtime(&seconds), "%Y-%m-%dT%H:%M:%S")
+            << "." << std::setw(3) << std::setfill('0') << milliseconds
+            << "Z";
 
-    for (auto &market : instruments)
-    {
-        std::string kind = market.value("kind", "");
-        bool isSpot = (kind == "spot");
-
-        std::string id = market.value("instrument_name", "");
-        std::string baseId = market.value("base_currency", "");
-        std::string quoteId = market.value("counter_currency", "");
-        std::string settleId = market.value("settlement_currency", "");
-        std::string base = baseId;
-        std::string quote = quoteId;
-        std::string settle = settleId;
-
-        std::string settlementPeriod = market.value("settlement_period", "");
-        bool swap = (settlementPeriod == "perpetual");
-        bool future = (!swap && kind.find("future") != std::string::npos);
-        bool option = (kind.find("option") != std::string::npos);
-        bool isComboMarket = (kind.find("combo") != std::string::npos);
-
-        long long expiry = market.value("expiration_timestamp", 0LL);
-        double strike = NAN;
-        std::string optionType;
-
-        std::string symbol = id;
-        std::string type = "swap";
-        if (future)
-            type = "future";
-        else if (option)
-            type = "option";
-        else if (isSpot)
-            type = "spot";
-
-        if (isSpot)
-        {
-            symbol = base + "/" + quote;
-        }
-        else if (!isComboMarket)
+        return oss.str();
+    }
+    catch (...)
+    {
+        return "";
+    }
+}
+
+nlohmann::json Deribit::load_markets(bool reload, const nlohmann::json &params)
+{
+    std::shared_ptr<const MarketRegistry> current = markets.load(std::memory_order_acquire);
+    if (!reload && current && !current->empty())
+    {
+        return current->to_json();
+    }
+
+    if (!reload && !current && !market_cache_path.empty())
+    {
+        int64_t saved_at = 0;
+        auto cached = MarketRegistry::load(market_cache_path, &saved_at);
+        if (cached && (offline || TscClock::instance().epoch_ms() - saved_at < market_cache_ttl_ms))
         {
-            symbol = base + "/" + quote + ":" + settle;
-            if (option || future)
+            install_markets(cached);
+            if (!offline && !market_refresher.joinable())
             {
-                symbol += "-" + std::to_string(expiry);
-                if (option)
-                {
-                    strike = market.value("strike", NAN);
-                    optionType = market.value("option_type", "");
-                    std::string letter = (optionType == "call") ? "C" : "P";
-                    symbol += "-" + std::to_string(strike) + "-" + letter;
-                }
+                market_refresher = std::thread([this, params]()
+                                               { refresh_markets(params); });
             }
+            return cached->to_json();
         }
+    }
+
+    // Ids carry over from the current registry; "merge" also keeps its
+    // markets active when the fetch no longer lists them
+    nlohmann::json fetched = fetch_markets(params);
+    auto fresh = current ? std::make_shared<const MarketRegistry>(fetched, *current, params.value("merge", false))
+                         : std::make_shared<const MarketRegistry>(fetched);
+    install_markets(fresh);
+    save_market_cache(*fresh);
+    return fresh->to_json();
+}
 
-        if (parsedMarkets.count(symbol))
+void Deribit::refresh_markets(const nlohmann::json &params)
+{
+    try
+    {
+        nlohmann::json fetched = fetch_markets(params);
+        std::shared_ptr<const MarketRegistry> current = markets.load(std::memory_order_acquire);
+        auto fresh = current ? std::make_shared<const MarketRegistry>(fetched, *current)
+                             : std::make_shared<const MarketRegistry>(fetched);
+        if (!current || current->content_hash() != fresh->content_hash())
         {
-            continue;
+            install_markets(fresh);
         }
-        parsedMarkets.insert(symbol);
-
-        double minTradeAmount = market.value("min_trade_amount", NAN);
-        double tickSize = market.value("tick_size", NAN);
-
-        nlohmann::json precision = {
-            {"amount", minTradeAmount},
-            {"price", tickSize}};
-
-        nlohmann::json limits = {
-            {"leverage", {{"min", nullptr}, {"max", nullptr}}},
-            {"amount", {{"min", minTradeAmount}, {"max", nullptr}}},
-            {"price", {{"min", tickSize}, {"max", nullptr}}},
-            {"cost", {{"min", nullptr}, {"max", nullptr}}}};
-
-        nlohmann::json parsedMarket = {
-            {"id", id},
-            {"symbol", symbol},
-            {"base", base},
-            {"quote", quote},
-            {"settle", settle},
-            {"baseId", baseId},
-            {"quoteId", quoteId},
-            {"settleId", settleId},
-            {"type", type},
-            {"spot", isSpot},
-            {"margin", false},
-            {"swap", swap},
-            {"future", future},
-            {"option", option},
-            {"active", market.value("is_active", true)},
-            {"contract", !isSpot},
-            {"linear", (settle == quote)},
-            {"inverse", (settle != quote)},
-            {"taker", market.value("taker_commission", NAN)},
-            {"maker", market.value("maker_commission", NAN)},
-            {"contractSize", market.value("contract_size", NAN)},
-            {"expiry", expiry},
-            {"expiryDatetime", expiry > 0 ? std::to_string(expiry) : ""},
-            {"strike", std::isnan(strike) ? nullptr : nlohmann::json(strike)},
-            {"optionType", optionType.empty() ? nullptr : nlohmann::json(optionType)},
-            {"precision", precision},
-            {"limits", limits},
-            {"created", market.value("creation_timestamp", 0LL)},
-            {"info", market}};
-
-        result.push_back(parsedMarket);
+        save_market_cache(*fresh);
     }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Market refresh failed: " << e.what() << std::endl;
+    }
+}
 
-    return result;
+void Deribit::install_markets(std::shared_ptr<const MarketRegistry> registry)
+{
+    markets.store(registry, std::memory_order_release);
+    orders.set_markets(registry);
+    account.set_markets(registry);
+    fills.set_markets(std::move(registry));
 }
 
-nlohmann::json Deribit::fetch_balance(const nlohmann::json &params)
+void Deribit::ensure_markets()
 {
-    authenticate();
+    // The stores key instruments by MarketId; the reply of load_markets()
+    // itself is not needed here
+    if (!offline && !markets.load(std::memory_order_acquire))
+    {
+        load_markets(false, {});
+    }
+}
 
-    std::string currencyCode = "BTC";
-    if (params.contains("code") && params["code"].is_string())
+void Deribit::save_market_cache(const MarketRegistry &registry)
+{
+    if (market_cache_path.empty())
     {
-        currencyCode = params["code"].get<std::string>();
+        return;
+    }
+    try
+    {
+        registry.save(market_cache_path, TscClock::instance().epoch_ms());
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
     }
+}
+
+std::shared_ptr<const MarketRegistry> Deribit::market_registry() const
+{
+    return markets.load(std::memory_order_acquire);
+}
 
+std::vector<std::string> Deribit::fetch_currencies()
+{
     nlohmann::json req = {
         {"jsonrpc", "2.0"},
         {"id", request_id++},
-        {"method", "private/get_account_summary"},
-        {"params", {{"currency", currencyCode}}}};
+        {"method", "public/get_currencies"},
+        {"params", nlohmann::json::object()}};
 
     nlohmann::json response = send_request_and_wait(req, 30);
-    nlohmann::json balance = response.value("result", nlohmann::json::object());
-
-    nlohmann::json result;
-    result["info"] = balance;
-
-    std::string currencyId = balance.value("currency", "");
-
-    nlohmann::json account;
-    account["free"] = balance.value("available_funds", 0.0);
-    account["used"] = balance.value("maintenance_margin", 0.0);
-    account["total"] = balance.value("equity", 0.0);
-
-    result[currencyCode] = account;
-
-    return result;
+    std::vector<std::string> currencies;
+    for (const auto &currency : response.value("result", nlohmann::json::array()))
+    {
+        std::string code = currency.value("currency", "");
+        if (!code.empty())
+        {
+            currencies.push_back(code);
+        }
+    }
+    return currencies;
 }
 
-nlohmann::json Deribit::fetch_orders(const std::string &symbol, int64_t since, int limit, const nlohmann::json &params)
+nlohmann::json Deribit::fetch_markets(const nlohmann::json &params)
 {
-    // Authenticate like other functions
-    authenticate();
-
-    // Prepare a structured JSON error response
-    nlohmann::json result;
-    result["info"] = {
-        {"error", true},
-        {"message", "Deribit exchange does not support fetch_orders function"}};
+    std::vector<std::string> currencies = params.contains("currencies")
+                                              ? params["currencies"].get<std::vector<std::string>>()
+                                              : fetch_currencies();
+    std::vector<std::string> kinds = params.value("kinds", std::vector<std::string>{"future", "option", "spot", "future_combo", "option_combo"});
+
+    // One get_instruments per currency and kind, at most max_in_flight
+    // outstanding at a time
+    struct Request
+    {
+        std::string currency;
+        std::string kind;
+        std::shared_ptr<ResponseHandler> handler;
+    };
+    std::vector<Request> requests;
+    for (const auto &currency : currencies)
+    {
+        for (const auto &kind : kinds)
+        {
+            requests.push_back({currency, kind, nullptr});
+        }
+    }
+    size_t window = std::max<size_t>(1, params.value("max_in_flight", size_t(8)));
+
+    // Replies arrive as raw text and are parsed on the pool; the whole
+    // batch shares one deadline. After a failure nothing more is sent, but
+    // every issued request is awaited before rethrowing so none is left
+    // registered.
+    ThreadPool pool(std::min<size_t>(std::max<size_t>(window, 1), std::max(1u, std::thread::hardware_concurrency())));
+    std::vector<std::future<std::vector<nlohmann::json>>> parsed;
+    std::exception_ptr failure;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    size_t sent = 0;
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        try
+        {
+            for (; !failure && sent < requests.size() && sent < i + window; ++sent)
+            {
+                nlohmann::json req = {
+                    {"jsonrpc", "2.0"},
+                    {"id", request_id++},
+                    {"method", "public/get_instruments"},
+                    {"params", {{"currency", requests[sent].currency}, {"kind", requests[sent].kind}, {"expired", false}}}};
+                requests[sent].handler = send_request_async(req, true);
+            }
+        }
+        catch (...)
+        {
+            failure = std::current_exception();
+        }
+        if (!requests[i].handler)
+        {
+            break;
+        }
 
-    // Keep fields similar to a normal fetch_orders response
-    result["orders"] = nlohmann::json::array();
-    result["symbol"] = symbol;
-    result["since"] = since;
-    result["limit"] = limit;
+        try
+        {
+            nlohmann::json response = wait_response(*requests[i].handler, deadline);
+            // A rejected request must fail the load rather than pass for a
+            // currency and kind without instruments
+            parsed.push_back(pool.submit([request = requests[i], response = std::move(response)]() mutable
+                                         {
+                if (!request.handler->payload.empty())
+                {
+                    response = nlohmann::json::parse(request.handler->payload);
+                }
+                if (response.contains("error"))
+                {
+                    throw std::runtime_error("Instruments for " + request.currency + " " + request.kind + " failed: " + response["error"].dump());
+                }
+                std::vector<nlohmann::json> markets;
+                for (const auto &instrument : response.value("result", nlohmann::json::array()))
+                {
+                    markets.push_back(parse_market(instrument));
+                }
+                return markets; }));
+        }
+        catch (...)
+        {
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+        }
+    }
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
 
+    nlohmann::json result = nlohmann::json::array();
+    std::unordered_set<std::string> parsedMarkets;
+    for (auto &batch : parsed)
+    {
+        for (auto &market : batch.get())
+        {
+            if (parsedMarkets.insert(market["symbol"].get<std::string>()).second)
+            {
+                result.push_back(std::move(market));
+            }
+        }
+    }
     return result;
 }
 
-nlohmann::json Deribit::fetch_order(const std::string &id, const std::string &symbol, const nlohmann::json &params)
+nlohmann::json Deribit::parse_market(const nlohmann::json &market)
 {
-    load_markets(false, {});
-    authenticate();
-
-    nlohmann::json req;
-    req["jsonrpc"] = "2.0";
-    req["id"] = request_id++;
-    req["method"] = "private/get_order_state";
-    req["params"] = {{"order_id", id}};
-    for (auto &el : params.items())
+    std::string kind = market.value("kind", "");
+    bool isSpot = (kind == "spot");
+
+    std::string id = market.value("instrument_name", "");
+    std::string baseId = market.value("base_currency", "");
+    std::string quoteId = market.value("counter_currency", "");
+    std::string settleId = market.value("settlement_currency", "");
+    std::string base = baseId;
+    std::string quote = quoteId;
+    std::string settle = settleId;
+
+    std::string settlementPeriod = market.value("settlement_period", "");
+    bool swap = (settlementPeriod == "perpetual");
+    bool future = (!swap && kind.find("future") != std::string::npos);
+    bool option = (kind.find("option") != std::string::npos);
+    bool isComboMarket = (kind.find("combo") != std::string::npos);
+
+    long long expiry = market.value("expiration_timestamp", 0LL);
+    double strike = NAN;
+    std::string optionType;
+
+    std::string symbol = id;
+    std::string type = "swap";
+    if (future)
+        type = "future";
+    else if (option)
+        type = "option";
+    else if (isSpot)
+        type = "spot";
+
+    if (isSpot)
     {
-        req["params"][el.key()] = el.value();
+        symbol = base + "/" + quote;
+    }
+    else if (!isComboMarket)
+    {
+        symbol = base + "/" + quote + ":" + settle;
+        if (option || future)
+        {
+            symbol += "-" + std::to_string(expiry);
+            if (option)
+            {
+                strike = market.value("strike", NAN);
+                optionType = market.value("option_type", "");
+                std::string letter = (optionType == "call") ? "C" : "P";
+                symbol += "-" + std::to_string(strike) + "-" + letter;
+            }
+        }
     }
 
-    nlohmann::json response = send_request_and_wait(req, 30);
-    nlohmann::json order = response.value("result", nlohmann::json::object());
+    double minTradeAmount = market.value("min_trade_amount", NAN);
+    double tickSize = market.value("tick_size", NAN);
+
+    nlohmann::json precision = {
+        {"amount", minTradeAmount},
+        {"price", tickSize}};
+
+    nlohmann::json limits = {
+        {"leverage", {{"min", nullptr}, {"max", nullptr}}},
+        {"amount", {{"min", minTradeAmount}, {"max", nullptr}}},
+        {"price", {{"min", tickSize}, {"max", nullptr}}},
+        {"cost", {{"min", nullptr}, {"max", nullptr}}}};
+
+    nlohmann::json parsedMarket = {
+        {"id", id},
+        {"symbol", symbol},
+        {"base", base},
+        {"quote", quote},
+        {"settle", settle},
+        {"baseId", baseId},
+        {"quoteId", quoteId},
+        {"settleId", settleId},
+        {"type", type},
+        {"spot", isSpot},
+        {"margin", false},
+        {"swap", swap},
+        {"future", future},
+        {"option", option},
+        {"active", market.value("is_active", true)},
+        {"contract", !isSpot},
+        {"linear", (settle == quote)},
+        {"inverse", (settle != quote)},
+        {"taker", market.value("taker_commission", NAN)},
+        {"maker", market.value("maker_commission", NAN)},
+        {"contractSize", market.value("contract_size", NAN)},
+        {"expiry", expiry},
+        {"expiryDatetime", expiry > 0 ? std::to_string(expiry) : ""},
+        {"strike", std::isnan(strike) ? nullptr : nlohmann::json(strike)},
+        {"optionType", optionType.empty() ? nullptr : nlohmann::json(optionType)},
+        {"precision", precision},
+        {"limits", limits},
+        {"created", market.value("creation_timestamp", 0LL)},
+        {"info", market}};
+
+    return parsedMarket;
+}
 
+nlohmann::json Deribit::parse_order(const nlohmann::json &order)
+{
     std::string marketId = order.value("instrument_name", "");
     int64_t timestamp = order.value("creation_timestamp", 0);
     int64_t lastUpdate = order.value("last_update_timestamp", 0);
@@ -593,54 +1353,453 @@ nlohmann::json Deribit::fetch_order(const std::string &id, const std::string &sy
     return parsed;
 }
 
-nlohmann::json Deribit::fetch_ticker(const std::string &symbol)
+nlohmann::json Deribit::fetch_balance(const nlohmann::json &params)
 {
-    nlohmann::json req = {
-        {"jsonrpc", "2.0"},
-        {"id", request_id++},
-        {"method", "public/ticker"},
-        {"params", {{"instrument_name", symbol}}}};
+    std::string currencyCode;
+    if (params.contains("code") && params["code"].is_string())
+    {
+        currencyCode = params["code"].get<std::string>();
+    }
 
-    nlohmann::json response = send_request_and_wait(req, 30);
-    nlohmann::json ticker = response.value("result", nlohmann::json::object());
+    std::map<std::string, nlohmann::json> summaries;
+    bool cached = account_live.load(std::memory_order_acquire);
+    if (cached)
+    {
+        summaries = account.balances();
+        if (!currencyCode.empty())
+        {
+            auto it = summaries.find(currencyCode);
+            cached = it != summaries.end();
+            summaries = cached ? std::map<std::string, nlohmann::json>{*it} : std::map<std::string, nlohmann::json>{};
+        }
+    }
+    if (!cached)
+    {
+        authenticate();
+        load_account(currencyCode.empty() ? fetch_currencies() : std::vector<std::string>{currencyCode}, true, false);
+        summaries = account.balances();
+        if (!currencyCode.empty())
+        {
+            auto balance = account.balance(currencyCode);
+            summaries = balance ? std::map<std::string, nlohmann::json>{{currencyCode, *balance}} : std::map<std::string, nlohmann::json>{};
+        }
+    }
 
-    int64_t timestamp = 0;
-    if (ticker.contains("timestamp") && ticker["timestamp"].is_number_integer())
-        timestamp = ticker["timestamp"].get<int64_t>();
-    else if (ticker.contains("creation_timestamp") && ticker["creation_timestamp"].is_number_integer())
-        timestamp = ticker["creation_timestamp"].get<int64_t>();
+    nlohmann::json result;
+    result["info"] = nlohmann::json::object();
+    for (const auto &[code, balance] : summaries)
+    {
+        nlohmann::json account_json;
+        account_json["free"] = balance.value("available_funds", 0.0);
+        account_json["used"] = balance.value("maintenance_margin", 0.0);
+        account_json["total"] = balance.value("equity", 0.0);
+        result[code] = account_json;
+        result["info"][code] = balance;
+    }
+    // A single currency keeps the raw summary as info
+    if (!currencyCode.empty())
+    {
+        result["info"] = result["info"].value(currencyCode, nlohmann::json::object());
+    }
 
-    std::string last;
-    if (ticker.contains("last_price") && !ticker["last_price"].is_null())
-        last = std::to_string(ticker["last_price"].get<double>());
-    else if (ticker.contains("last") && !ticker["last"].is_null())
-        last = std::to_string(ticker["last"].get<double>());
+    return result;
+}
 
-    nlohmann::json stats = ticker.contains("stats") && ticker["stats"].is_object()
-                               ? ticker["stats"]
-                               : ticker;
+nlohmann::json Deribit::fetch_positions(const std::vector<std::string> &symbols, const nlohmann::json &params)
+{
+    std::string currency = params.value("currency", "");
+    if (!account_live.load(std::memory_order_acquire))
+    {
+        authenticate();
+        std::vector<std::string> currencies;
+        if (!currency.empty())
+        {
+            currencies.push_back(currency);
+        }
+        else if (!symbols.empty())
+        {
+            for (const auto &symbol : symbols)
+            {
+                std::string settle = settle_currency(symbol);
+                if (std::find(currencies.begin(), currencies.end(), settle) == currencies.end())
+                {
+                    currencies.push_back(settle);
+                }
+            }
+        }
+        else
+        {
+            currencies = fetch_currencies();
+        }
+        load_account(currencies, false, true);
+    }
 
-    std::string high;
-    if (stats.contains("high") && !stats["high"].is_null())
-        high = std::to_string(stats["high"].get<double>());
-    else if (stats.contains("max_price") && !stats["max_price"].is_null())
-        high = std::to_string(stats["max_price"].get<double>());
+    nlohmann::json result = nlohmann::json::array();
+    for (const auto &position : account.positions(currency))
+    {
+        std::string instrument = position.value("instrument_name", "");
+        if (symbols.empty() || std::find(symbols.begin(), symbols.end(), instrument) != symbols.end())
+        {
+            result.push_back(parse_position(position));
+        }
+    }
+    return result;
+}
 
-    std::string low;
-    if (stats.contains("low") && !stats["low"].is_null())
-        low = std::to_string(stats["low"].get<double>());
-    else if (stats.contains("min_price") && !stats["min_price"].is_null())
-        low = std::to_string(stats["min_price"].get<double>());
+nlohmann::json Deribit::parse_position(const nlohmann::json &position)
+{
+    std::string direction = position.value("direction", "");
+    double size = position.value("size", 0.0);
 
-    std::string bid;
-    if (ticker.contains("best_bid_price") && !ticker["best_bid_price"].is_null())
-        bid = std::to_string(ticker["best_bid_price"].get<double>());
-    else if (ticker.contains("bid_price") && !ticker["bid_price"].is_null())
-        bid = std::to_string(ticker["bid_price"].get<double>());
+    nlohmann::json parsed;
+    parsed["info"] = position;
+    parsed["symbol"] = position.value("instrument_name", "");
+    parsed["side"] = direction == "buy" ? nlohmann::json("long") : direction == "sell" ? nlohmann::json("short") : nlohmann::json();
+    parsed["contracts"] = std::abs(size);
+    parsed["notional"] = position.contains("size_currency") ? nlohmann::json(std::abs(position.value("size_currency", 0.0))) : nlohmann::json();
+    parsed["entryPrice"] = position.contains("average_price") ? position["average_price"] : nlohmann::json();
+    parsed["markPrice"] = position.contains("mark_price") ? position["mark_price"] : nlohmann::json();
+    parsed["liquidationPrice"] = position.contains("estimated_liquidation_price") ? position["estimated_liquidation_price"] : nlohmann::json();
+    parsed["unrealizedPnl"] = position.contains("floating_profit_loss") ? position["floating_profit_loss"] : nlohmann::json();
+    parsed["realizedPnl"] = position.contains("realized_profit_loss") ? position["realized_profit_loss"] : nlohmann::json();
+    parsed["initialMargin"] = position.contains("initial_margin") ? position["initial_margin"] : nlohmann::json();
+    parsed["maintenanceMargin"] = position.contains("maintenance_margin") ? position["maintenance_margin"] : nlohmann::json();
+    parsed["leverage"] = position.contains("leverage") ? position["leverage"] : nlohmann::json();
+    parsed["delta"] = position.contains("delta") ? position["delta"] : nlohmann::json();
+    return parsed;
+}
 
-    std::string ask;
-    if (ticker.contains("best_ask_price") && !ticker["best_ask_price"].is_null())
-        ask = std::to_string(ticker["best_ask_price"].get<double>());
+std::string Deribit::settle_currency(const std::string &instrument) const
+{
+    if (auto registry = markets.load(std::memory_order_acquire))
+    {
+        MarketRegistry::MarketId id = registry->id(instrument);
+        if (id != MarketRegistry::npos)
+        {
+            return registry->currency((*registry)[id].settle);
+        }
+    }
+    // BTC-PERPETUAL settles in BTC, BTC_USDC-PERPETUAL in USDC
+    std::string underlying = instrument.substr(0, instrument.find('-'));
+    size_t quote = underlying.find('_');
+    return quote == std::string::npos ? underlying : underlying.substr(quote + 1);
+}
+
+void Deribit::load_account(const std::vector<std::string> &currencies, bool balances, bool positions)
+{
+    // Every summary and position request goes out before the first wait.
+    // Replies are applied here, not on the io thread, so stream updates
+    // written after `since` win over the older snapshot.
+    uint64_t since = account.version();
+    struct Pending
+    {
+        std::string currency;
+        bool positions;
+        std::shared_ptr<ResponseHandler> handler;
+    };
+    std::vector<Pending> pending;
+    std::exception_ptr failure;
+    try
+    {
+        for (const auto &currency : currencies)
+        {
+            if (balances)
+            {
+                nlohmann::json req = {
+                    {"jsonrpc", "2.0"},
+                    {"id", request_id++},
+                    {"method", "private/get_account_summary"},
+                    {"params", {{"currency", currency}}}};
+                pending.push_back({currency, false, send_request_async(req)});
+            }
+            if (positions)
+            {
+                nlohmann::json req = {
+                    {"jsonrpc", "2.0"},
+                    {"id", request_id++},
+                    {"method", "private/get_positions"},
+                    {"params", {{"currency", currency}}}};
+                pending.push_back({currency, true, send_request_async(req)});
+            }
+        }
+    }
+    catch (...)
+    {
+        failure = std::current_exception();
+    }
+
+    for (auto &request : pending)
+    {
+        try
+        {
+            nlohmann::json response = wait_response(*request.handler, 30);
+            if (response.contains("error"))
+            {
+                throw std::runtime_error("Account snapshot for " + request.currency + " failed: " + response["error"].dump());
+            }
+            if (request.positions)
+            {
+                account.replace_positions(request.currency, response.value("result", nlohmann::json::array()), since);
+            }
+            else
+            {
+                account.apply_balance(response.value("result", nlohmann::json::object()), since);
+            }
+        }
+        catch (...)
+        {
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+        }
+    }
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+void Deribit::watch_account(const nlohmann::json &params)
+{
+    authenticate();
+    ensure_markets();
+    std::vector<std::string> currencies = params.contains("currencies")
+                                              ? params["currencies"].get<std::vector<std::string>>()
+                                              : fetch_currencies();
+
+    std::vector<std::string> channels;
+    for (const auto &currency : currencies)
+    {
+        std::string lower = currency;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        channels.push_back("user.portfolio." + lower);
+    }
+    channels.push_back("user.changes.any.any." + params.value("interval", "raw"));
+
+    // The cache is fed in handle_message; the registration only keeps the
+    // channels subscribed. Snapshots are taken after subscribing so no
+    // change falls between the two.
+    subscribe("private/subscribe", channels, [](const nlohmann::json &) {});
+    load_account(currencies, true, true);
+    account_channels = channels;
+    account_live.store(true, std::memory_order_release);
+}
+
+void Deribit::unwatch_account()
+{
+    account_live.store(false, std::memory_order_release);
+    if (!account_channels.empty())
+    {
+        unsubscribe("private/unsubscribe", account_channels);
+        account_channels.clear();
+    }
+}
+
+const FillLedger &Deribit::fill_ledger() const
+{
+    return fills;
+}
+
+void Deribit::record_fills(const nlohmann::json &trades)
+{
+    if (!trades.is_array())
+    {
+        return;
+    }
+    for (const auto &trade : trades)
+    {
+        fills.on_trade(trade);
+    }
+}
+
+void Deribit::watch_my_trades(std::function<void(const nlohmann::json &)> handler, const std::string &symbol, const nlohmann::json &params)
+{
+    authenticate();
+    ensure_markets();
+    std::string interval = params.value("interval", "raw");
+    std::string channel = symbol.empty()
+                              ? "user.trades." + params.value("kind", "any") + "." + params.value("currency", "any") + "." + interval
+                              : "user.trades." + symbol + "." + interval;
+    subscribe("private/subscribe", {channel}, handler);
+}
+
+const AccountCache &Deribit::account_cache() const
+{
+    return account;
+}
+
+bool Deribit::account_stream_live() const
+{
+    return account_live.load(std::memory_order_acquire);
+}
+
+nlohmann::json Deribit::fetch_orders(const std::string &symbol, int64_t since, int limit, const nlohmann::json &params)
+{
+    // Authenticate like other functions
+    authenticate();
+
+    // Prepare a structured JSON error response
+    nlohmann::json result;
+    result["info"] = {
+        {"error", true},
+        {"message", "Deribit exchange does not support fetch_orders function"}};
+
+    // Keep fields similar to a normal fetch_orders response
+    result["orders"] = nlohmann::json::array();
+    result["symbol"] = symbol;
+    result["since"] = since;
+    result["limit"] = limit;
+
+    return result;
+}
+
+nlohmann::json Deribit::fetch_order(const std::string &id, const std::string &symbol, const nlohmann::json &params)
+{
+    if (orders_live.load(std::memory_order_acquire))
+    {
+        if (auto order = orders.find(id))
+        {
+            return parse_order(*order);
+        }
+    }
+
+    ensure_markets();
+    authenticate();
+
+    nlohmann::json req;
+    req["jsonrpc"] = "2.0";
+    req["id"] = request_id++;
+    req["method"] = "private/get_order_state";
+    req["params"] = {{"order_id", id}};
+    for (auto &el : params.items())
+    {
+        req["params"][el.key()] = el.value();
+    }
+
+    nlohmann::json response = send_request_and_wait(req, 30);
+    if (response.contains("error"))
+        throw std::runtime_error("fetch_order " + id + " failed: " + response["error"].dump());
+    nlohmann::json order = response.value("result", nlohmann::json::object());
+    orders.apply(order);
+    return parse_order(order);
+}
+
+nlohmann::json Deribit::fetch_open_orders(const std::string &symbol, int64_t since, int limit, const nlohmann::json &params)
+{
+    std::vector<nlohmann::json> open;
+    if (orders_live.load(std::memory_order_acquire))
+    {
+        open = orders.open(symbol);
+    }
+    else
+    {
+        authenticate();
+        nlohmann::json req;
+        req["jsonrpc"] = "2.0";
+        req["id"] = request_id++;
+        req["method"] = symbol.empty() ? "private/get_open_orders" : "private/get_open_orders_by_instrument";
+        req["params"] = nlohmann::json::object();
+        if (!symbol.empty())
+            req["params"]["instrument_name"] = symbol;
+        for (auto &el : params.items())
+        {
+            req["params"][el.key()] = el.value();
+        }
+
+        nlohmann::json response = send_request_and_wait(req, 30);
+        if (response.contains("error"))
+            throw std::runtime_error("fetch_open_orders failed: " + response["error"].dump());
+        for (const auto &order : response.value("result", nlohmann::json::array()))
+        {
+            orders.apply(order);
+            open.push_back(order);
+        }
+    }
+
+    std::sort(open.begin(), open.end(), [](const nlohmann::json &a, const nlohmann::json &b)
+              { return a.value("creation_timestamp", int64_t(0)) < b.value("creation_timestamp", int64_t(0)); });
+    nlohmann::json result = nlohmann::json::array();
+    for (const auto &order : open)
+    {
+        if (order.value("creation_timestamp", int64_t(0)) < since)
+            continue;
+        if (limit > 0 && result.size() >= static_cast<size_t>(limit))
+            break;
+        result.push_back(parse_order(order));
+    }
+    return result;
+}
+
+void Deribit::seed_orders()
+{
+    // Subscribed first, so anything that changes while the snapshot is in
+    // flight arrives on the stream; apply() drops the older of the two.
+    // Stored open orders the snapshot leaves out closed while nothing was
+    // streaming (acks only, or before a disconnect) and are dropped; this
+    // runs on every re-seed after the stream was lost.
+    uint64_t since = orders.version();
+    nlohmann::json req;
+    req["jsonrpc"] = "2.0";
+    req["id"] = request_id++;
+    req["method"] = "private/get_open_orders";
+    req["params"] = nlohmann::json::object();
+
+    nlohmann::json response = send_request_and_wait(req, 30);
+    if (response.contains("error"))
+        throw std::runtime_error("Open orders snapshot failed: " + response["error"].dump());
+    orders.reconcile(response.value("result", nlohmann::json::array()), since);
+    orders_live.store(true, std::memory_order_release);
+}
+
+nlohmann::json Deribit::fetch_ticker(const std::string &symbol)
+{
+    nlohmann::json req = {
+        {"jsonrpc", "2.0"},
+        {"id", request_id++},
+        {"method", "public/ticker"},
+        {"params", {{"instrument_name", symbol}}}};
+
+    nlohmann::json response = send_request_and_wait(req, 30);
+    nlohmann::json ticker = response.value("result", nlohmann::json::object());
+
+    int64_t timestamp = 0;
+    if (ticker.contains("timestamp") && ticker["timestamp"].is_number_integer())
+        timestamp = ticker["timestamp"].get<int64_t>();
+    else if (ticker.contains("creation_timestamp") && ticker["creation_timestamp"].is_number_integer())
+        timestamp = ticker["creation_timestamp"].get<int64_t>();
+
+    std::string last;
+    if (ticker.contains("last_price") && !ticker["last_price"].is_null())
+        last = std::to_string(ticker["last_price"].get<double>());
+    else if (ticker.contains("last") && !ticker["last"].is_null())
+        last = std::to_string(ticker["last"].get<double>());
+
+    nlohmann::json stats = ticker.contains("stats") && ticker["stats"].is_object()
+                               ? ticker["stats"]
+                               : ticker;
+
+    std::string high;
+    if (stats.contains("high") && !stats["high"].is_null())
+        high = std::to_string(stats["high"].get<double>());
+    else if (stats.contains("max_price") && !stats["max_price"].is_null())
+        high = std::to_string(stats["max_price"].get<double>());
+
+    std::string low;
+    if (stats.contains("low") && !stats["low"].is_null())
+        low = std::to_string(stats["low"].get<double>());
+    else if (stats.contains("min_price") && !stats["min_price"].is_null())
+        low = std::to_string(stats["min_price"].get<double>());
+
+    std::string bid;
+    if (ticker.contains("best_bid_price") && !ticker["best_bid_price"].is_null())
+        bid = std::to_string(ticker["best_bid_price"].get<double>());
+    else if (ticker.contains("bid_price") && !ticker["bid_price"].is_null())
+        bid = std::to_string(ticker["bid_price"].get<double>());
+
+    std::string ask;
+    if (ticker.contains("best_ask_price") && !ticker["best_ask_price"].is_null())
+        ask = std::to_string(ticker["best_ask_price"].get<double>());
     else if (ticker.contains("ask_price") && !ticker["ask_price"].is_null())
         ask = std::to_string(ticker["ask_price"].get<double>());
 
@@ -764,6 +1923,7 @@ nlohmann::json Deribit::fetch_order_book(const std::string &symbol, const nlohma
 
 nlohmann::json Deribit::create_order(const std::string &symbol, const std::string &type, const std::string &side, double amount, std::optional<double> price, const nlohmann::json &params)
 {
+    ensure_markets();
     authenticate();
     nlohmann::json req;
     req["jsonrpc"] = "2.0";
@@ -833,69 +1993,22 @@ nlohmann::json Deribit::create_order(const std::string &symbol, const std::strin
 
     req["params"] = order_params;
     nlohmann::json response = send_request_and_wait(req, 30);
-
-    nlohmann::json order = response["result"]["order"];
-    nlohmann::json trades = response["result"].contains("trades") ? response["result"]["trades"] : nlohmann::json::array();
-    std::string marketId = order.value("instrument_name", "");
-    int64_t timestamp = order.value("creation_timestamp", 0);
-    int64_t lastUpdate = order.value("last_update_timestamp", 0);
-    std::string id = order.value("order_id", "");
-    std::string priceString = order.contains("price") && !order["price"].is_null() ? order["price"].dump() : "";
-    if (priceString == "\"market_price\"")
-        priceString.clear();
-    std::string averageString = order.contains("average_price") && !order["average_price"].is_null() ? order["average_price"].dump() : "";
-    std::string filledString = order.contains("filled_amount") && !order["filled_amount"].is_null() ? order["filled_amount"].dump() : "";
-    std::string amountString = order.contains("amount") && !order["amount"].is_null() ? order["amount"].dump() : "";
-    std::string cost;
-    if (!filledString.empty() && !averageString.empty())
-        cost = std::to_string(std::stod(filledString) * std::stod(averageString));
-    int64_t lastTradeTimestamp = 0;
-    if (!filledString.empty() && std::stod(filledString) > 0)
-        lastTradeTimestamp = lastUpdate;
-    std::string status = order.value("order_state", "");
-    std::string sideParsed = order.value("direction", "");
-    std::string feeCostString = order.contains("commission") && !order["commission"].is_null() ? order["commission"].dump() : "";
-    nlohmann::json fee = nlohmann::json();
-    if (!feeCostString.empty())
-    {
-        fee["cost"] = std::abs(std::stod(feeCostString));
-        fee["currency"] = "";
-    }
-    std::string rawType = order.value("order_type", "");
-    std::string timeInForceParsed = order.value("time_in_force", "");
-    auto stopPrice = order.contains("stop_price") ? order["stop_price"] : nlohmann::json();
-    bool postOnlyParsed = order.value("post_only", false);
-
-    nlohmann::json parsed;
-    parsed["info"] = order;
-    parsed["id"] = id;
-    parsed["clientOrderId"] = nlohmann::json();
-    parsed["timestamp"] = timestamp;
-    parsed["datetime"] = timestamp ? nlohmann::json(iso8601(timestamp)) : nlohmann::json();
-    parsed["lastTradeTimestamp"] = lastTradeTimestamp ? nlohmann::json(lastTradeTimestamp) : nlohmann::json();
-    parsed["symbol"] = marketId;
-    parsed["type"] = rawType;
-    parsed["timeInForce"] = timeInForceParsed;
-    parsed["postOnly"] = postOnlyParsed;
-    parsed["side"] = sideParsed;
-    parsed["price"] = priceString.empty() ? nlohmann::json() : nlohmann::json(priceString);
-    parsed["stopPrice"] = stopPrice.is_null() ? nlohmann::json() : stopPrice;
-    parsed["triggerPrice"] = stopPrice.is_null() ? nlohmann::json() : stopPrice;
-    parsed["amount"] = amountString.empty() ? nlohmann::json() : nlohmann::json(amountString);
-    parsed["cost"] = cost.empty() ? nlohmann::json() : nlohmann::json(cost);
-    parsed["average"] = averageString.empty() ? nlohmann::json() : nlohmann::json(averageString);
-    parsed["filled"] = filledString.empty() ? nlohmann::json() : nlohmann::json(filledString);
-    parsed["remaining"] = nlohmann::json();
-    parsed["status"] = status;
-    parsed["fee"] = fee.is_null() ? nlohmann::json() : fee;
-    parsed["trades"] = trades;
-
+    if (response.contains("error"))
+        throw std::runtime_error("create_order on " + symbol + " failed: " + response["error"].dump());
+
+    nlohmann::json result = response.value("result", nlohmann::json::object());
+    nlohmann::json order = result.value("order", nlohmann::json::object());
+    orders.apply(order);
+    nlohmann::json parsed = parse_order(order);
+    parsed["stopPrice"] = parsed["triggerPrice"];
+    parsed["trades"] = result.value("trades", nlohmann::json::array());
+    record_fills(parsed["trades"]);
     return parsed;
 }
 
 nlohmann::json Deribit::cancel_order(const std::string &id, const std::string &symbol, const nlohmann::json &params)
 {
-    load_markets(false, {});
+    ensure_markets();
 
     authenticate();
     nlohmann::json req;
@@ -909,84 +2022,243 @@ nlohmann::json Deribit::cancel_order(const std::string &id, const std::string &s
     }
 
     nlohmann::json response = send_request_and_wait(req, 30);
+    if (response.contains("error"))
+        throw std::runtime_error("cancel_order " + id + " failed: " + response["error"].dump());
     nlohmann::json order = response.value("result", nlohmann::json::object());
+    orders.apply(order);
+    return parse_order(order);
+}
 
-    std::string marketId = order.value("instrument_name", "");
-    int64_t timestamp = order.value("creation_timestamp", 0);
-    int64_t lastUpdate = order.value("last_update_timestamp", 0);
-    std::string orderId = order.value("order_id", "");
-    std::string priceString = order.contains("price") && !order["price"].is_null() ? order["price"].dump() : "";
-    if (priceString == "\"market_price\"")
-        priceString.clear();
-    std::string averageString = order.contains("average_price") && !order["average_price"].is_null() ? order["average_price"].dump() : "";
-    std::string filledString = order.contains("filled_amount") && !order["filled_amount"].is_null() ? order["filled_amount"].dump() : "";
-    std::string amountString = order.contains("amount") && !order["amount"].is_null() ? order["amount"].dump() : "";
-    std::string cost;
-    if (!filledString.empty() && !averageString.empty())
-        cost = std::to_string(std::stod(filledString) * std::stod(averageString));
-    int64_t lastTradeTimestamp = 0;
-    if (!filledString.empty() && std::stod(filledString) > 0)
-        lastTradeTimestamp = lastUpdate;
-    std::string status = order.value("order_state", "");
-    std::string side = order.value("direction", "");
-    std::string feeCostString = order.contains("commission") && !order["commission"].is_null() ? order["commission"].dump() : "";
-    nlohmann::json fee = nlohmann::json();
-    if (!feeCostString.empty())
+nlohmann::json Deribit::edit_order(const std::string &id, const std::string &symbol, const std::string &type, const std::string &side, double amount, std::optional<double> price, const nlohmann::json &params)
+{
+    authenticate();
+    nlohmann::json req;
+    req["jsonrpc"] = "2.0";
+    req["id"] = request_id++;
+    req["method"] = "private/edit";
+
+    nlohmann::json order_params;
+    order_params["order_id"] = id;
+    order_params["amount"] = amount;
+    if (price.has_value())
+        order_params["price"] = price.value();
+
+    auto triggerPriceIt = params.find("triggerPrice");
+    if (triggerPriceIt != params.end() && !triggerPriceIt->is_null())
+        order_params["trigger_price"] = triggerPriceIt->get<double>();
+    if (params.value("reduceOnly", false))
+        order_params["reduce_only"] = true;
+    if (params.value("postOnly", false))
     {
-        fee["cost"] = std::abs(std::stod(feeCostString));
-        fee["currency"] = "";
+        order_params["post_only"] = true;
+        order_params["reject_post_only"] = true;
     }
-    std::string rawType = order.value("order_type", "");
-    std::string timeInForceParsed = order.value("time_in_force", "");
-    auto stopPrice = order.contains("stop_price") ? order["stop_price"] : nlohmann::json();
-    bool postOnlyParsed = order.value("post_only", false);
-    nlohmann::json trades = order.contains("trades") ? order["trades"] : nlohmann::json::array();
-
-    nlohmann::json parsed;
-    parsed["info"] = order;
-    parsed["id"] = orderId;
-    parsed["clientOrderId"] = nlohmann::json();
-    parsed["timestamp"] = timestamp;
-    parsed["datetime"] = timestamp ? nlohmann::json(iso8601(timestamp)) : nlohmann::json();
-    parsed["lastTradeTimestamp"] = lastTradeTimestamp ? nlohmann::json(lastTradeTimestamp) : nlohmann::json();
-    parsed["symbol"] = marketId;
-    parsed["type"] = rawType;
-    parsed["timeInForce"] = timeInForceParsed;
-    parsed["postOnly"] = postOnlyParsed;
-    parsed["side"] = side;
-    parsed["price"] = priceString.empty() ? nlohmann::json() : nlohmann::json(priceString);
-    parsed["triggerPrice"] = stopPrice.is_null() ? nlohmann::json() : stopPrice;
-    parsed["amount"] = amountString.empty() ? nlohmann::json() : nlohmann::json(amountString);
-    parsed["cost"] = cost.empty() ? nlohmann::json() : nlohmann::json(cost);
-    parsed["average"] = averageString.empty() ? nlohmann::json() : nlohmann::json(averageString);
-    parsed["filled"] = filledString.empty() ? nlohmann::json() : nlohmann::json(filledString);
-    parsed["remaining"] = nlohmann::json();
-    parsed["status"] = status;
-    parsed["fee"] = fee.is_null() ? nlohmann::json() : fee;
-    parsed["trades"] = trades;
 
+    req["params"] = order_params;
+    nlohmann::json response = send_request_and_wait(req, 30);
+    if (response.contains("error"))
+        throw std::runtime_error("edit_order " + id + " failed: " + response["error"].dump());
+
+    nlohmann::json result = response.value("result", nlohmann::json::object());
+    nlohmann::json order = result.value("order", nlohmann::json::object());
+    orders.apply(order);
+    nlohmann::json parsed = parse_order(order);
+    parsed["trades"] = result.value("trades", nlohmann::json::array());
+    record_fills(parsed["trades"]);
     return parsed;
 }
 
-void Deribit::watch_orders(std::function<void(const nlohmann::json &)> handler, const std::string &symbol, int64_t since, int limit, const nlohmann::json &params)
+nlohmann::json Deribit::cancel_orders(const std::vector<std::string> &ids, const std::string &symbol, const nlohmann::json &params)
+{
+    authenticate();
+
+    // Write every cancel before waiting on any reply so the batch costs one
+    // round trip instead of one per order. A cancel that cannot be sent
+    // leaves a null handler and its error in place of the reply.
+    std::vector<std::shared_ptr<ResponseHandler>> handlers(ids.size());
+    std::vector<std::string> failures(ids.size());
+    std::exception_ptr failure;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        nlohmann::json req;
+        req["jsonrpc"] = "2.0";
+        req["id"] = request_id++;
+        req["method"] = "private/cancel";
+        req["params"] = {{"order_id", ids[i]}};
+        for (auto &el : params.items())
+        {
+            req["params"][el.key()] = el.value();
+        }
+        try
+        {
+            handlers[i] = send_request_async(req);
+        }
+        catch (const std::exception &e)
+        {
+            failures[i] = e.what();
+            if (!failure)
+                failure = std::current_exception();
+        }
+    }
+    if (failure && std::none_of(handlers.begin(), handlers.end(), [](const auto &handler)
+                                { return handler != nullptr; }))
+        std::rethrow_exception(failure);
+
+    nlohmann::json replies = nlohmann::json::array();
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        if (handlers[i])
+        {
+            try
+            {
+                nlohmann::json response = wait_response(*handlers[i], 30);
+                if (response.contains("error"))
+                {
+                    replies.push_back({{"id", ids[i]}, {"status", "error"}, {"info", response["error"]}});
+                    continue;
+                }
+                nlohmann::json order = response.value("result", nlohmann::json::object());
+                orders.apply(order);
+                replies.push_back(parse_order(order));
+                continue;
+            }
+            catch (const std::exception &e)
+            {
+                failures[i] = e.what();
+            }
+        }
+        // Not sent or no reply: the order may or may not still be live
+        replies.push_back({{"id", ids[i]}, {"status", "error"}, {"info", {{"message", failures[i]}}}});
+    }
+    return replies;
+}
+
+nlohmann::json Deribit::cancel_all_orders(const std::string &symbol, const nlohmann::json &params)
+{
+    if (!symbol.empty())
+        return cancel_all_by_instrument(symbol, params);
+    // Label first: cancel_by_label narrows by currency itself, whereas
+    // cancel_all_by_currency would ignore the label and sweep everything
+    if (params.contains("label"))
+        return cancel_all_by_label(params["label"].get<std::string>(), params);
+    if (params.contains("currency"))
+        return cancel_all_by_currency(params["currency"].get<std::string>(), params);
+    return cancel_all(params);
+}
+
+nlohmann::json Deribit::cancel_all(const nlohmann::json &params)
+{
+    return send_cancel_all("private/cancel_all", nlohmann::json::object(), params);
+}
+
+nlohmann::json Deribit::cancel_all_by_instrument(const std::string &symbol, const nlohmann::json &params)
+{
+    return send_cancel_all("private/cancel_all_by_instrument", {{"instrument_name", symbol}}, params);
+}
+
+nlohmann::json Deribit::cancel_all_by_currency(const std::string &currency, const nlohmann::json &params)
+{
+    return send_cancel_all("private/cancel_all_by_currency", {{"currency", currency}}, params);
+}
+
+nlohmann::json Deribit::cancel_all_by_label(const std::string &label, const nlohmann::json &params)
+{
+    return send_cancel_all("private/cancel_by_label", {{"label", label}}, params);
+}
+
+nlohmann::json Deribit::send_cancel_all(const std::string &method, nlohmann::json request_params, const nlohmann::json &params)
 {
     authenticate();
+    nlohmann::json req;
+    req["jsonrpc"] = "2.0";
+    req["id"] = request_id++;
+    req["method"] = method;
+    // Everything but the selector the method already took passes through
+    for (auto &el : params.items())
+    {
+        if (!request_params.contains(el.key()))
+            request_params[el.key()] = el.value();
+    }
+    req["params"] = request_params;
+
+    nlohmann::json response = send_request_and_wait(req, 30);
+    if (response.contains("error"))
+        throw std::runtime_error(method + " failed: " + response["error"].dump());
+
+    nlohmann::json result = response.value("result", nlohmann::json());
+    if (!result.is_array())
+        return {{"cancelled", result.is_number() ? result : nlohmann::json(0)}, {"orders", nlohmann::json::array()}};
+
+    // detailed=true returns one execution report per cancelled batch
+    nlohmann::json cancelled = nlohmann::json::array();
+    for (const auto &report : result)
+    {
+        for (const auto &order : report.value("result", nlohmann::json::array()))
+        {
+            orders.apply(order);
+            cancelled.push_back(parse_order(order));
+        }
+    }
+    return {{"cancelled", cancelled.size()}, {"orders", cancelled}};
+}
 
+void Deribit::watch_ticker(std::function<void(const nlohmann::json &)> handler, const std::string &symbol, const nlohmann::json &params)
+{
+    watch_tickers(handler, {symbol}, params);
+}
+
+void Deribit::watch_trades(std::function<void(const nlohmann::json &)> handler, const std::string &symbol, int64_t since, int limit, const nlohmann::json &params)
+{
+    watch_trades_for_symbols(handler, {symbol}, since, limit, params);
+}
+
+std::string Deribit::orders_channel(const nlohmann::json &params) const
+{
     std::string currency = params.value("currency", "any");
     std::string interval = params.value("interval", "raw");
     std::string kind = params.value("kind", "any");
 
-    std::string channel = "user.orders." + kind + "." + currency + "." + interval;
+    return "user.orders." + kind + "." + currency + "." + interval;
+}
 
-    nlohmann::json req = {
-        {"jsonrpc", "2.0"},
-        {"id", request_id++},
-        {"method", "private/subscribe"},
-        {"params", {{"channels", {channel}}}}};
+void Deribit::watch_orders(std::function<void(const nlohmann::json &)> handler, const std::string &symbol, int64_t since, int limit, const nlohmann::json &params)
+{
+    authenticate();
+    ensure_markets();
+
+    std::string channel = orders_channel(params);
+    subscribe("private/subscribe", {channel}, handler);
+    // Only a stream covering every order can stand in for the RPCs; an
+    // offline client has nothing to seed it from
+    if (!offline && channel.starts_with("user.orders.any.any.") && !orders_live.load(std::memory_order_acquire))
+    {
+        seed_orders();
+    }
+}
 
-    subscription_handlers[channel] = handler;
+std::string Deribit::order_book_channel(const std::string &symbol, const nlohmann::json &params) const
+{
+    std::string interval = params.value("interval", "100ms");
+    if (params.value("useDepthEndpoint", false))
+    {
+        std::string depth = params.value("depth", "20");
+        std::string group = params.value("group", "none");
+        return "book." + symbol + "." + group + "." + depth + "." + interval;
+    }
+    return "book." + symbol + "." + interval;
+}
 
-    send_request(req);
+std::vector<std::string> Deribit::instrument_channels(const std::string &prefix, const std::vector<std::string> &symbols, const nlohmann::json &params) const
+{
+    std::string interval = params.value("interval", "100ms");
+
+    std::vector<std::string> channels;
+    channels.reserve(symbols.size());
+    for (const auto &symbol : symbols)
+    {
+        channels.push_back(prefix == "book" ? order_book_channel(symbol, params) : prefix + "." + symbol + "." + interval);
+    }
+    return channels;
 }
 
 void Deribit::watch_order_book(
@@ -995,38 +2267,126 @@ void Deribit::watch_order_book(
     int limit,
     const nlohmann::json &params)
 {
+    watch_order_book_for_symbols(handler, {symbol}, limit, params);
+}
 
-    std::string interval = params.value("interval", "100ms");
-    bool useDepthEndpoint = params.value("useDepthEndpoint", false);
-    std::string channel;
+void Deribit::watch_tickers(std::function<void(const nlohmann::json &)> handler, const std::vector<std::string> &symbols, const nlohmann::json &params)
+{
+    if (params.value("interval", "100ms") == "raw")
+    {
+        authenticate();
+    }
 
+    subscribe("public/subscribe", instrument_channels("ticker", symbols, params), handler);
+}
 
-    if (useDepthEndpoint)
+void Deribit::watch_trades_for_symbols(std::function<void(const nlohmann::json &)> handler, const std::vector<std::string> &symbols, int64_t since, int limit, const nlohmann::json &params)
+{
+    if (params.value("interval", "100ms") == "raw")
     {
-        std::string depth = params.value("depth", "20");
-        std::string group = params.value("group", "none");
-        channel = "book." + symbol + "." + group + "." + depth + "." + interval;
+        authenticate();
     }
-    else
+
+    subscribe("public/subscribe", instrument_channels("trades", symbols, params), handler);
+}
+
+void Deribit::watch_order_book_for_symbols(std::function<void(const nlohmann::json &)> handler, const std::vector<std::string> &symbols, int limit, const nlohmann::json &params)
+{
+    if (params.value("interval", "100ms") == "raw")
     {
-        channel = "book." + symbol + "." + interval;
+        authenticate();
     }
 
-    if (interval == "raw")
+    subscribe("public/subscribe", instrument_channels("book", symbols, params), handler);
+}
+
+void Deribit::resync_order_book(const std::string &symbol, const nlohmann::json &params)
+{
+    std::vector<std::string> channels = {order_book_channel(symbol, params)};
+    send_channel_requests("public/unsubscribe", channels);
+    send_channel_requests("public/subscribe", channels);
+}
+
+void Deribit::resync_channel(const std::string &channel)
+{
+    std::cerr << "Dispatch queue dropped notifications for " << channel << std::endl;
+    // A fresh subscription starts with a full snapshot; other channels have
+    // no replay, so their drops are only reported through dispatch_stats()
+    if (channel.starts_with("book."))
     {
-        std::cout << "Raw interval detected, authenticating..." << std::endl;
-        authenticate();
+        send_channel_requests("public/unsubscribe", {channel});
+        send_channel_requests("public/subscribe", {channel});
     }
+}
 
-    // Prepare subscription request
-    nlohmann::json req = {
-        {"jsonrpc", "2.0"},
-        {"id", request_id++},
-        {"method", "public/subscribe"},
-        {"params", {{"channels", {channel}}}}};
+void Deribit::unwatch_ticker(const std::string &symbol, const nlohmann::json &params)
+{
+    unwatch_tickers({symbol}, params);
+}
 
-    subscription_handlers[channel] = handler;
+void Deribit::unwatch_tickers(const std::vector<std::string> &symbols, const nlohmann::json &params)
+{
+    unsubscribe("public/unsubscribe", instrument_channels("ticker", symbols, params));
+}
+
+void Deribit::unwatch_trades(const std::string &symbol, const nlohmann::json &params)
+{
+    unwatch_trades_for_symbols({symbol}, params);
+}
+
+void Deribit::unwatch_trades_for_symbols(const std::vector<std::string> &symbols, const nlohmann::json &params)
+{
+    unsubscribe("public/unsubscribe", instrument_channels("trades", symbols, params));
+}
+
+void Deribit::unwatch_order_book(const std::string &symbol, const nlohmann::json &params)
+{
+    unwatch_order_book_for_symbols({symbol}, params);
+}
+
+void Deribit::unwatch_order_book_for_symbols(const std::vector<std::string> &symbols, const nlohmann::json &params)
+{
+    unsubscribe("public/unsubscribe", instrument_channels("book", symbols, params));
+}
 
-    send_request(req);
-    std::cout << "Subscription request sent" << std::endl;
+void Deribit::unwatch_orders(const std::string &symbol, const nlohmann::json &params)
+{
+    std::string channel = orders_channel(params);
+    if (channel.starts_with("user.orders.any.any."))
+    {
+        orders_live.store(false, std::memory_order_release);
+    }
+    unsubscribe("private/unsubscribe", {channel});
+}
+
+// Registers every handler before anything is sent, then subscribes only the
+// channels that had no handler yet.
+void Deribit::subscribe(const std::string &method, const std::vector<std::string> &channels, std::function<void(const nlohmann::json &)> handler)
+{
+    std::vector<std::string> activated;
+    subscriptions.add(channels, std::move(handler), &activated);
+    send_channel_requests(method, activated);
+}
+
+void Deribit::unsubscribe(const std::string &method, const std::vector<std::string> &channels)
+{
+    std::vector<std::string> deactivated;
+    subscriptions.remove_channels(channels, &deactivated);
+    send_channel_requests(method, deactivated);
+}
+
+// Packs the channels into as few requests as subscribe_batch_size allows.
+void Deribit::send_channel_requests(const std::string &method, const std::vector<std::string> &channels)
+{
+    for (size_t begin = 0; begin < channels.size(); begin += subscribe_batch_size)
+    {
+        size_t end = std::min(channels.size(), begin + subscribe_batch_size);
+        nlohmann::json req = {
+            {"jsonrpc", "2.0"},
+            {"id", request_id++},
+            {"method", method},
+            {"params", {{"channels", std::vector<std::string>(channels.begin() + begin, channels.begin() + end)}}}};
+
+        send_request(req);
+    }
 }
@@ -0,0 +1,222 @@
+#include "include/dispatch_queue.hpp"
+#include <algorithm>
+#include <iostream>
+
+DispatchQueue::DispatchQueue(Sink sink, size_t capacity)
+    : sink(std::move(sink)), capacity(std::max<size_t>(1, capacity))
+{
+}
+
+DispatchQueue::~DispatchQueue()
+{
+    stop();
+}
+
+void DispatchQueue::set_policy(const std::string &prefix, Policy policy)
+{
+    for (auto &entry : policies)
+    {
+        if (entry.first == prefix)
+        {
+            entry.second = policy;
+            return;
+        }
+    }
+    policies.emplace_back(prefix, policy);
+}
+
+DispatchQueue::Policy DispatchQueue::policy_for(std::string_view channel) const
+{
+    Policy result = Policy::DeliverAll;
+    size_t best = 0;
+    for (const auto &[prefix, policy] : policies)
+    {
+        if (prefix.size() >= best && channel.substr(0, prefix.size()) == prefix)
+        {
+            best = prefix.size();
+            result = policy;
+        }
+    }
+    return result;
+}
+
+void DispatchQueue::set_gap_handler(GapHandler handler)
+{
+    gap_handler = std::move(handler);
+}
+
+void DispatchQueue::start()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (running)
+    {
+        return;
+    }
+    running = true;
+    worker = std::thread([this]()
+                         { run(); });
+}
+
+void DispatchQueue::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!running)
+        {
+            return;
+        }
+        running = false;
+    }
+    cv.notify_one();
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+DispatchQueue::Channel &DispatchQueue::channel_for(std::string_view name)
+{
+    auto it = channels.find(name);
+    if (it != channels.end())
+    {
+        return *it->second;
+    }
+    auto channel = std::make_unique<Channel>();
+    channel->name = std::string(name);
+    channel->conflate = policy_for(name) == Policy::ConflateLatest;
+    Channel &ref = *channel;
+    channels.emplace(ref.name, std::move(channel));
+    return ref;
+}
+
+bool DispatchQueue::push(std::string_view name, nlohmann::json &&data)
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        Channel &channel = channel_for(name);
+
+        if (channel.conflate && channel.queued)
+        {
+            channel.latest = std::move(data);
+            conflated++;
+            return true;
+        }
+        if (queue.size() >= capacity)
+        {
+            // A conflated channel has nothing queued here, so the next
+            // update supersedes this one; any other channel gets a gap marker
+            dropped++;
+            channel.dropped++;
+            if (channel.conflate || channel.gap)
+            {
+                return false;
+            }
+            channel.gap = true;
+            queue.push_back({&channel, nullptr, true});
+            lock.unlock();
+            cv.notify_one();
+            return false;
+        }
+
+        if (channel.conflate)
+        {
+            channel.latest = std::move(data);
+            channel.queued = true;
+            queue.push_back({&channel, nullptr});
+        }
+        else
+        {
+            queue.push_back({&channel, std::move(data)});
+        }
+        enqueued++;
+        high_water = std::max(high_water, queue.size());
+    }
+    cv.notify_one();
+    return true;
+}
+
+void DispatchQueue::run()
+{
+    while (true)
+    {
+        Channel *channel;
+        nlohmann::json data;
+        bool gap;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]()
+                    { return !running || !queue.empty(); });
+            if (queue.empty())
+            {
+                return;
+            }
+            Pending &next = queue.front();
+            channel = next.channel;
+            gap = next.gap;
+            if (gap)
+            {
+                channel->gap = false;
+            }
+            else if (channel->conflate)
+            {
+                data = std::move(channel->latest);
+                channel->queued = false;
+            }
+            else
+            {
+                data = std::move(next.data);
+            }
+            queue.pop_front();
+        }
+
+        try
+        {
+            if (!gap)
+            {
+                sink(channel->name, data);
+            }
+            else if (gap_handler)
+            {
+                gap_handler(channel->name);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Handler for " << channel->name << " failed: " << e.what() << std::endl;
+        }
+
+        if (!gap)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            delivered++;
+        }
+    }
+}
+
+size_t DispatchQueue::depth() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return queue.size();
+}
+
+nlohmann::json DispatchQueue::stats() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    nlohmann::json dropped_channels = nlohmann::json::object();
+    for (const auto &[name, channel] : channels)
+    {
+        if (channel->dropped > 0)
+        {
+            dropped_channels[name] = channel->dropped;
+        }
+    }
+    return {{"depth", queue.size()},
+            {"capacity", capacity},
+            {"highWater", high_water},
+            {"channels", channels.size()},
+            {"enqueued", enqueued},
+            {"delivered", delivered},
+            {"dropped", dropped},
+            {"conflated", conflated},
+            {"droppedChannels", dropped_channels}};
+}
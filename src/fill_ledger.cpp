@@ -0,0 +1,234 @@
+#include "include/fill_ledger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+double FillLedger::pnl(const Position &position, double entry, double exit, double size)
+{
+    if (position.inverse)
+    {
+        return entry > 0.0 && exit > 0.0 ? size * (1.0 / entry - 1.0 / exit) : 0.0;
+    }
+    return size * (exit - entry);
+}
+
+void FillLedger::set_markets(std::shared_ptr<const MarketRegistry> registry)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    markets = std::move(registry);
+    std::vector<nlohmann::json> pending;
+    pending.swap(held);
+    for (const auto &trade : pending)
+    {
+        record(trade);
+    }
+}
+
+MarketRegistry::MarketId FillLedger::find(const std::string &instrument) const
+{
+    return markets ? markets->id(instrument) : MarketRegistry::npos;
+}
+
+bool FillLedger::on_trade(const nlohmann::json &trade)
+{
+    if (!trade.is_object())
+    {
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    return record(trade);
+}
+
+bool FillLedger::record(const nlohmann::json &trade)
+{
+    std::string trade_id = trade.contains("trade_id") && !trade["trade_id"].is_null()
+                               ? (trade["trade_id"].is_string() ? trade["trade_id"].get<std::string>() : trade["trade_id"].dump())
+                               : "";
+    std::string name = trade.value("instrument_name", "");
+    double price = trade.value("price", 0.0);
+    double quantity = trade.value("amount", 0.0);
+    if (trade_id.empty() || name.empty() || !(price > 0.0) || !(quantity > 0.0))
+    {
+        return false;
+    }
+    double amount = trade.value("direction", "") == "sell" ? -quantity : quantity;
+
+    if (seen_trades.count(trade_id))
+    {
+        return false;
+    }
+    MarketRegistry::MarketId market = find(name);
+    if (market == MarketRegistry::npos)
+    {
+        held.push_back(trade);
+        return false;
+    }
+    seen_trades.insert(trade_id);
+
+    auto [position, added] = positions.try_emplace(market);
+    if (added)
+    {
+        const MarketRecord &record = (*markets)[market];
+        position->second.inverse = (record.is(MarketRecord::Future) || record.is(MarketRecord::Swap)) &&
+                                   !record.is(MarketRecord::Linear);
+    }
+    Position &p = position->second;
+
+    double realized = 0.0;
+    if (p.size == 0.0 || (p.size > 0.0) == (amount > 0.0))
+    {
+        // Adding to the position (or opening it) moves the average entry
+        double held = std::abs(p.size);
+        if (p.inverse)
+        {
+            p.average_entry = (held + quantity) / (held / (held > 0.0 ? p.average_entry : price) + quantity / price);
+        }
+        else
+        {
+            p.average_entry = (held * p.average_entry + quantity * price) / (held + quantity);
+        }
+        p.size += amount;
+    }
+    else
+    {
+        // Reducing books PnL on the closed part; any excess reopens at the fill price
+        double closed = std::min(quantity, std::abs(p.size));
+        realized = pnl(p, p.average_entry, price, p.size > 0.0 ? closed : -closed);
+        p.size += amount;
+        if (std::abs(p.size) < 1e-12)
+        {
+            p.size = 0.0;
+            p.average_entry = 0.0;
+        }
+        else if (quantity > closed)
+        {
+            p.average_entry = price;
+        }
+    }
+
+    double fee = trade.value("fee", 0.0);
+    p.realized += realized;
+    p.fees += fee;
+    p.volume += quantity;
+    p.fills++;
+    p.last_fill = trade.value("timestamp", int64_t(0));
+    double mark = trade.value("mark_price", 0.0);
+    p.mark = mark > 0.0 ? mark : (p.mark > 0.0 ? p.mark : price);
+    p.unrealized = p.size == 0.0 ? 0.0 : pnl(p, p.average_entry, p.mark, p.size);
+
+    cols.timestamp.push_back(p.last_fill);
+    cols.instrument.push_back(market);
+    cols.price.push_back(price);
+    cols.amount.push_back(amount);
+    cols.fee.push_back(fee);
+    cols.realized.push_back(realized);
+    cols.maker.push_back(trade.value("liquidity", "") == "M" ? 1 : 0);
+    return true;
+}
+
+bool FillLedger::on_mark(const std::string &instrument, double mark)
+{
+    if (!(mark > 0.0))
+    {
+        return false;
+    }
+    {
+        // Most marks are for instruments never traded; those only share the lock
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        if (!positions.count(find(instrument)))
+        {
+            return false;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    Position &p = positions[find(instrument)];
+    p.mark = mark;
+    p.unrealized = p.size == 0.0 ? 0.0 : pnl(p, p.average_entry, mark, p.size);
+    return true;
+}
+
+std::optional<FillLedger::Position> FillLedger::position(const std::string &instrument) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    auto it = positions.find(find(instrument));
+    if (it == positions.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+FillLedger::Columns FillLedger::fills(size_t since) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    Columns result;
+    if (since >= cols.size())
+    {
+        return result;
+    }
+    auto tail = [since](const auto &column)
+    {
+        return std::remove_cvref_t<decltype(column)>(column.begin() + since, column.end());
+    };
+    result.timestamp = tail(cols.timestamp);
+    result.instrument = tail(cols.instrument);
+    result.price = tail(cols.price);
+    result.amount = tail(cols.amount);
+    result.fee = tail(cols.fee);
+    result.realized = tail(cols.realized);
+    result.maker = tail(cols.maker);
+    return result;
+}
+
+size_t FillLedger::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return cols.size();
+}
+
+size_t FillLedger::deferred() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return held.size();
+}
+
+std::string FillLedger::instrument(MarketRegistry::MarketId id) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return markets && id < markets->size() ? std::string(markets->name(id)) : std::string();
+}
+
+bool FillLedger::tracks(const std::string &instrument) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return positions.count(find(instrument)) > 0;
+}
+
+nlohmann::json FillLedger::to_json() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    nlohmann::json result;
+    result["fills"] = cols.size();
+    result["deferred"] = held.size();
+    result["instruments"] = nlohmann::json::object();
+    double realized = 0.0, unrealized = 0.0, fees = 0.0;
+    for (const auto &[market, p] : positions)
+    {
+        result["instruments"][std::string(markets->name(market))] = {{"size", p.size},
+                                           {"averageEntry", p.average_entry},
+                                           {"mark", p.mark},
+                                           {"realizedPnl", p.realized},
+                                           {"unrealizedPnl", p.unrealized},
+                                           {"fees", p.fees},
+                                           {"volume", p.volume},
+                                           {"fills", p.fills},
+                                           {"inverse", p.inverse}};
+        realized += p.realized;
+        unrealized += p.unrealized;
+        fees += p.fees;
+    }
+    result["realizedPnl"] = realized;
+    result["unrealizedPnl"] = unrealized;
+    result["fees"] = fees;
+    return result;
+}
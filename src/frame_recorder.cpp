@@ -0,0 +1,333 @@
+#include "include/frame_recorder.hpp"
+#include "include/tsc_clock.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr size_t segment_header_size = sizeof(FrameRecorder::SegmentHeader);
+    constexpr size_t record_header_size = sizeof(FrameRecorder::RecordHeader);
+
+    static_assert(segment_header_size == 64, "segment header must stay 64 bytes");
+    static_assert(record_header_size == 24, "record header must stay 24 bytes");
+
+    uint32_t aligned_size(size_t payload)
+    {
+        return static_cast<uint32_t>((record_header_size + payload + 7) & ~size_t(7));
+    }
+}
+
+FrameRecorder::FrameRecorder(const std::string &directory, const std::string &prefix, size_t segment_size)
+    : directory(directory), prefix(prefix), segment_size(segment_size & ~size_t(7))
+{
+    if (this->segment_size < 4096 || this->segment_size > UINT32_MAX)
+    {
+        throw std::runtime_error("Frame segment size must be between 4 KiB and 4 GiB");
+    }
+    std::filesystem::create_directories(directory);
+
+    head.store(segment_header_size);
+    for (uint64_t index = 0; index <= lookahead; ++index)
+    {
+        map_segment(slots[index % slot_count], index);
+    }
+    maintenance = std::thread([this]()
+                              { maintain(); });
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    close();
+}
+
+std::string FrameRecorder::segment_path(const std::string &directory, const std::string &prefix, uint64_t index)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "-%06llu.frames", static_cast<unsigned long long>(index));
+    return (std::filesystem::path(directory) / (prefix + name)).string();
+}
+
+void FrameRecorder::map_segment(Slot &slot, uint64_t index)
+{
+    std::string path = segment_path(directory, prefix, index);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to create frame segment " + path + ": " + std::strerror(errno));
+    }
+    if (::ftruncate(fd, segment_size) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Failed to size frame segment " + path + ": " + std::strerror(errno));
+    }
+    void *base = ::mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        ::close(fd);
+        throw std::runtime_error("Failed to map frame segment " + path + ": " + std::strerror(errno));
+    }
+
+    SegmentHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.header_size = segment_header_size;
+    header.index = index;
+    header.segment_size = segment_size;
+    header.created_ns = TscClock::instance().epoch_ns();
+    std::memcpy(base, &header, sizeof(header));
+
+    slot.base = static_cast<char *>(base);
+    slot.fd = fd;
+    slot.committed.store(segment_header_size, std::memory_order_relaxed);
+    slot.segment.store(index, std::memory_order_release);
+}
+
+void FrameRecorder::unmap_segment(Slot &slot, size_t used)
+{
+    ::munmap(slot.base, segment_size);
+    if (used < segment_size && ::ftruncate(slot.fd, used) != 0)
+    {
+        std::cerr << "Failed to trim frame segment: " << std::strerror(errno) << std::endl;
+    }
+    ::close(slot.fd);
+    slot.base = nullptr;
+    slot.fd = -1;
+    slot.segment.store(no_segment, std::memory_order_release);
+}
+
+void FrameRecorder::maintain()
+{
+    std::unique_lock<std::mutex> lock(maintenance_mtx);
+    while (!stopping)
+    {
+        lock.unlock();
+        uint64_t current = head.load(std::memory_order_acquire) >> offset_bits;
+        try
+        {
+            // Retire segments every writer has finished with
+            for (auto &slot : slots)
+            {
+                uint64_t held = slot.segment.load(std::memory_order_acquire);
+                if (held != no_segment && held < current &&
+                    slot.committed.load(std::memory_order_acquire) == segment_size)
+                {
+                    unmap_segment(slot, segment_size);
+                }
+            }
+            for (uint64_t index = current; index <= current + lookahead; ++index)
+            {
+                Slot &slot = slots[index % slot_count];
+                if (slot.segment.load(std::memory_order_acquire) == no_segment)
+                {
+                    map_segment(slot, index);
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Frame recorder: " << e.what() << std::endl;
+        }
+        lock.lock();
+        maintenance_cv.wait_for(lock, std::chrono::milliseconds(1));
+    }
+}
+
+FrameRecorder::Slot *FrameRecorder::wait_for(uint64_t segment)
+{
+    Slot &slot = slots[segment % slot_count];
+    if (slot.segment.load(std::memory_order_acquire) == segment)
+    {
+        return &slot;
+    }
+    // Writers outran the maintenance thread; only happens when the disk stalls
+    stalled.fetch_add(1, std::memory_order_relaxed);
+    maintenance_cv.notify_one();
+    while (slot.segment.load(std::memory_order_acquire) != segment)
+    {
+        std::this_thread::yield();
+    }
+    return &slot;
+}
+
+void FrameRecorder::write_record(Slot &slot, uint64_t offset, uint32_t size, Direction direction, uint16_t connection,
+                                 std::string_view payload, int64_t timestamp_ns)
+{
+    char *at = slot.base + offset;
+    RecordHeader header{};
+    header.length = static_cast<uint32_t>(payload.size());
+    header.timestamp_ns = timestamp_ns;
+    header.connection = connection;
+    header.direction = direction;
+    std::memcpy(at, &header, sizeof(header));
+    if (!payload.empty())
+    {
+        std::memcpy(at + sizeof(header), payload.data(), payload.size());
+    }
+    // Publishing the size last makes the record visible to readers
+    std::atomic_ref<uint32_t>(reinterpret_cast<RecordHeader *>(at)->size).store(size, std::memory_order_release);
+}
+
+bool FrameRecorder::record(Direction direction, uint16_t connection, std::string_view payload, int64_t timestamp_ns)
+{
+    in_flight.fetch_add(1);
+    uint32_t size = aligned_size(payload.size());
+    if (closing.load() || payload.size() > segment_size - segment_header_size - record_header_size - 8)
+    {
+        in_flight.fetch_sub(1, std::memory_order_release);
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (timestamp_ns == 0)
+    {
+        timestamp_ns = TscClock::instance().epoch_ns();
+    }
+
+    uint64_t current = head.load(std::memory_order_relaxed);
+    uint64_t next;
+    bool rotated;
+    do
+    {
+        uint64_t offset = current & offset_mask;
+        rotated = offset + size > segment_size;
+        next = rotated ? (((current >> offset_bits) + 1) << offset_bits) | (segment_header_size + size) : current + size;
+    } while (!head.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    uint64_t segment = current >> offset_bits;
+    uint64_t offset = current & offset_mask;
+    if (rotated)
+    {
+        // This writer owns the tail of the old segment: pad it out so the
+        // segment reaches its full committed size and can be retired
+        Slot *old = wait_for(segment);
+        uint64_t remaining = segment_size - offset;
+        if (remaining >= record_header_size)
+        {
+            write_record(*old, offset, static_cast<uint32_t>(remaining), Padding, connection, {}, timestamp_ns);
+        }
+        old->committed.fetch_add(remaining, std::memory_order_release);
+        segment++;
+        offset = segment_header_size;
+    }
+
+    Slot *slot = wait_for(segment);
+    write_record(*slot, offset, size, direction, connection, payload, timestamp_ns);
+    slot->committed.fetch_add(size, std::memory_order_release);
+
+    recorded.fetch_add(1, std::memory_order_relaxed);
+    in_flight.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void FrameRecorder::close()
+{
+    if (closing.exchange(true))
+    {
+        return;
+    }
+    while (in_flight.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+    {
+        std::lock_guard<std::mutex> lock(maintenance_mtx);
+        stopping = true;
+    }
+    maintenance_cv.notify_one();
+    maintenance.join();
+
+    uint64_t position = head.load(std::memory_order_acquire);
+    uint64_t current = position >> offset_bits;
+    for (auto &slot : slots)
+    {
+        uint64_t held = slot.segment.load(std::memory_order_acquire);
+        if (held == no_segment)
+        {
+            continue;
+        }
+        if (held > current)
+        {
+            // Mapped ahead but never written
+            unmap_segment(slot, segment_header_size);
+            std::filesystem::remove(segment_path(directory, prefix, held));
+        }
+        else
+        {
+            unmap_segment(slot, held == current ? position & offset_mask : segment_size);
+        }
+    }
+}
+
+FrameReader::FrameReader(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to open frame segment " + path + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FrameRecorder::SegmentHeader))
+    {
+        ::close(fd);
+        throw std::runtime_error("Not a frame segment: " + path);
+    }
+    length = st.st_size;
+    void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map frame segment " + path + ": " + std::strerror(errno));
+    }
+    base = static_cast<const char *>(mapped);
+
+    if (std::memcmp(header().magic, FrameRecorder::magic, sizeof(FrameRecorder::magic)) != 0 ||
+        header().version != FrameRecorder::version)
+    {
+        ::munmap(const_cast<char *>(base), length);
+        throw std::runtime_error("Not a frame segment: " + path);
+    }
+    offset = header().header_size;
+}
+
+FrameReader::~FrameReader()
+{
+    if (base)
+    {
+        ::munmap(const_cast<char *>(base), length);
+    }
+}
+
+const FrameRecorder::SegmentHeader &FrameReader::header() const
+{
+    return *reinterpret_cast<const FrameRecorder::SegmentHeader *>(base);
+}
+
+bool FrameReader::next(FrameRecord &record)
+{
+    if (offset + sizeof(FrameRecorder::RecordHeader) > length)
+    {
+        return false;
+    }
+    FrameRecorder::RecordHeader header;
+    std::memcpy(&header, base + offset, sizeof(header));
+    if (header.size < sizeof(header) || offset + header.size > length ||
+        header.direction == FrameRecorder::Padding)
+    {
+        offset = length;
+        return false;
+    }
+
+    record.timestamp_ns = header.timestamp_ns;
+    record.connection = header.connection;
+    record.direction = static_cast<FrameRecorder::Direction>(header.direction);
+    record.payload = std::string_view(base + offset + sizeof(header), header.length);
+    offset += header.size;
+    return true;
+}
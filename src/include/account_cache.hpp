@@ -0,0 +1,76 @@
+#pragma once
+
+#include "market_registry.hpp"
+#include <json.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Latest account summary per currency and open position per instrument, as
+// the exchange reports them in user.portfolio / user.changes notifications
+// and in get_account_summary / get_positions replies. Positions are stored
+// raw with their settlement currency, keyed by MarketRegistry id (by name
+// while the registry does not know the instrument); a position update with
+// zero size removes it. Readers share a lock; updates take it exclusively.
+//
+// Every write bumps version(). A snapshot requested while the stream is
+// live passes the version taken before the request as `since`, so entries
+// the stream wrote after that are kept instead of being rolled back.
+class AccountCache
+{
+public:
+    // Installs the registry instruments are resolved against; its ids must
+    // carry over from the previous one (see MarketRegistry).
+    void set_markets(std::shared_ptr<const MarketRegistry> registry);
+
+    // Replaces the summary of the currency named in `summary`, unless the
+    // stored one was written after `since`.
+    bool apply_balance(const nlohmann::json &summary, uint64_t since = no_version);
+    // Applies one position or an array of them.
+    size_t apply_positions(const std::string &currency, const nlohmann::json &positions);
+    // Snapshot of every position of `currency`; drops the ones not listed.
+    // Positions written (or removed) after `since` are left as they are.
+    void replace_positions(const std::string &currency, const nlohmann::json &positions, uint64_t since = no_version);
+
+    static constexpr uint64_t no_version = UINT64_MAX;
+    uint64_t version() const;
+
+    std::optional<nlohmann::json> balance(const std::string &currency) const;
+    std::map<std::string, nlohmann::json> balances() const;
+    std::optional<nlohmann::json> position(const std::string &instrument) const;
+    std::optional<nlohmann::json> position(MarketRegistry::MarketId market) const;
+    // Open positions sorted by instrument, optionally of one currency.
+    std::vector<nlohmann::json> positions(const std::string &currency = "") const;
+
+    size_t position_count() const;
+    void clear();
+
+private:
+    struct Position
+    {
+        std::string instrument;
+        std::string currency;
+        nlohmann::json position;
+    };
+
+    mutable std::shared_mutex mtx;
+    std::shared_ptr<const MarketRegistry> markets;
+    std::unordered_map<std::string, nlohmann::json> summaries;
+    std::unordered_map<MarketRegistry::MarketId, Position> open_positions;
+    std::map<std::string, Position> unlisted; // instruments the registry does not know
+    uint64_t current_version = 0;
+    // Version of the last write per currency summary and per instrument,
+    // kept for removed positions too
+    std::unordered_map<std::string, uint64_t> balance_versions;
+    std::unordered_map<std::string, uint64_t> position_versions;
+
+    MarketRegistry::MarketId resolve(const std::string &instrument) const;
+    const Position *find(const std::string &instrument) const;
+    bool store_position(const std::string &currency, const nlohmann::json &position);
+    uint64_t written(const std::unordered_map<std::string, uint64_t> &versions, const std::string &key) const;
+};
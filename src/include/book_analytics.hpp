@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include "order_book.hpp"
+
+// Maintains microprice, top-N imbalance and depth-VWAP for one book from its
+// level deltas. A delta outside the tracked window (deeper than the top
+// `imbalance_levels` levels and beyond the levels needed to fill
+// `vwap_size`) costs O(1); an in-place size change inside the top-N window
+// is applied to the running sums directly. Only deltas that change which
+// levels belong to a window trigger a walk, bounded by the window size.
+class BookAnalytics : public BookListener
+{
+public:
+    BookAnalytics(size_t imbalance_levels = 5, double vwap_size = 1.0);
+
+    void on_clear() override;
+    void on_level(bool is_bid, double price, double old_amount, double new_amount) override;
+    void on_update(const OrderBook &book) override;
+
+    const BookSignals &signals() const { return current; }
+    size_t imbalance_levels() const { return levels; }
+    double vwap_size() const { return fill_size; }
+
+private:
+    struct Window
+    {
+        // top-N depth
+        double depth = 0.0;
+        double depth_boundary = 0.0;
+        size_t depth_count = 0;
+        bool depth_dirty = true;
+
+        // levels consumed to fill fill_size
+        double fill_boundary = 0.0;
+        double fill_vwap = 0.0;
+        bool fill_complete = false;
+        bool fill_dirty = true;
+    };
+
+    size_t levels;
+    double fill_size;
+    Window bid;
+    Window ask;
+    BookSignals current;
+
+    void track(Window &window, bool is_bid, double price, double old_amount, double new_amount);
+
+    template <typename Levels>
+    void refresh(Window &window, const Levels &side);
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <json.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "book_analytics.hpp"
+#include "depth_ladder.hpp"
+#include "market_registry.hpp"
+#include "order_book.hpp"
+#include "spsc_queue.hpp"
+
+// Maintains many order books off the websocket io thread. Book frames are
+// routed by consistent hash of the instrument name to one of N shards; each
+// shard owns an SPSC queue and a worker thread, so all updates for a given
+// instrument are applied in arrival order by the same worker. Within a
+// shard books are keyed by MarketRegistry id; instruments the registry does
+// not know (or every instrument, without one) get a shard-local key.
+class BookManager
+{
+public:
+    explicit BookManager(size_t workers = 0, size_t queue_capacity = 8192, size_t snapshot_depth = 10);
+    ~BookManager();
+
+    BookManager(const BookManager &) = delete;
+    BookManager &operator=(const BookManager &) = delete;
+
+    void start();
+    void stop();
+
+    // Producer side. Must only be called from one thread at a time (normally
+    // the io thread running Deribit::on_message). Returns false when the
+    // shard queue is full and the frame was dropped.
+    bool submit(const nlohmann::json &data);
+    bool submit(nlohmann::json &&data);
+
+    // Handler suitable for Deribit::watch_order_book, so it runs on the io
+    // thread and never waits long. Incremental frames ("change"/"snapshot")
+    // spin for a few microseconds for queue space; if the shard is still
+    // full the frame is dropped and the worker marks that book out of sync
+    // and calls the resync handler. Full grouped books are dropped right
+    // away when the shard is full, the next one replaces them anyway.
+    std::function<void(const nlohmann::json &)> handler();
+
+    // Invoked on the owning worker thread when a book detects a change_id
+    // gap or lost an incremental frame to a full queue, after a snapshot
+    // with in_sync = false was published. The book
+    // stays out of sync until a new snapshot frame arrives, e.g. after
+    // Deribit::resync_order_book(). Must be set before start().
+    void set_resync_handler(std::function<void(const std::string &)> handler);
+
+    // Invoked on the owning worker thread after each applied update. Must be
+    // set before start().
+    void set_update_handler(std::function<void(const OrderBook &)> handler);
+
+    // Price groupings (e.g. 0.5, 5, 50) maintained locally for every book and
+    // published in BookSnapshot::ladders. Must be set before start().
+    void set_ladder_groups(const std::vector<double> &groups);
+
+    // Enables incremental BookAnalytics for every book; the signals are
+    // published in BookSnapshot::signals. Must be set before start().
+    void set_analytics(size_t imbalance_levels, double vwap_size);
+
+    // Registry instruments are resolved against, e.g.
+    // Deribit::market_registry(). Must be set before start().
+    void set_markets(std::shared_ptr<const MarketRegistry> registry);
+
+    size_t shard_count() const { return shards.size(); }
+    size_t shard_for(const std::string &instrument) const;
+
+    // Latest published top-of-book; nullptr if the instrument is unknown.
+    std::shared_ptr<const BookSnapshot> snapshot(const std::string &instrument) const;
+    std::shared_ptr<const BookSnapshot> snapshot(MarketRegistry::MarketId market) const;
+
+    uint64_t processed() const;
+    uint64_t dropped() const;
+    nlohmann::json stats() const;
+
+private:
+    struct BookSlot
+    {
+        std::atomic<std::shared_ptr<const BookSnapshot>> latest;
+    };
+
+    struct BookState
+    {
+        OrderBook book;
+        std::shared_ptr<BookSlot> slot;
+        std::vector<std::unique_ptr<DepthLadder>> ladders;
+        std::unique_ptr<BookAnalytics> analytics;
+    };
+
+    struct Shard
+    {
+        explicit Shard(size_t capacity) : queue(capacity) {}
+
+        SpscQueue<nlohmann::json> queue;
+        std::thread worker;
+        std::unordered_map<uint64_t, BookState> books; // by key()
+
+        // Keys of unknown instruments are added by the worker under the lock,
+        // so it can read them without one
+        mutable std::mutex slots_mtx;
+        std::unordered_map<uint64_t, std::shared_ptr<BookSlot>> slots;
+        std::unordered_map<std::string, uint64_t> unlisted;
+
+        // Instruments whose incremental frames were dropped, filled by the
+        // producer and drained by the worker
+        std::mutex lost_mtx;
+        std::unordered_set<std::string> lost;
+        std::atomic<bool> has_lost{false};
+
+        std::atomic<uint64_t> submitted{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> waits{0};
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> gaps{0};
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<std::pair<uint64_t, size_t>> ring;
+    std::shared_ptr<const MarketRegistry> markets;
+    size_t snapshot_depth;
+    std::atomic<bool> running{false};
+    std::function<void(const OrderBook &)> update_handler;
+    std::function<void(const std::string &)> resync_handler;
+    std::vector<double> ladder_groups;
+    bool analytics_enabled = false;
+    size_t analytics_levels = 5;
+    double analytics_vwap_size = 1.0;
+
+    // MarketId, or a shard-local key above the MarketId range
+    uint64_t key(Shard &shard, const std::string &instrument);
+    std::shared_ptr<const BookSnapshot> snapshot(const Shard &shard, uint64_t key) const;
+    bool push(nlohmann::json &&data, bool wait);
+    void run_worker(Shard &shard);
+    void apply(Shard &shard, const nlohmann::json &data);
+    void publish(BookState &state);
+    void resync_lost(Shard &shard);
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <json.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Candle
+{
+    int64_t start = 0; // bar open time, ms
+    double open = 0.0;
+    double high = 0.0;
+    double low = 0.0;
+    double close = 0.0;
+    double volume = 0.0;
+    uint32_t trades = 0;
+};
+
+// Builds OHLCV bars for several timeframes from a trade stream. Each
+// instrument/timeframe keeps its open bar plus a fixed-size ring of closed
+// bars, allocated when the instrument is first seen, so steady-state trades
+// update bars in place without touching the heap. A bar closes when a trade
+// (or flush()) reaches the next period; periods without trades produce no bar.
+//
+// Not thread-safe: feed it from the thread running the trades handlers.
+class CandleBuilder
+{
+public:
+    using CloseHandler = std::function<void(const std::string &instrument, int64_t timeframe_ms, const Candle &)>;
+
+    static constexpr int64_t default_timeframes[] = {1000, 60000, 300000, 3600000};
+
+    explicit CandleBuilder(std::vector<int64_t> timeframes_ms = {std::begin(default_timeframes), std::end(default_timeframes)},
+                           size_t history = 512);
+
+    void set_close_handler(CloseHandler on_close);
+
+    // Trades older than the open bar of a timeframe are ignored for that
+    // timeframe and counted in late_trades().
+    void add_trade(const std::string &instrument, int64_t timestamp, double price, double amount);
+
+    // Applies one `trades.*` notification (an array of trades).
+    void on_trades(const nlohmann::json &trades);
+
+    // Handler suitable for Deribit::watch_trades.
+    std::function<void(const nlohmann::json &)> handler();
+
+    // Closes every open bar whose period ended at or before now_ms.
+    void flush(int64_t now_ms);
+
+    // Closed bars, oldest first; at most `limit` of the most recent (0 = all kept).
+    std::vector<Candle> candles(const std::string &instrument, int64_t timeframe_ms, size_t limit = 0) const;
+
+    // The bar currently being built, if any.
+    const Candle *current(const std::string &instrument, int64_t timeframe_ms) const;
+
+    const std::vector<int64_t> &timeframes() const { return frames; }
+    uint64_t late_trades() const { return late; }
+
+private:
+    struct Ring
+    {
+        Candle open_bar;
+        bool active = false;
+        size_t head = 0; // next write position
+        size_t count = 0;
+    };
+
+    struct Series
+    {
+        std::string instrument;
+        std::vector<Ring> rings;     // one per timeframe
+        std::vector<Candle> history; // rings.size() * capacity closed bars
+    };
+
+    std::vector<int64_t> frames;
+    size_t capacity;
+    std::vector<Series> series;
+    std::unordered_map<std::string, size_t> index;
+    CloseHandler on_close;
+    uint64_t late = 0;
+
+    Series &series_for(const std::string &instrument);
+    const Series *find(const std::string &instrument) const;
+    size_t frame_index(int64_t timeframe_ms) const;
+    void close_bar(Series &s, size_t frame);
+};
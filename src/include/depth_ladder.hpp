@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include "order_book.hpp"
+
+// Price ladder aggregated into fixed-size buckets, maintained incrementally
+// from the level deltas of an OrderBook. Bids are grouped down and asks up to
+// the bucket boundary, matching the exchange's `group` book channels.
+class DepthLadder : public BookListener
+{
+public:
+    explicit DepthLadder(double group);
+
+    void on_clear() override;
+    void on_level(bool is_bid, double price, double old_amount, double new_amount) override;
+
+    LadderView view(size_t depth = 0) const;
+    double group() const { return group_size; }
+
+private:
+    struct Bucket
+    {
+        double amount = 0.0;
+        uint32_t levels = 0;
+    };
+
+    double group_size;
+    std::map<int64_t, Bucket, std::greater<int64_t>> bid_buckets;
+    std::map<int64_t, Bucket> ask_buckets;
+
+    int64_t bucket_index(bool is_bid, double price) const;
+
+    template <typename Buckets>
+    void adjust(Buckets &buckets, int64_t index, double old_amount, double new_amount);
+};
@@ -4,20 +4,62 @@
 #include <websocketpp/client.hpp>
 #include <websocketpp/config/asio_client.hpp>
 #include <string>
+#include <string_view>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
 #include <unordered_map>
 #include "../base/exchange.hpp"
+#include "account_cache.hpp"
+#include "dispatch_queue.hpp"
+#include "fill_ledger.hpp"
+#include "frame_recorder.hpp"
+#include "latency_histogram.hpp"
+#include "market_registry.hpp"
+#include "order_store.hpp"
+#include "outbound_scheduler.hpp"
+#include "rate_limiter.hpp"
+#include "subscription_registry.hpp"
 
 typedef websocketpp::client<websocketpp::config::asio_tls_client> WebSocketClient;
 typedef websocketpp::config::asio_tls_client::message_type::ptr message_ptr;
 
+class MetricsServer;
+
+// Hot path counters; relaxed atomics, grouped by the thread that writes them.
+struct FeedCounters
+{
+    // io thread
+    alignas(64) std::atomic<uint64_t> frames_in{0};
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> unrouted{0};
+    std::atomic<uint64_t> message_errors{0};
+    std::atomic<uint64_t> exchange_errors{0};
+    // request threads
+    alignas(64) std::atomic<uint64_t> frames_out{0};
+    std::atomic<uint64_t> bytes_out{0};
+    // connection and auth events
+    alignas(64) std::atomic<uint64_t> connects{0};
+    std::atomic<uint64_t> disconnects{0};
+    std::atomic<uint64_t> connection_failures{0};
+    std::atomic<uint64_t> auth_refreshes{0};
+    std::atomic<uint64_t> auth_failures{0};
+};
+
 struct ResponseHandler
 {
     std::mutex mtx;
     std::condition_variable cv;
     nlohmann::json response;
     bool received = false;
+    int id = 0;
+    RpcMetrics::Method *stats = nullptr;
+    uint64_t issued_at = 0;            // TscClock ticks, when send_request_async ran
+    std::atomic<uint64_t> sent_at{0}; // TscClock ticks, when the frame was written; 0 until then
+    // Raw handlers keep a successful reply as text in `payload` (leaving
+    // `response` null) so the caller can parse it off the io thread
+    bool raw = false;
+    std::string payload;
 };
 
 class Deribit : public Exchange
@@ -26,21 +68,112 @@ public:
     Deribit(const nlohmann::json &config);
     ~Deribit();
 
-    nlohmann::json markets;
-    std::unordered_map<std::string, nlohmann::json> markets_by_id;
-
     void authenticate() override;
 
+    // Processes one inbound frame exactly as if it arrived on the socket.
+    // With "offline": true in the config the client never connects, drops
+    // outbound subscribe traffic and fails request/response calls, so frames
+    // can be fed in from a recording (see ReplayDriver).
+    void handle_message(std::string_view payload);
+
+    // Per JSON-RPC method request counts, errors, timeouts and send-to-response
+    // latency percentiles, plus the in-flight request depth.
+    nlohmann::json rpc_stats() const;
+    void reset_rpc_stats();
+
+    // Connection, traffic, per-channel, RPC, queue and auth metrics in the
+    // Prometheus text format. Served on /metrics when the config has a
+    // "metrics" object ({"port": 9464, "address": "127.0.0.1"}); it binds to
+    // loopback unless another address is given.
+    std::string metrics_text();
+    uint16_t metrics_port() const;
+
+    // With "market_cache": {"path": "markets.bin", "ttl": 86400} the first
+    // load_markets() serves a cache younger than `ttl` seconds (any age when
+    // offline) and refetches in the background, publishing the new set only
+    // if it differs. Every fetch rewrites the cache.
+    //
+    // Markets from the last load_markets(); null before the first load.
+    // Each reload publishes a new registry, so a held pointer stays valid.
+    std::shared_ptr<const MarketRegistry> market_registry() const;
+
+    // Local credit model applied to every outbound request when the config
+    // has a "rate_limit" object (see RateLimiter); null otherwise. Requests
+    // it rejects throw from the calling method.
+    const RateLimiter *rate_limiter() const;
+
+    // Orders seen in user.orders notifications and order RPC replies. Once
+    // watch_orders() covers every order (the default "any" kind and
+    // currency) the store is seeded from get_open_orders and fetch_order /
+    // fetch_open_orders answer from it until the stream stops.
+    const OrderStore &order_store() const;
+    bool order_stream_live() const;
+
+    // Subscribes to user.portfolio for each currency (params "currencies",
+    // default all) and user.changes for every instrument, then loads every
+    // summary and position in one parallel round. Until unwatch_account()
+    // or a disconnect, fetch_balance / fetch_positions read the cache.
+    void watch_account(const nlohmann::json &params = nlohmann::json::object());
+    void unwatch_account();
+    const AccountCache &account_cache() const;
+    bool account_stream_live() const;
+
+    // Own fills from user.trades and order replies, revalued on every
+    // ticker mark of a traded instrument (see FillLedger).
+    const FillLedger &fill_ledger() const;
+    // Subscribes to user.trades for `symbol`, or for params "kind" and
+    // "currency" (default any) when no symbol is given.
+    void watch_my_trades(std::function<void(const nlohmann::json &)> handler, const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object());
+
+    // With "outbound": {"max_backlog": 65536} frames are written from the io
+    // thread in priority order (cancels, then orders, then everything else)
+    // through an OutboundScheduler instead of directly by the calling thread.
+    nlohmann::json outbound_stats() const;
+
+    // Counters of the handler dispatch queue; empty unless "dispatch_queue" is configured.
+    nlohmann::json dispatch_stats() const;
+
+    // fetch_markets() sends one get_instruments per currency and kind,
+    // up to params "max_in_flight" (default 8) at once, and parses the
+    // replies on a thread pool; any rejected request fails the whole fetch.
+    // params may narrow the fan-out with "currencies" (default: all from
+    // get_currencies) and "kinds"; load_markets(true, {..., "merge": true})
+    // adds the fetched markets to the loaded set instead of replacing it,
+    // so the currencies traded first can be loaded first.
     nlohmann::json load_markets(bool reload = false, const nlohmann::json &params = nlohmann::json::object()) override;
     nlohmann::json fetch_markets(const nlohmann::json &params = nlohmann::json::object()) override;
+    // Without "code" every currency is returned, fetched in parallel unless
+    // watch_account() keeps them cached.
     nlohmann::json fetch_balance(const nlohmann::json &params = nlohmann::json::object()) override;
+    nlohmann::json fetch_positions(const std::vector<std::string> &symbols = {}, const nlohmann::json &params = nlohmann::json::object()) override;
     nlohmann::json fetch_ticker(const std::string &symbol) override;
     nlohmann::json fetch_order_book(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) override;
     nlohmann::json fetch_orders(const std::string &symbol = "", int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) override;
     nlohmann::json fetch_order(const std::string &id, const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) override;
+    nlohmann::json fetch_open_orders(const std::string &symbol = "", int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) override;
     nlohmann::json create_order(const std::string &symbol, const std::string &type, const std::string &side, double amount, std::optional<double> price = std::nullopt, const nlohmann::json &params = nlohmann::json::object()) override;
     nlohmann::json cancel_order(const std::string &id, const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) override;
+    // Amends price and amount in place with private/edit rather than a cancel
+    // and a new order. Throws when the exchange rejects the edit.
+    nlohmann::json edit_order(const std::string &id, const std::string &symbol, const std::string &type, const std::string &side, double amount, std::optional<double> price = std::nullopt, const nlohmann::json &params = nlohmann::json::object()) override;
+    // Sends every cancel before waiting for the first reply. Returns one entry
+    // per id in order; cancels the exchange rejects, or that failed to send
+    // or timed out, come back with status "error" and the error object under
+    // "info". Throws only when none of the cancels could be sent.
+    nlohmann::json cancel_orders(const std::vector<std::string> &ids, const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) override;
+    // Routes to cancel_all_by_instrument when a symbol is given, else by
+    // params "label" (narrowed by "currency" when both are given) or
+    // "currency", else cancel_all. All of them return
+    // {"cancelled": n, "orders": [...]}; orders are only listed with
+    // params {"detailed": true}.
+    nlohmann::json cancel_all_orders(const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) override;
+    nlohmann::json cancel_all(const nlohmann::json &params = nlohmann::json::object());
+    nlohmann::json cancel_all_by_instrument(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object());
+    nlohmann::json cancel_all_by_currency(const std::string &currency, const nlohmann::json &params = nlohmann::json::object());
+    nlohmann::json cancel_all_by_label(const std::string &label, const nlohmann::json &params = nlohmann::json::object());
 
+    void watch_ticker(std::function<void(const nlohmann::json &)> handler, const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) override;
+    void watch_trades(std::function<void(const nlohmann::json &)> handler, const std::string &symbol, int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) override;
     void watch_orders(std::function<void(const nlohmann::json &)> handler, const std::string &symbol = "", int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) override;
     void watch_order_book(
         std::function<void(const nlohmann::json &)> handler,
@@ -48,10 +181,27 @@ public:
         int limit = 0,
         const nlohmann::json &params = nlohmann::json::object()
     ) override;
+
+    void watch_tickers(std::function<void(const nlohmann::json &)> handler, const std::vector<std::string> &symbols, const nlohmann::json &params = nlohmann::json::object()) override;
+    void watch_trades_for_symbols(std::function<void(const nlohmann::json &)> handler, const std::vector<std::string> &symbols, int64_t since = 0, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) override;
+    void watch_order_book_for_symbols(std::function<void(const nlohmann::json &)> handler, const std::vector<std::string> &symbols, int limit = 0, const nlohmann::json &params = nlohmann::json::object()) override;
+    // Re-subscribes the book channel of `symbol` (same params as
+    // watch_order_book) so the exchange sends a fresh snapshot; handlers stay
+    // registered. Suitable for BookManager::set_resync_handler.
+    void resync_order_book(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object());
+
+    void unwatch_ticker(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) override;
+    void unwatch_tickers(const std::vector<std::string> &symbols, const nlohmann::json &params = nlohmann::json::object()) override;
+    void unwatch_trades(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) override;
+    void unwatch_trades_for_symbols(const std::vector<std::string> &symbols, const nlohmann::json &params = nlohmann::json::object()) override;
+    void unwatch_order_book(const std::string &symbol, const nlohmann::json &params = nlohmann::json::object()) override;
+    void unwatch_order_book_for_symbols(const std::vector<std::string> &symbols, const nlohmann::json &params = nlohmann::json::object()) override;
+    void unwatch_orders(const std::string &symbol = "", const nlohmann::json &params = nlohmann::json::object()) override;
     
 
 private:
     bool is_test;
+    bool offline = false;
     std::string url;
     WebSocketClient client;
     websocketpp::connection_hdl connection_hdl;
@@ -59,30 +209,90 @@ private:
     bool connection_failed = false;
     std::mutex mtx;
     std::condition_variable cv;
-    int request_id = 1;
+    std::atomic<int> request_id{1};
+    size_t subscribe_batch_size = 500;
 
     std::string apiKey;
     std::string secret;
     std::string password;
     std::string access_token;
+    std::string refresh_token;
+    long long auth_issued_at = 0;
     long long auth_expires_at = 0;
-    bool authenticated = false;
+    // Set while the session holds a usable token; the refresher renews it
+    // before expiry, so authenticate() only loads this flag
+    std::atomic<bool> authenticated{false};
     bool auth_in_progress = false;
+    bool auth_stopping = false;
     std::mutex auth_mtx;
     std::condition_variable auth_cv;
+    std::condition_variable auth_refresh_cv;
+    std::thread auth_refresher;
+
+    std::atomic<std::shared_ptr<const MarketRegistry>> markets;
+    std::string market_cache_path;
+    int64_t market_cache_ttl_ms = 0;
+    std::thread market_refresher;
 
     std::mutex pending_requests_mutex;
-    std::unordered_map<int, ResponseHandler> pending_requests;
+    std::unordered_map<int, std::shared_ptr<ResponseHandler>> pending_requests;
+    std::atomic<int> raw_pending{0}; // raw handlers not yet waited on; gates the reply id peek
+    RpcMetrics rpc_metrics;
 
-    std::map<std::string, std::function<void(const nlohmann::json&)>> subscription_handlers;
+    SubscriptionRegistry subscriptions;
+    std::unique_ptr<DispatchQueue> dispatch_queue;
+    std::unique_ptr<FrameRecorder> recorder;
+    std::unique_ptr<RateLimiter> limiter;
+    std::shared_ptr<OutboundScheduler> outbound;
+    OrderStore orders;
+    std::atomic<bool> orders_live{false};
+    AccountCache account;
+    std::atomic<bool> account_live{false};
+    std::vector<std::string> account_channels;
+    FillLedger fills;
+    std::atomic<uint16_t> connection_id{0};
+    FeedCounters counters;
+    // Last so it stops before anything it reports on is destroyed
+    std::unique_ptr<MetricsServer> metrics_server;
 
+    void install_markets(std::shared_ptr<const MarketRegistry> registry);
+    void ensure_markets();
+    void refresh_markets(const nlohmann::json &params);
+    void save_market_cache(const MarketRegistry &registry);
     void connect();
     bool is_connected();
     void on_open(websocketpp::connection_hdl);
     void on_fail(websocketpp::connection_hdl);
     void on_close(websocketpp::connection_hdl);
     void send_request(const nlohmann::json &request);
+    // As above, stamping `handler` when the frame is actually written.
+    void send_request(const nlohmann::json &request, const std::shared_ptr<ResponseHandler> &handler);
+    void mark_sent(ResponseHandler &handler);
+    // Completes a waiter that will get no reply with an error response.
+    void fail_request(ResponseHandler &handler, const std::string &message);
     void on_message(websocketpp::connection_hdl, message_ptr msg);
+    void store_auth_result(const nlohmann::json &response, long long requested_at);
+    void refresh_auth_loop();
     std::string generate_signature(const std::string &timestamp, const std::string &nonce);
     nlohmann::json send_request_and_wait(const nlohmann::json &request, int timeout_seconds = 30);
+    // Split form of send_request_and_wait for keeping several requests in flight.
+    std::shared_ptr<ResponseHandler> send_request_async(const nlohmann::json &request, bool raw = false);
+    nlohmann::json wait_response(ResponseHandler &handler, int timeout_seconds = 30);
+    nlohmann::json wait_response(ResponseHandler &handler, std::chrono::steady_clock::time_point deadline);
+    std::vector<std::string> fetch_currencies();
+    static nlohmann::json parse_market(const nlohmann::json &instrument);
+    static nlohmann::json parse_order(const nlohmann::json &order);
+    void seed_orders();
+    static nlohmann::json parse_position(const nlohmann::json &position);
+    std::string settle_currency(const std::string &instrument) const;
+    void load_account(const std::vector<std::string> &currencies, bool balances, bool positions);
+    void record_fills(const nlohmann::json &trades);
+    nlohmann::json send_cancel_all(const std::string &method, nlohmann::json request_params, const nlohmann::json &params);
+    void subscribe(const std::string &method, const std::vector<std::string> &channels, std::function<void(const nlohmann::json &)> handler);
+    void unsubscribe(const std::string &method, const std::vector<std::string> &channels);
+    void send_channel_requests(const std::string &method, const std::vector<std::string> &channels);
+    void resync_channel(const std::string &channel);
+    std::string order_book_channel(const std::string &symbol, const nlohmann::json &params) const;
+    std::string orders_channel(const nlohmann::json &params) const;
+    std::vector<std::string> instrument_channels(const std::string &prefix, const std::vector<std::string> &symbols, const nlohmann::json &params) const;
 };
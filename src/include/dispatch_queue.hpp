@@ -0,0 +1,108 @@
+#pragma once
+
+#include <json.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Bounded hand-off between the websocket io thread and handler execution.
+// Notifications are pushed by the io thread and delivered in order by one
+// worker thread. Channels matching a conflate prefix (tickers, quotes) keep
+// at most one pending notification: a newer one overwrites the queued data
+// in place. push() never blocks, since the io thread also delivers RPC
+// replies such as cancel acks. Deliver-all channels (order updates,
+// incremental books) cannot lose messages silently though: a notification
+// that finds the queue full is dropped, the drop is counted per channel and
+// a gap marker is queued behind the channel's earlier notifications (beyond
+// capacity, at most one per channel). The worker hands it to the gap
+// handler so the owner can resubscribe or reconcile the channel.
+class DispatchQueue
+{
+public:
+    enum class Policy
+    {
+        DeliverAll,
+        ConflateLatest
+    };
+
+    using Sink = std::function<void(const std::string &channel, const nlohmann::json &data)>;
+    // Called on the worker thread for a channel that lost notifications.
+    using GapHandler = std::function<void(const std::string &channel)>;
+
+    explicit DispatchQueue(Sink sink, size_t capacity = 65536);
+    ~DispatchQueue();
+
+    DispatchQueue(const DispatchQueue &) = delete;
+    DispatchQueue &operator=(const DispatchQueue &) = delete;
+
+    // Channels starting with `prefix` use `policy`; the longest matching
+    // prefix wins and unmatched channels deliver all. Set before start().
+    void set_policy(const std::string &prefix, Policy policy);
+    Policy policy_for(std::string_view channel) const;
+    // Set before start().
+    void set_gap_handler(GapHandler handler);
+
+    void start();
+    // Stops the worker once the pending notifications have been delivered.
+    void stop();
+
+    // Returns false when the notification was dropped because the queue
+    // was full.
+    bool push(std::string_view channel, nlohmann::json &&data);
+
+    size_t depth() const;
+    nlohmann::json stats() const;
+
+private:
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    struct Channel
+    {
+        std::string name;
+        bool conflate = false;
+        bool queued = false;
+        bool gap = false; // a gap marker is queued
+        uint64_t dropped = 0;
+        nlohmann::json latest;
+    };
+
+    struct Pending
+    {
+        Channel *channel;
+        nlohmann::json data; // unused for conflated channels and gap markers
+        bool gap = false;
+    };
+
+    Sink sink;
+    GapHandler gap_handler;
+    size_t capacity;
+    std::vector<std::pair<std::string, Policy>> policies;
+
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Pending> queue;
+    std::unordered_map<std::string, std::unique_ptr<Channel>, Hash, std::equal_to<>> channels;
+    bool running = false;
+    std::thread worker;
+
+    uint64_t enqueued = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t conflated = 0;
+    size_t high_water = 0;
+
+    Channel &channel_for(std::string_view name);
+    void run();
+};
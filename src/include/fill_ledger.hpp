@@ -0,0 +1,91 @@
+#pragma once
+
+#include "market_registry.hpp"
+#include <json.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Own fills stored column-wise in arrival order, with per-instrument
+// position, average entry, realized PnL and fees maintained incrementally,
+// so neither a new fill nor a mark change rescans the history. Fills come
+// from user.trades notifications and the trades of order replies; the same
+// trade_id is recorded once. Instruments are keyed by MarketRegistry id, and
+// a trade whose instrument the current registry does not know yet is held
+// back until set_markets() installs one that does. Amounts are signed
+// (+ buy, - sell) in the instrument's own units. Inverse instruments (futures
+// and perpetuals that are not linear: amount in USD, PnL in coin) average
+// their entry harmonically and book PnL as amount * (1/entry - 1/exit).
+// Every method is thread-safe.
+class FillLedger
+{
+public:
+    // Append-only; row i of every column is fill i.
+    struct Columns
+    {
+        std::vector<int64_t> timestamp;
+        std::vector<MarketRegistry::MarketId> instrument;
+        std::vector<double> price;
+        std::vector<double> amount;
+        std::vector<double> fee;
+        std::vector<double> realized; // PnL this fill closed
+        std::vector<uint8_t> maker;
+
+        size_t size() const { return timestamp.size(); }
+    };
+
+    struct Position
+    {
+        bool inverse = false;
+        double size = 0.0;
+        double average_entry = 0.0; // 0 when flat
+        double realized = 0.0;
+        double fees = 0.0;
+        double mark = 0.0;
+        double unrealized = 0.0;
+        double volume = 0.0; // sum of |amount|
+        uint64_t fills = 0;
+        int64_t last_fill = 0;
+    };
+
+    // Installs the registry trades are resolved against; its ids must carry
+    // over from the previous one (see MarketRegistry's reload constructor).
+    // Held-back trades it now knows are recorded.
+    void set_markets(std::shared_ptr<const MarketRegistry> registry);
+
+    // Records one exchange trade; false when it is a duplicate, malformed or
+    // held back until its market is known.
+    bool on_trade(const nlohmann::json &trade);
+    // Revalues the open position of `instrument`; untraded instruments are ignored.
+    bool on_mark(const std::string &instrument, double mark);
+
+    std::optional<Position> position(const std::string &instrument) const;
+    // Fills from row `since` on, for readers that keep their own cursor.
+    Columns fills(size_t since = 0) const;
+    size_t size() const;
+    // Trades waiting for a registry that knows their instrument.
+    size_t deferred() const;
+    std::string instrument(MarketRegistry::MarketId id) const;
+    bool tracks(const std::string &instrument) const;
+
+    // Per-instrument positions and PnL plus totals (totals mix settlement
+    // currencies when instruments of several are traded).
+    nlohmann::json to_json() const;
+
+private:
+    mutable std::shared_mutex mtx;
+    std::shared_ptr<const MarketRegistry> markets;
+    Columns cols;
+    std::unordered_map<MarketRegistry::MarketId, Position> positions;
+    std::unordered_set<std::string> seen_trades;
+    std::vector<nlohmann::json> held; // trades of markets not known yet
+
+    bool record(const nlohmann::json &trade);
+    MarketRegistry::MarketId find(const std::string &instrument) const;
+    static double pnl(const Position &position, double entry, double exit, double size);
+};
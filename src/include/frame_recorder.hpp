@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Binary log of raw websocket frames in memory-mapped, fixed-size segment
+// files named <prefix>-<index>.frames. Writers reserve space with a CAS on
+// one packed (segment, offset) word and copy the frame straight into the
+// mapping, so record() takes no lock and makes no system call. A maintenance
+// thread maps segments ahead of the writers and retires full ones.
+//
+// Segment layout: a 64-byte SegmentHeader followed by 8-byte aligned
+// records, each a RecordHeader plus payload. A record's `size` is stored
+// last, so a zero size marks the end of the written data.
+class FrameRecorder
+{
+public:
+    enum Direction : uint8_t
+    {
+        Inbound = 0,
+        Outbound = 1,
+        Padding = 2
+    };
+
+    struct SegmentHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+        uint64_t index;
+        uint64_t segment_size;
+        int64_t created_ns;
+        uint8_t reserved[24];
+    };
+
+    struct RecordHeader
+    {
+        uint32_t size; // whole record including header and alignment
+        uint32_t length; // payload bytes
+        int64_t timestamp_ns;
+        uint16_t connection;
+        uint8_t direction;
+        uint8_t reserved[5];
+    };
+
+    static constexpr char magic[8] = {'D', 'R', 'B', 'F', 'R', 'A', 'M', 'E'};
+    static constexpr uint32_t version = 1;
+
+    explicit FrameRecorder(const std::string &directory, const std::string &prefix = "frames", size_t segment_size = 64 << 20);
+    ~FrameRecorder();
+
+    FrameRecorder(const FrameRecorder &) = delete;
+    FrameRecorder &operator=(const FrameRecorder &) = delete;
+
+    // Safe from any thread. `timestamp_ns` of 0 stamps the current time.
+    // Returns false if the frame is larger than a segment or the recorder is closed.
+    bool record(Direction direction, uint16_t connection, std::string_view payload, int64_t timestamp_ns = 0);
+
+    // Waits for in-flight writers, trims the last segment and unmaps everything.
+    void close();
+
+    uint64_t records() const { return recorded.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return rejected.load(std::memory_order_relaxed); }
+    uint64_t stalls() const { return stalled.load(std::memory_order_relaxed); }
+    uint64_t segments() const { return (head.load(std::memory_order_relaxed) >> offset_bits) + 1; }
+
+    static std::string segment_path(const std::string &directory, const std::string &prefix, uint64_t index);
+
+private:
+    static constexpr size_t slot_count = 4;
+    static constexpr size_t lookahead = 2;
+    static constexpr unsigned offset_bits = 40;
+    static constexpr uint64_t offset_mask = (uint64_t(1) << offset_bits) - 1;
+    static constexpr uint64_t no_segment = ~uint64_t(0);
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> segment{no_segment};
+        std::atomic<uint64_t> committed{0};
+        char *base = nullptr;
+        int fd = -1;
+    };
+
+    std::string directory;
+    std::string prefix;
+    size_t segment_size;
+
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<int64_t> in_flight{0};
+    std::atomic<bool> closing{false};
+    std::atomic<uint64_t> recorded{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> stalled{0};
+
+    std::array<Slot, slot_count> slots;
+    std::mutex maintenance_mtx;
+    std::condition_variable maintenance_cv;
+    bool stopping = false;
+    std::thread maintenance;
+
+    void map_segment(Slot &slot, uint64_t index);
+    void unmap_segment(Slot &slot, size_t used);
+    void maintain();
+    Slot *wait_for(uint64_t segment);
+    void write_record(Slot &slot, uint64_t offset, uint32_t size, Direction direction, uint16_t connection,
+                      std::string_view payload, int64_t timestamp_ns);
+};
+
+struct FrameRecord
+{
+    int64_t timestamp_ns = 0;
+    uint16_t connection = 0;
+    FrameRecorder::Direction direction = FrameRecorder::Inbound;
+    std::string_view payload; // points into the reader's mapping
+};
+
+// Sequential reader over one segment file written by FrameRecorder.
+class FrameReader
+{
+public:
+    explicit FrameReader(const std::string &path);
+    ~FrameReader();
+
+    FrameReader(const FrameReader &) = delete;
+    FrameReader &operator=(const FrameReader &) = delete;
+
+    const FrameRecorder::SegmentHeader &header() const;
+
+    // Advances to the next frame; false at the end of the written data.
+    bool next(FrameRecord &record);
+
+private:
+    const char *base = nullptr;
+    size_t length = 0;
+    size_t offset = 0;
+};
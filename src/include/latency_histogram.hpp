@@ -0,0 +1,99 @@
+#pragma once
+
+#include <json.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// HDR-style log-linear histogram of nanosecond latencies: 64 linear
+// sub-buckets per power of two (under 1.6% relative error) from 1 ns up to
+// ~36 minutes. record() is a handful of relaxed atomic adds, so any number
+// of threads can record concurrently.
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned sub_bits = 6;
+    static constexpr uint64_t sub_count = uint64_t(1) << sub_bits;
+    static constexpr unsigned max_bits = 40;
+    static constexpr size_t bucket_count = (max_bits - sub_bits + 2) * sub_count;
+
+    struct Snapshot
+    {
+        uint64_t count = 0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        uint64_t sum = 0;
+        std::vector<uint64_t> counts;
+
+        double mean() const;
+        // Upper bound of the bucket holding the given quantile (0..1), in ns.
+        uint64_t percentile(double quantile) const;
+        // count/min/max/mean/p50/p90/p99/p999 in microseconds
+        nlohmann::json to_json() const;
+    };
+
+    void record(uint64_t nanoseconds);
+    Snapshot snapshot() const;
+    void reset();
+
+    static size_t index_of(uint64_t value);
+    static uint64_t upper_bound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, bucket_count> counts{};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> min_value{UINT64_MAX};
+    std::atomic<uint64_t> max_value{0};
+};
+
+// Request/response statistics keyed by JSON-RPC method.
+class RpcMetrics
+{
+public:
+    struct Method
+    {
+        LatencyHistogram latency;  // frame written to response
+        LatencyHistogram queueing; // request issued to frame written
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> timeouts{0};
+    };
+
+    enum class Outcome
+    {
+        Ok,
+        Error,
+        Timeout
+    };
+
+    // Stats for `name`, created on first use. The pointer stays valid for
+    // the lifetime of the RpcMetrics.
+    Method &method(const std::string &name);
+
+    // Marks a request as issued; pair with finish().
+    void start(Method &method);
+    // Records how long an issued request waited (rate limiter, connect,
+    // outbound queue) before its frame was written.
+    void sent(Method &method, uint64_t queued_ns);
+    void finish(Method &method, uint64_t latency_ns, Outcome outcome);
+
+    uint64_t in_flight() const { return pending.load(std::memory_order_relaxed); }
+
+    nlohmann::json snapshot() const;
+    void reset();
+
+    void visit(const std::function<void(const std::string &, const Method &)> &visitor) const;
+    uint64_t max_in_flight() const { return max_pending.load(std::memory_order_relaxed); }
+
+private:
+    mutable std::shared_mutex mtx;
+    std::unordered_map<std::string, std::unique_ptr<Method>> methods;
+    std::atomic<uint64_t> pending{0};
+    std::atomic<uint64_t> max_pending{0};
+};
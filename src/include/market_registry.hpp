@@ -0,0 +1,122 @@
+#pragma once
+
+#include <json.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Fixed-layout market description. Strings live in the registry's pool and
+// currencies in its currency table; records are indexed by MarketId.
+struct MarketRecord
+{
+    enum Flags : uint16_t
+    {
+        Spot = 1 << 0,
+        Swap = 1 << 1,
+        Future = 1 << 2,
+        Option = 1 << 3,
+        Combo = 1 << 4,
+        Put = 1 << 5,
+        Call = 1 << 6,
+        Active = 1 << 7,
+        Linear = 1 << 8,
+    };
+
+    double tick_size = 0.0;
+    double min_amount = 0.0; // lot size
+    double contract_size = 0.0;
+    double strike = 0.0; // NaN unless an option
+    double taker = 0.0;
+    double maker = 0.0;
+    int64_t expiry = 0;
+    int64_t created = 0;
+    uint32_t name_offset = 0; // exchange instrument name
+    uint32_t symbol_offset = 0; // unified symbol
+    uint16_t name_length = 0;
+    uint16_t symbol_length = 0;
+    uint16_t base = 0; // currency ids
+    uint16_t quote = 0;
+    uint16_t settle = 0;
+    uint16_t flags = 0;
+    uint32_t reserved = 0; // explicit padding, keeps the bytes deterministic
+
+    bool is(Flags flag) const { return (flags & flag) != 0; }
+};
+
+static_assert(sizeof(MarketRecord) == 88, "MarketRecord layout is part of the cache format");
+
+// Immutable table of markets built once per load_markets(). Instrument
+// names and unified symbols are interned into one string pool, every market
+// gets a dense MarketId, and both kinds of name resolve to that id through
+// perfect hashes (hash-and-displace) built at construction, so a
+// lookup is two hash evaluations and one string compare.
+class MarketRegistry
+{
+public:
+    using MarketId = uint32_t;
+    static constexpr MarketId npos = UINT32_MAX;
+
+    MarketRegistry() = default;
+    // Takes the unified markets returned by fetch_markets(). Duplicate
+    // instrument names keep the first occurrence.
+    explicit MarketRegistry(const nlohmann::json &markets);
+    // Reload that keeps every MarketId of `previous`, so components keyed
+    // by id stay valid: its markets come first in their old order, taken
+    // from `markets` where present and otherwise kept with Active cleared
+    // (or unchanged with `keep_missing`); new markets are appended.
+    MarketRegistry(const nlohmann::json &markets, const MarketRegistry &previous, bool keep_missing = false);
+
+    size_t size() const { return records.size(); }
+    bool empty() const { return records.empty(); }
+
+    MarketId id(std::string_view instrument_name) const;
+    MarketId id_by_symbol(std::string_view symbol) const;
+
+    const MarketRecord &operator[](MarketId id) const { return records[id]; }
+    std::string_view name(MarketId id) const;
+    std::string_view symbol(MarketId id) const;
+    const std::string &currency(uint16_t currency_id) const { return currencies[currency_id]; }
+
+    // Unified market object rebuilt from the record (no "info").
+    nlohmann::json to_json(MarketId id) const;
+    nlohmann::json to_json() const;
+
+    // Heap bytes held by the registry.
+    size_t memory_bytes() const;
+
+    // Hash of the records, lookup tables and strings; equal hashes mean the
+    // same market set.
+    uint64_t content_hash() const { return digest; }
+
+    // Binary cache file: a fixed header followed by the records, hash tables
+    // and string pool exactly as held in memory, so loading is one mapping
+    // and a few copies with no parsing or hashing of names. save() writes
+    // to a temporary file and renames it into place.
+    void save(const std::string &path, int64_t saved_at_ms) const;
+    // Null if the file is missing, from another format version or corrupt.
+    static std::shared_ptr<const MarketRegistry> load(const std::string &path, int64_t *saved_at_ms = nullptr);
+
+private:
+    // Perfect hash over a fixed key set: a key's bucket picks a displacement
+    // seed that maps it to its own slot (load factor 0.8).
+    struct PerfectHash
+    {
+        std::vector<uint32_t> seeds; // by bucket
+        std::vector<MarketId> slots; // by slot
+
+        void build(const std::vector<std::string_view> &keys);
+        MarketId find(std::string_view key) const;
+    };
+
+    std::vector<MarketRecord> records;
+    std::string pool;
+    std::vector<std::string> currencies;
+    PerfectHash by_name;
+    PerfectHash by_symbol;
+    uint64_t digest = 0;
+
+    uint16_t intern_currency(const std::string &code);
+    uint64_t compute_hash() const;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Helpers for the Prometheus text exposition format (version 0.0.4).
+namespace prometheus
+{
+    // Writes the # HELP and # TYPE lines of a metric family.
+    void family(std::string &out, std::string_view name, std::string_view type, std::string_view help);
+    void sample(std::string &out, std::string_view name, double value, std::string_view labels = "");
+    // One label pair, value escaped, e.g. channel="ticker.BTC-PERPETUAL.100ms"
+    std::string label(std::string_view name, std::string_view value);
+}
+
+// Minimal HTTP endpoint on websocketpp's plain asio server role. GET
+// /metrics returns whatever `render` produces; every other path is 404.
+// The server runs on its own thread so scrapes never touch the feed thread.
+class MetricsServer
+{
+public:
+    using Render = std::function<std::string()>;
+
+    // Port 0 picks a free port; see port().
+    MetricsServer(Render render, uint16_t port, const std::string &address = "127.0.0.1");
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+
+    uint16_t port() const { return bound_port; }
+    void stop();
+
+private:
+    typedef websocketpp::server<websocketpp::config::asio> HttpServer;
+
+    Render render;
+    HttpServer server;
+    std::thread worker;
+    uint16_t bound_port = 0;
+
+    void on_http(websocketpp::connection_hdl hdl);
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <json.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "black76.hpp"
+#include "market_registry.hpp"
+
+// Options on one underlying stored column-wise, sorted by expiry then strike.
+// Quotes come from `ticker.*` notifications; reprice() re-solves bid/ask/mark
+// implied volatilities and mark greeks for the whole chain with the batch
+// Black-76 kernels. Prices are held in quote currency: inverse (coin
+// settled) quotes are multiplied by the underlying price on arrival.
+//
+// Not thread-safe: drive on_ticker() and reprice() from the same thread
+// (normally the io thread running the ticker handlers).
+class OptionsChain
+{
+public:
+    struct Columns
+    {
+        std::vector<double> strike;
+        std::vector<double> sign; // +1 call, -1 put
+        std::vector<int64_t> expiry;
+        std::vector<double> contract_size;
+
+        std::vector<double> forward;
+        std::vector<double> log_moneyness;
+        std::vector<double> bid;
+        std::vector<double> ask;
+        std::vector<double> mark;
+
+        std::vector<double> time;
+        std::vector<double> sqrt_time;
+        std::vector<double> discount;
+
+        std::vector<double> bid_iv;
+        std::vector<double> ask_iv;
+        std::vector<double> mark_iv;
+        std::vector<double> delta;
+        std::vector<double> gamma;
+        std::vector<double> vega;
+        std::vector<double> theta;
+    };
+
+    explicit OptionsChain(const std::string &underlying, double rate = 0.0);
+
+    // Adds every option market from load_markets()/fetch_markets() whose base
+    // currency is the underlying. Returns the number of options in the chain.
+    size_t load_markets(const nlohmann::json &markets);
+    size_t load_markets(const MarketRegistry &markets);
+
+    // Applies one ticker notification; false if it is not an option of this chain.
+    bool on_ticker(const nlohmann::json &ticker);
+
+    // Handler suitable for Deribit::watch_ticker / watch_tickers.
+    std::function<void(const nlohmann::json &)> handler();
+
+    void reprice(int64_t now_ms);
+
+    size_t size() const { return names.size(); }
+    const std::string &underlying() const { return underlying_currency; }
+    const std::string &instrument(size_t row) const { return names[row]; }
+    MarketRegistry::MarketId market_id(size_t row) const { return market_ids[row]; }
+    int64_t index_of(const std::string &instrument) const;
+    uint64_t updates_since_reprice() const { return pending_updates; }
+    const Columns &columns() const { return cols; }
+
+    nlohmann::json row(size_t index) const;
+
+private:
+    std::string underlying_currency;
+    double rate;
+    std::vector<std::string> names;
+    std::vector<MarketRegistry::MarketId> market_ids; // ids in the registry last loaded from
+    std::vector<uint8_t> inverse;
+    std::unordered_map<std::string, size_t> rows;
+    Columns cols;
+    uint64_t pending_updates = 0;
+
+    void resize(size_t count);
+    black76::Inputs inputs() const;
+};
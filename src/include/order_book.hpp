@@ -0,0 +1,118 @@
+#pragma once
+
+#include <json.hpp>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+struct BookLevel
+{
+    double price = 0.0;
+    double amount = 0.0;
+};
+
+// Price levels aggregated into buckets of `group` quote units.
+struct LadderView
+{
+    double group = 0.0;
+    std::vector<BookLevel> bids;
+    std::vector<BookLevel> asks;
+};
+
+// Signals derived from the top of the book. Prices are NaN when the side
+// needed to compute them is empty or too thin.
+struct BookSignals
+{
+    double best_bid = std::numeric_limits<double>::quiet_NaN();
+    double best_ask = std::numeric_limits<double>::quiet_NaN();
+    double microprice = std::numeric_limits<double>::quiet_NaN();
+    double imbalance = 0.0; // (bid_depth - ask_depth) / (bid_depth + ask_depth)
+    double bid_depth = 0.0; // amount resting in the top imbalance_levels bids
+    double ask_depth = 0.0;
+    double vwap_buy = std::numeric_limits<double>::quiet_NaN();  // average price to buy vwap_size
+    double vwap_sell = std::numeric_limits<double>::quiet_NaN(); // average price to sell vwap_size
+};
+
+// Immutable view of a book published to readers after each applied update.
+struct BookSnapshot
+{
+    std::string instrument;
+    int64_t timestamp = 0;
+    int64_t change_id = 0;
+    // False after a change_id gap until a new snapshot arrives; the levels
+    // are then the last consistent book and no longer current.
+    bool in_sync = false;
+    std::vector<BookLevel> bids;
+    std::vector<BookLevel> asks;
+    std::vector<LadderView> ladders;
+    BookSignals signals;
+};
+
+class OrderBook;
+
+// Receives every level mutation an OrderBook applies, so derived views can
+// be maintained incrementally instead of re-walking the book.
+class BookListener
+{
+public:
+    virtual ~BookListener() = default;
+
+    virtual void on_clear() = 0;
+    virtual void on_level(bool is_bid, double price, double old_amount, double new_amount) = 0;
+    virtual void on_update(const OrderBook &) {}
+};
+
+// Local order book maintained from Deribit `book.*` notifications. Handles
+// both the incremental channel (snapshot + change with prev_change_id) and
+// the grouped/depth channel, which replaces the whole book on every message.
+class OrderBook
+{
+public:
+    using BidLevels = std::map<double, double, std::greater<double>>;
+    using AskLevels = std::map<double, double>;
+
+    explicit OrderBook(const std::string &instrument = "");
+
+    // Returns false if the update was not applied because the book is out of
+    // sync (missing snapshot or a change_id gap). A new snapshot resyncs it.
+    bool apply(const nlohmann::json &data);
+    void clear();
+    // Flags the book out of sync as if a gap had been detected, e.g. when an
+    // update was lost before reaching it. Levels are kept until the snapshot.
+    void invalidate();
+
+    // Listeners are not owned and must outlive the book (or be removed).
+    void add_listener(BookListener *listener);
+    void remove_listener(BookListener *listener);
+
+    BookSnapshot snapshot(size_t depth = 0) const;
+    std::vector<BookLevel> bids(size_t depth = 0) const;
+    std::vector<BookLevel> asks(size_t depth = 0) const;
+    const BidLevels &bid_side() const { return bid_levels; }
+    const AskLevels &ask_side() const { return ask_levels; }
+
+    const std::string &instrument() const { return instrument_name; }
+    int64_t change_id() const { return last_change_id; }
+    int64_t timestamp() const { return last_timestamp; }
+    bool in_sync() const { return synced; }
+    uint64_t gaps() const { return gap_count; }
+
+private:
+    std::string instrument_name;
+    BidLevels bid_levels;
+    AskLevels ask_levels;
+    int64_t last_change_id = 0;
+    int64_t last_timestamp = 0;
+    bool synced = false;
+    uint64_t gap_count = 0;
+    std::vector<BookListener *> listeners;
+
+    template <typename Levels>
+    void apply_levels(Levels &levels, bool is_bid, const nlohmann::json &updates);
+    template <typename Levels>
+    void set_level(Levels &levels, bool is_bid, double price, double amount);
+    void reset_levels();
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "market_registry.hpp"
+#include <json.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Latest known state of each order, as the exchange reports it in
+// user.orders notifications and in the order object of RPC replies. Orders
+// are indexed by id, label, market and state; instruments resolve to their
+// MarketRegistry id, and orders of instruments the registry does not know
+// share one unresolved bucket until set_markets() installs a registry that
+// does. An update older than the
+// stored one (by last_update_timestamp) is ignored, so an RPC ack arriving
+// after the stream has moved the order on does not roll it back. Closed
+// orders are kept up to `max_closed`, oldest evicted first. Readers share a
+// lock; the io thread applying updates takes it exclusively.
+class OrderStore
+{
+public:
+    explicit OrderStore(size_t max_closed = 10000);
+
+    // Installs the registry instruments are resolved against; its ids must
+    // carry over from the previous one (see MarketRegistry).
+    void set_markets(std::shared_ptr<const MarketRegistry> registry);
+
+    // Stores a raw exchange order; false when it has no id or is stale.
+    bool apply(const nlohmann::json &order);
+    // Applies a notification payload: one order or an array of them.
+    size_t apply_all(const nlohmann::json &orders);
+    // Applies a full open-orders snapshot and evicts every stored open order
+    // it does not list, unless that order was updated after `since` (a
+    // version() taken before the snapshot was requested). Such orders closed
+    // while nothing was streaming. Returns the number evicted.
+    size_t reconcile(const nlohmann::json &open_orders, uint64_t since);
+    // Incremented by every applied update.
+    uint64_t version() const;
+
+    std::optional<nlohmann::json> find(const std::string &id) const;
+    // Open and untriggered orders, optionally for one instrument.
+    std::vector<nlohmann::json> open(const std::string &instrument = "") const;
+    std::vector<nlohmann::json> by_label(const std::string &label) const;
+    std::vector<nlohmann::json> by_instrument(const std::string &instrument) const;
+    std::vector<nlohmann::json> by_market(MarketRegistry::MarketId market) const;
+    std::vector<nlohmann::json> by_state(const std::string &state) const;
+
+    size_t size() const;
+    size_t open_count() const;
+    void clear();
+
+    static bool is_open(std::string_view state);
+
+private:
+    struct Entry
+    {
+        nlohmann::json order;
+        std::string label;
+        std::string instrument;
+        MarketRegistry::MarketId market = MarketRegistry::npos;
+        std::string state;
+        int64_t updated = 0;
+        uint64_t version = 0; // store version that last wrote the entry
+    };
+    using Index = std::unordered_map<std::string, std::unordered_set<std::string>>;
+    using MarketIndex = std::unordered_map<MarketRegistry::MarketId, std::unordered_set<std::string>>;
+
+    mutable std::shared_mutex mtx;
+    std::shared_ptr<const MarketRegistry> markets;
+    std::unordered_map<std::string, Entry> orders;
+    Index labels;
+    MarketIndex by_markets; // npos: instruments the registry does not know
+    Index states;
+    std::deque<std::string> closed; // ids in the order they closed
+    size_t max_closed;
+    uint64_t current_version = 0;
+
+    void index(Index &index, const std::string &key, const std::string &id);
+    void unindex(Index &index, const std::string &key, const std::string &id);
+    void index_market(Entry &entry, const std::string &id);
+    void unindex_market(const Entry &entry, const std::string &id);
+    MarketRegistry::MarketId resolve(const std::string &instrument) const;
+    bool matches(const Entry &entry, MarketRegistry::MarketId market, const std::string &instrument) const;
+    void erase(const std::string &id);
+    std::vector<nlohmann::json> collect(const Index &index, const std::string &key) const;
+};
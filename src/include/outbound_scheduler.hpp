@@ -0,0 +1,90 @@
+#pragma once
+
+#include <json.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Priority-ordered outbound frame queue in front of the websocket write
+// queue. Callers enqueue from any thread; frames are handed to the
+// transport on the io thread, most urgent first, and only while the
+// transport has less than `max_backlog` bytes buffered. Everything beyond
+// that waits here, where a later urgent frame can still overtake it. While
+// the transport is saturated the drain re-arms itself after `retry_delay`
+// rather than spinning on the io thread.
+//
+// Owned through a shared_ptr so posted drains can outlive their owner.
+class OutboundScheduler : public std::enable_shared_from_this<OutboundScheduler>
+{
+public:
+    enum class Priority : uint8_t
+    {
+        Urgent, // cancels
+        Normal, // orders and amends
+        Bulk    // queries and subscriptions
+    };
+
+    static constexpr size_t priority_count = 3;
+
+    // Hands one frame to the transport; false if the write failed.
+    using Writer = std::function<bool(const std::string &frame)>;
+    // Bytes the transport holds that have not reached the socket yet.
+    using Backlog = std::function<size_t()>;
+    // Runs a task on the io thread once `delay` has passed (zero: as soon
+    // as possible).
+    using Post = std::function<void(std::function<void()>, std::chrono::microseconds delay)>;
+
+    OutboundScheduler(Writer writer, Backlog backlog, Post post, size_t max_backlog = 64 * 1024,
+                      std::chrono::microseconds retry_delay = std::chrono::microseconds(250));
+
+    OutboundScheduler(const OutboundScheduler &) = delete;
+    OutboundScheduler &operator=(const OutboundScheduler &) = delete;
+
+    static Priority priority(std::string_view method);
+
+    // `on_written`, if given, runs on the io thread right after the frame has
+    // been handed to the transport; `on_failed` instead when the write failed.
+    void enqueue(Priority priority, std::string frame, std::function<void()> on_written = nullptr,
+                 std::function<void()> on_failed = nullptr);
+
+    // Drops queued frames, e.g. when the connection they were meant for
+    // closed. Returns how many were dropped.
+    size_t clear();
+
+    size_t depth() const;
+    nlohmann::json stats() const;
+
+private:
+    Writer writer;
+    Backlog backlog;
+    Post post;
+    size_t max_backlog;
+    std::chrono::microseconds retry_delay;
+
+    struct Frame
+    {
+        std::string payload;
+        std::function<void()> on_written;
+        std::function<void()> on_failed;
+    };
+
+    mutable std::mutex mtx;
+    std::array<std::deque<Frame>, priority_count> queues;
+    bool drain_scheduled = false;
+
+    std::array<uint64_t, priority_count> enqueued{};
+    std::array<uint64_t, priority_count> written{};
+    uint64_t failed = 0;
+    uint64_t dropped = 0;
+    uint64_t yields = 0;
+    size_t high_water = 0;
+
+    void schedule_drain(std::chrono::microseconds delay = std::chrono::microseconds(0));
+    void drain();
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <json.hpp>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Local model of Deribit's credit-based rate limits. Requests draw credits
+// from one of two token buckets: the matching engine pool (orders, edits,
+// cancels) or the non-matching pool (everything else). Each method falls in
+// a priority lane; within a pool a lane only takes credits when no higher
+// lane is waiting, and orders leave `cancel_reserve` credits untouched so a
+// cancel always has room. When credits run out a request waits up to its
+// lane's max wait and is then rejected.
+//
+// Config (all optional):
+//   {"matching": {"capacity": 10000, "refill": 2500},
+//    "non_matching": {"capacity": 50000, "refill": 10000},
+//    "default_cost": 500, "cancel_reserve": 1000,
+//    "costs": {"private/get_transaction_log": 10000},
+//    "max_wait_ms": {"cancel": 2000, "order": 500, "query": 5000}}
+// Refill is in credits per second.
+class RateLimiter
+{
+public:
+    enum class Lane : uint8_t
+    {
+        Cancel,
+        Order,
+        Query
+    };
+
+    enum class Pool : uint8_t
+    {
+        Matching,
+        NonMatching
+    };
+
+    static constexpr size_t lane_count = 3;
+    static constexpr size_t pool_count = 2;
+
+    explicit RateLimiter(const nlohmann::json &config = nlohmann::json::object());
+
+    RateLimiter(const RateLimiter &) = delete;
+    RateLimiter &operator=(const RateLimiter &) = delete;
+
+    static Lane lane(std::string_view method);
+    static Pool pool(Lane lane) { return lane == Lane::Query ? Pool::NonMatching : Pool::Matching; }
+    double cost(std::string_view method) const;
+
+    // Takes the method's credits, waiting up to its lane's max wait.
+    // Returns false when the request is rejected.
+    bool acquire(std::string_view method);
+    // Takes the credits only if they are available right now.
+    bool try_acquire(std::string_view method);
+
+    // Credits left in a pool after refill.
+    double credits(Pool pool) const;
+
+    nlohmann::json stats() const;
+
+private:
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    struct Bucket
+    {
+        double capacity = 0.0;
+        double refill = 0.0; // credits per second
+        double credits = 0.0;
+        uint64_t updated = 0; // TscClock ticks
+        std::array<uint32_t, lane_count> waiting{};
+        std::condition_variable cv;
+    };
+
+    struct LaneStats
+    {
+        uint64_t granted = 0;
+        uint64_t delayed = 0;
+        uint64_t rejected = 0;
+    };
+
+    mutable std::mutex mtx;
+    mutable std::array<Bucket, pool_count> buckets;
+    std::array<LaneStats, lane_count> lane_stats;
+    std::array<int64_t, lane_count> max_wait_ms{2000, 500, 5000};
+    double default_cost = 500.0;
+    double cancel_reserve = 1000.0;
+    std::unordered_map<std::string, double, Hash, std::equal_to<>> costs;
+
+    void refill(Bucket &bucket) const;
+    bool take(std::string_view method, bool wait);
+};
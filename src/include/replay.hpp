@@ -0,0 +1,50 @@
+#pragma once
+
+#include <json.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "deribit.hpp"
+
+struct ReplayOptions
+{
+    // 0 replays as fast as possible, 1 at the recorded pace, 2 twice as fast...
+    double speed = 0.0;
+    // Only frames from this connection id; -1 replays all of them.
+    int connection = -1;
+};
+
+struct ReplayStats
+{
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    double wall_seconds = 0.0;
+    double recorded_seconds = 0.0;
+
+    double frames_per_second() const;
+    double megabytes_per_second() const;
+    nlohmann::json to_json() const;
+};
+
+// Feeds the inbound frames of FrameRecorder segments back through a sink,
+// normally Deribit::handle_message on a client built with "offline": true,
+// so recorded traffic runs through the same parsing and dispatch code as
+// live traffic. Outbound frames are skipped.
+class ReplayDriver
+{
+public:
+    using Sink = std::function<void(std::string_view payload)>;
+
+    explicit ReplayDriver(Sink sink);
+    explicit ReplayDriver(Deribit &client);
+
+    ReplayStats run(const std::vector<std::string> &segments, const ReplayOptions &options = ReplayOptions());
+
+    // Segment files of one recording in replay order.
+    static std::vector<std::string> segments(const std::string &directory, const std::string &prefix = "deribit");
+
+private:
+    Sink sink;
+};
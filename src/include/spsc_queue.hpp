@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+// Bounded single-producer/single-consumer ring buffer. One thread may call
+// try_push and one (other) thread may call try_pop; no locks are taken.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        mask = size - 1;
+        slots.reset(new std::optional<T>[size]);
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    bool try_push(T &&value)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - cached_tail > mask)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h - cached_tail > mask)
+            {
+                return false;
+            }
+        }
+        slots[h & mask].emplace(std::move(value));
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &out)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == cached_head)
+        {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t == cached_head)
+            {
+                return false;
+            }
+        }
+        std::optional<T> &slot = slots[t & mask];
+        out = std::move(*slot);
+        slot.reset();
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    static constexpr size_t cache_line = 64;
+
+    size_t mask = 0;
+    std::unique_ptr<std::optional<T>[]> slots;
+
+    alignas(cache_line) std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+    alignas(cache_line) std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <json.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Channel name -> handlers table shared between the threads calling watch_*
+// and the io thread dispatching notifications. Channel names are interned
+// to stable integer ids; the table is copy-on-write, so dispatch() reads an
+// immutable snapshot without locking while writers (serialized by a mutex)
+// publish a modified copy. A registration covers one or more channels and
+// is identified by the HandlerId returned from add().
+class SubscriptionRegistry
+{
+public:
+    using Handler = std::function<void(const nlohmann::json &)>;
+    using HandlerId = uint64_t;
+    using ChannelId = uint32_t;
+
+    // Per-channel traffic counters, created when a channel is first
+    // registered and kept for the registry's lifetime.
+    struct ChannelStats
+    {
+        std::atomic<uint64_t> messages{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    SubscriptionRegistry();
+
+    // Adds `handler` to every channel. Channels that had no handler before
+    // are appended to `activated` when given.
+    HandlerId add(const std::vector<std::string> &channels, Handler handler, std::vector<std::string> *activated = nullptr);
+
+    // Removes one registration from all its channels. Channels left without
+    // handlers are appended to `deactivated` when given.
+    bool remove(HandlerId id, std::vector<std::string> *deactivated = nullptr);
+
+    // Drops every handler on the given channels; appends the ones that had
+    // handlers to `deactivated` when given.
+    size_t remove_channels(const std::vector<std::string> &channels, std::vector<std::string> *deactivated = nullptr);
+
+    // Invokes every handler of `channel` with `data`; returns how many ran.
+    size_t dispatch(std::string_view channel, const nlohmann::json &data) const;
+
+    // Inbound hot path: counts one message of `bytes` against `channel` and,
+    // when `data` is given, runs its handlers, all from a single lookup.
+    // Returns false if the channel has never been registered.
+    bool route(std::string_view channel, size_t bytes, const nlohmann::json *data = nullptr) const;
+
+    // Interned id of a channel, or -1 if it has never been registered.
+    int64_t channel_id(std::string_view channel) const;
+
+    size_t handler_count(std::string_view channel) const;
+    std::vector<std::string> active_channels() const;
+
+    // Counters of a registered channel (lock-free lookup), or nullptr.
+    ChannelStats *stats(std::string_view channel) const;
+    void visit_stats(const std::function<void(const std::string &, const ChannelStats &)> &visitor) const;
+
+private:
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    struct Entry
+    {
+        HandlerId id;
+        std::shared_ptr<const Handler> handler;
+    };
+
+    struct Table
+    {
+        std::unordered_map<std::string, ChannelId, Hash, std::equal_to<>> ids;
+        std::vector<std::string> names;          // by ChannelId
+        std::vector<std::vector<Entry>> entries; // by ChannelId
+        std::vector<std::shared_ptr<ChannelStats>> stats; // by ChannelId
+
+        const std::vector<Entry> *find(std::string_view channel) const;
+    };
+
+    std::mutex write_mtx;
+    HandlerId next_id = 1;
+    std::atomic<std::shared_ptr<const Table>> table;
+
+    std::shared_ptr<const Table> current() const;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Cheap timestamp source for hot-path instrumentation. ticks() reads the
+// CPU's invariant counter (rdtsc on x86, cntvct_el0 on AArch64,
+// steady_clock elsewhere) in a few nanoseconds; ticks are turned into
+// nanoseconds or epoch time only when needed. The tick rate is measured
+// against steady_clock, so wall clock steps never skew durations;
+// system_clock only anchors epoch time. A background thread refreshes both
+// every `recalibrate_interval`, so conversions only ever read the published
+// anchor.
+class TscClock
+{
+public:
+    static inline uint64_t ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t value;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    static TscClock &instance();
+
+    // Epoch nanoseconds of a ticks() reading.
+    int64_t to_epoch_ns(uint64_t ticks) const;
+    // Nanoseconds spanned by a ticks() difference.
+    uint64_t to_ns(uint64_t elapsed_ticks) const;
+
+    int64_t epoch_ns() const { return to_epoch_ns(ticks()); }
+    int64_t epoch_ms() const { return epoch_ns() / 1000000; }
+
+    // Re-anchors to system_clock now and refines the tick rate against
+    // steady_clock over the whole interval since construction.
+    void calibrate() const;
+
+    double ticks_per_ns() const { return 1.0 / ns_per_tick.load(std::memory_order_relaxed); }
+    // Anchors published since construction.
+    uint64_t calibrations() const { return sequence.load(std::memory_order_relaxed) / 2; }
+
+    static constexpr std::chrono::milliseconds recalibrate_interval{1000};
+
+private:
+    TscClock();
+    ~TscClock();
+
+    uint64_t origin_ticks = 0;
+    int64_t origin_steady_ns = 0;
+
+    // Anchor published under a seqlock; readers retry if it changes mid-read
+    mutable std::atomic<uint64_t> sequence{0};
+    mutable std::atomic<uint64_t> anchor_ticks{0};
+    mutable std::atomic<int64_t> anchor_ns{0};
+    mutable std::atomic<double> ns_per_tick{1.0};
+    mutable std::atomic_flag calibrating = ATOMIC_FLAG_INIT;
+
+    std::mutex refresh_mutex;
+    std::condition_variable refresh_cv;
+    bool stopping = false;
+    std::thread refresher;
+
+    struct Sample
+    {
+        uint64_t ticks = 0;
+        int64_t steady_ns = 0;
+        int64_t epoch_ns = 0;
+    };
+    static Sample sample();
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <json.hpp>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include "options_chain.hpp"
+#include "thread_pool.hpp"
+
+// Raw SVI parameterisation of total implied variance against log-moneyness
+// k = ln(K / F):  w(k) = a + b * (rho * (k - m) + sqrt((k - m)^2 + sigma^2))
+struct SviParams
+{
+    double a = 0.0;
+    double b = 0.1;
+    double rho = 0.0;
+    double m = 0.0;
+    double sigma = 0.1;
+
+    double total_variance(double k) const;
+};
+
+struct SmileFit
+{
+    int64_t expiry = 0;
+    double time = 0.0; // years to expiry at fit time
+    SviParams params;
+    double rmse = 0.0; // in implied vol units
+    size_t points = 0;
+    uint64_t fits = 0; // times this expiry has been (re)fitted
+
+    double implied_vol(double log_moneyness) const;
+};
+
+// Immutable fitted surface handed to readers.
+struct VolSurface
+{
+    int64_t timestamp = 0;
+    std::vector<SmileFit> smiles; // sorted by expiry
+
+    const SmileFit *smile(int64_t expiry) const;
+    nlohmann::json to_json() const;
+};
+
+struct SmileQuotes
+{
+    std::vector<double> log_moneyness;
+    std::vector<double> iv;
+    std::vector<double> weight;
+};
+
+// Fits one SVI smile per expiry of an OptionsChain in parallel. Each fit is
+// warm-started from the previous parameters, and an expiry is only refitted
+// when its current quotes deviate from the existing fit by more than
+// `refit_threshold` (RMSE in vol units).
+class SurfaceEngine
+{
+public:
+    explicit SurfaceEngine(size_t threads = 0, double refit_threshold = 0.002);
+
+    // Reads OTM implied vols from a repriced chain and refits changed expiries.
+    // Returns the number of expiries refitted. Call from the thread that owns
+    // the chain; the fits themselves run on the engine's pool.
+    size_t update(const OptionsChain &chain, int64_t now_ms);
+
+    // Latest published surface; safe to call from any thread.
+    std::shared_ptr<const VolSurface> surface() const;
+
+    static SmileFit fit_smile(int64_t expiry, double time, const SmileQuotes &quotes, const SviParams *start);
+
+private:
+    ThreadPool pool;
+    double refit_threshold;
+    std::map<int64_t, SmileFit> fits;
+    std::atomic<std::shared_ptr<const VolSurface>> published;
+
+    static double quote_rmse(const SmileFit &fit, const SmileQuotes &quotes);
+};
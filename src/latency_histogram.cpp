@@ -0,0 +1,205 @@
+#include "include/latency_histogram.hpp"
+#include <bit>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+size_t LatencyHistogram::index_of(uint64_t value)
+{
+    if (value < 2 * sub_count)
+    {
+        return value;
+    }
+    unsigned msb = std::bit_width(value) - 1;
+    if (msb > max_bits)
+    {
+        return bucket_count - 1;
+    }
+    unsigned shift = msb - sub_bits;
+    return shift * sub_count + (value >> shift);
+}
+
+uint64_t LatencyHistogram::upper_bound(size_t index)
+{
+    if (index < 2 * sub_count)
+    {
+        return index;
+    }
+    uint64_t shift = index / sub_count - 1;
+    uint64_t mantissa = index - shift * sub_count;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds)
+{
+    counts[index_of(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    uint64_t seen = min_value.load(std::memory_order_relaxed);
+    while (nanoseconds < seen && !min_value.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+    seen = max_value.load(std::memory_order_relaxed);
+    while (nanoseconds > seen && !max_value.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot result;
+    result.counts.resize(bucket_count);
+    for (size_t i = 0; i < bucket_count; ++i)
+    {
+        result.counts[i] = counts[i].load(std::memory_order_relaxed);
+        result.count += result.counts[i];
+    }
+    result.sum = sum.load(std::memory_order_relaxed);
+    result.max = max_value.load(std::memory_order_relaxed);
+    uint64_t low = min_value.load(std::memory_order_relaxed);
+    result.min = result.count > 0 ? low : 0;
+    return result;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &count : counts)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+    sum.store(0, std::memory_order_relaxed);
+    min_value.store(UINT64_MAX, std::memory_order_relaxed);
+    max_value.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::Snapshot::mean() const
+{
+    return count > 0 ? static_cast<double>(sum) / count : 0.0;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double quantile) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * count));
+    rank = rank == 0 ? 1 : rank;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            return std::min(upper_bound(i), max);
+        }
+    }
+    return max;
+}
+
+nlohmann::json LatencyHistogram::Snapshot::to_json() const
+{
+    return {{"count", count},
+            {"minUs", min / 1e3},
+            {"maxUs", max / 1e3},
+            {"meanUs", mean() / 1e3},
+            {"p50Us", percentile(0.5) / 1e3},
+            {"p90Us", percentile(0.9) / 1e3},
+            {"p99Us", percentile(0.99) / 1e3},
+            {"p999Us", percentile(0.999) / 1e3}};
+}
+
+RpcMetrics::Method &RpcMetrics::method(const std::string &name)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        auto it = methods.find(name);
+        if (it != methods.end())
+        {
+            return *it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    auto &slot = methods[name];
+    if (!slot)
+    {
+        slot = std::make_unique<Method>();
+    }
+    return *slot;
+}
+
+void RpcMetrics::start(Method &method)
+{
+    method.requests.fetch_add(1, std::memory_order_relaxed);
+    uint64_t depth = pending.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint64_t seen = max_pending.load(std::memory_order_relaxed);
+    while (depth > seen && !max_pending.compare_exchange_weak(seen, depth, std::memory_order_relaxed))
+    {
+    }
+}
+
+void RpcMetrics::sent(Method &method, uint64_t queued_ns)
+{
+    method.queueing.record(queued_ns);
+}
+
+void RpcMetrics::finish(Method &method, uint64_t latency_ns, Outcome outcome)
+{
+    pending.fetch_sub(1, std::memory_order_relaxed);
+    switch (outcome)
+    {
+    case Outcome::Ok:
+        method.latency.record(latency_ns);
+        break;
+    case Outcome::Error:
+        // Error replies still measure the exchange round trip
+        method.latency.record(latency_ns);
+        method.errors.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Outcome::Timeout:
+        method.timeouts.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+}
+
+nlohmann::json RpcMetrics::snapshot() const
+{
+    nlohmann::json result;
+    result["inFlight"] = pending.load(std::memory_order_relaxed);
+    result["maxInFlight"] = max_pending.load(std::memory_order_relaxed);
+    result["methods"] = nlohmann::json::object();
+
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    for (const auto &[name, method] : methods)
+    {
+        result["methods"][name] = {{"requests", method->requests.load(std::memory_order_relaxed)},
+                                   {"errors", method->errors.load(std::memory_order_relaxed)},
+                                   {"timeouts", method->timeouts.load(std::memory_order_relaxed)},
+                                   {"latency", method->latency.snapshot().to_json()},
+                                   {"queueing", method->queueing.snapshot().to_json()}};
+    }
+    return result;
+}
+
+void RpcMetrics::reset()
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    for (auto &[name, method] : methods)
+    {
+        method->latency.reset();
+        method->queueing.reset();
+        method->requests.store(0, std::memory_order_relaxed);
+        method->errors.store(0, std::memory_order_relaxed);
+        method->timeouts.store(0, std::memory_order_relaxed);
+    }
+    max_pending.store(pending.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void RpcMetrics::visit(const std::function<void(const std::string &, const Method &)> &visitor) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    for (const auto &[name, method] : methods)
+    {
+        visitor(name, *method);
+    }
+}
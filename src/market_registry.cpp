@@ -0,0 +1,544 @@
+#include "include/market_registry.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr uint32_t max_seed = 1 << 20;
+
+    uint64_t hash(std::string_view key, uint64_t seed)
+    {
+        // FNV-1a over the bytes, then a murmur finalizer so every bit of the
+        // seed reaches the low bits used for the modulo
+        uint64_t h = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+        for (unsigned char c : key)
+        {
+            h = (h ^ c) * 1099511628211ull;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    constexpr char cache_magic[8] = {'D', 'R', 'B', 'M', 'K', 'T', 'S', '\0'};
+    constexpr uint32_t cache_version = 1;
+
+    struct CacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t content_hash;
+        int64_t saved_at_ms;
+        uint64_t records;
+        uint64_t name_buckets;
+        uint64_t name_slots;
+        uint64_t symbol_buckets;
+        uint64_t symbol_slots;
+        uint64_t pool_bytes;
+        uint64_t currency_bytes;
+    };
+
+    static_assert(sizeof(CacheHeader) == 88, "cache header layout changed");
+
+    // Word-at-a-time multiplicative hash for content comparison
+    uint64_t hash_bytes(const void *data, size_t length, uint64_t h)
+    {
+        const char *bytes = static_cast<const char *>(data);
+        for (; length >= 8; bytes += 8, length -= 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes, 8);
+            h = (h ^ word) * 0x9e3779b97f4a7c15ull;
+            h ^= h >> 29;
+        }
+        uint64_t tail = 0;
+        std::memcpy(&tail, bytes, length);
+        h = (h ^ tail ^ length) * 0x9e3779b97f4a7c15ull;
+        return h ^ (h >> 32);
+    }
+
+    std::string join_currencies(const std::vector<std::string> &currencies)
+    {
+        std::string joined;
+        for (const auto &code : currencies)
+        {
+            joined += code;
+            joined += '\0';
+        }
+        return joined;
+    }
+
+    double number(const nlohmann::json &object, const char *key)
+    {
+        auto it = object.find(key);
+        return it != object.end() && it->is_number() ? it->get<double>() : NAN;
+    }
+
+    std::string text(const nlohmann::json &object, const char *key)
+    {
+        auto it = object.find(key);
+        return it != object.end() && it->is_string() ? it->get<std::string>() : std::string();
+    }
+
+    bool flag(const nlohmann::json &object, const char *key)
+    {
+        auto it = object.find(key);
+        return it != object.end() && it->is_boolean() && it->get<bool>();
+    }
+
+    nlohmann::json number_or_null(double value)
+    {
+        return std::isnan(value) ? nlohmann::json() : nlohmann::json(value);
+    }
+
+    // Input for the reload constructor: `previous` ids first, then new markets
+    nlohmann::json stable_order(const nlohmann::json &markets, const MarketRegistry &previous, bool keep_missing)
+    {
+        std::unordered_map<std::string, const nlohmann::json *> fetched;
+        for (const auto &market : markets)
+        {
+            std::string id = text(market, "id");
+            if (!id.empty())
+            {
+                fetched.emplace(std::move(id), &market);
+            }
+        }
+
+        nlohmann::json ordered = nlohmann::json::array();
+        for (MarketRegistry::MarketId id = 0; id < previous.size(); ++id)
+        {
+            auto it = fetched.find(std::string(previous.name(id)));
+            if (it != fetched.end())
+            {
+                ordered.push_back(*it->second);
+                continue;
+            }
+            nlohmann::json retired = previous.to_json(id);
+            if (!keep_missing)
+            {
+                retired["active"] = false;
+            }
+            ordered.push_back(std::move(retired));
+        }
+        for (const auto &market : markets)
+        {
+            if (previous.id(text(market, "id")) == MarketRegistry::npos)
+            {
+                ordered.push_back(market);
+            }
+        }
+        return ordered;
+    }
+}
+
+void MarketRegistry::PerfectHash::build(const std::vector<std::string_view> &keys)
+{
+    size_t count = keys.size();
+    size_t bucket_count = count / 2 + 1;
+    size_t slot_count = count + count / 4 + 1;
+    seeds.assign(bucket_count, 0);
+    slots.assign(slot_count, npos);
+
+    std::vector<std::vector<MarketId>> buckets(bucket_count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        buckets[hash(keys[i], 0) % bucket_count].push_back(static_cast<MarketId>(i));
+    }
+    std::vector<size_t> order(bucket_count);
+    for (size_t i = 0; i < bucket_count; ++i)
+    {
+        order[i] = i;
+    }
+    // Place the crowded buckets first while most slots are still free
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b)
+                     { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<size_t> placed;
+    for (size_t bucket : order)
+    {
+        const auto &members = buckets[bucket];
+        if (members.empty())
+        {
+            break;
+        }
+        uint32_t seed = 1;
+        for (; seed < max_seed; ++seed)
+        {
+            placed.clear();
+            bool fits = true;
+            for (MarketId key : members)
+            {
+                size_t slot = hash(keys[key], seed) % slot_count;
+                if (slots[slot] != npos || std::find(placed.begin(), placed.end(), slot) != placed.end())
+                {
+                    fits = false;
+                    break;
+                }
+                placed.push_back(slot);
+            }
+            if (fits)
+            {
+                break;
+            }
+        }
+        if (seed == max_seed)
+        {
+            throw std::runtime_error("MarketRegistry: could not build perfect hash (duplicate keys?)");
+        }
+        seeds[bucket] = seed;
+        for (size_t i = 0; i < members.size(); ++i)
+        {
+            slots[placed[i]] = members[i];
+        }
+    }
+}
+
+MarketRegistry::MarketId MarketRegistry::PerfectHash::find(std::string_view key) const
+{
+    if (seeds.empty())
+    {
+        return npos;
+    }
+    uint32_t seed = seeds[hash(key, 0) % seeds.size()];
+    return seed == 0 ? npos : slots[hash(key, seed) % slots.size()];
+}
+
+uint16_t MarketRegistry::intern_currency(const std::string &code)
+{
+    auto it = std::find(currencies.begin(), currencies.end(), code);
+    if (it != currencies.end())
+    {
+        return static_cast<uint16_t>(it - currencies.begin());
+    }
+    currencies.push_back(code);
+    return static_cast<uint16_t>(currencies.size() - 1);
+}
+
+MarketRegistry::MarketRegistry(const nlohmann::json &markets)
+{
+    // Duplicates would defeat the perfect hash, so later copies are dropped
+    std::unordered_set<std::string> seen;
+    records.reserve(markets.size());
+    for (const auto &market : markets)
+    {
+        std::string id = text(market, "id");
+        if (id.empty() || !seen.insert(id).second)
+        {
+            continue;
+        }
+        std::string symbol = text(market, "symbol");
+
+        MarketRecord record;
+        auto precision = market.find("precision");
+        if (precision != market.end() && precision->is_object())
+        {
+            record.tick_size = number(*precision, "price");
+            record.min_amount = number(*precision, "amount");
+        }
+        record.contract_size = number(market, "contractSize");
+        record.strike = number(market, "strike");
+        record.taker = number(market, "taker");
+        record.maker = number(market, "maker");
+        record.expiry = market.value("expiry", int64_t(0));
+        record.created = market.value("created", int64_t(0));
+        record.base = intern_currency(text(market, "base"));
+        record.quote = intern_currency(text(market, "quote"));
+        record.settle = intern_currency(text(market, "settle"));
+
+        std::string option_type = text(market, "optionType");
+        uint16_t flags = 0;
+        flags |= flag(market, "spot") ? MarketRecord::Spot : 0;
+        flags |= flag(market, "swap") ? MarketRecord::Swap : 0;
+        flags |= flag(market, "future") ? MarketRecord::Future : 0;
+        flags |= flag(market, "option") ? MarketRecord::Option : 0;
+        flags |= symbol == id && !flag(market, "spot") ? MarketRecord::Combo : 0;
+        flags |= option_type == "put" ? MarketRecord::Put : 0;
+        flags |= option_type == "call" ? MarketRecord::Call : 0;
+        flags |= market.value("active", true) ? MarketRecord::Active : 0;
+        flags |= flag(market, "linear") || !flag(market, "inverse") ? MarketRecord::Linear : 0;
+        record.flags = flags;
+
+        record.name_offset = static_cast<uint32_t>(pool.size());
+        record.name_length = static_cast<uint16_t>(id.size());
+        pool += id;
+        record.symbol_offset = static_cast<uint32_t>(pool.size());
+        record.symbol_length = static_cast<uint16_t>(symbol.size());
+        pool += symbol;
+        records.push_back(record);
+    }
+    records.shrink_to_fit();
+    pool.shrink_to_fit();
+
+    // The pool no longer moves, so views into it can serve as keys
+    std::vector<std::string_view> names;
+    std::vector<std::string_view> symbol_keys;
+    std::vector<MarketId> symbol_ids;
+    std::unordered_set<std::string_view> seen_symbols;
+    for (MarketId id = 0; id < records.size(); ++id)
+    {
+        names.push_back(name(id));
+        if (seen_symbols.insert(symbol(id)).second)
+        {
+            symbol_keys.push_back(symbol(id));
+            symbol_ids.push_back(id);
+        }
+    }
+
+    by_name.build(names);
+    by_symbol.build(symbol_keys);
+    // Symbol slots hold positions in symbol_keys; translate them to market ids
+    for (auto &slot : by_symbol.slots)
+    {
+        if (slot != npos)
+        {
+            slot = symbol_ids[slot];
+        }
+    }
+    digest = compute_hash();
+}
+
+MarketRegistry::MarketRegistry(const nlohmann::json &markets, const MarketRegistry &previous, bool keep_missing)
+    : MarketRegistry(stable_order(markets, previous, keep_missing))
+{
+}
+
+MarketRegistry::MarketId MarketRegistry::id(std::string_view instrument_name) const
+{
+    MarketId candidate = by_name.find(instrument_name);
+    return candidate != npos && name(candidate) == instrument_name ? candidate : npos;
+}
+
+MarketRegistry::MarketId MarketRegistry::id_by_symbol(std::string_view symbol_name) const
+{
+    MarketId candidate = by_symbol.find(symbol_name);
+    return candidate != npos && symbol(candidate) == symbol_name ? candidate : npos;
+}
+
+std::string_view MarketRegistry::name(MarketId id) const
+{
+    const MarketRecord &record = records[id];
+    return std::string_view(pool.data() + record.name_offset, record.name_length);
+}
+
+std::string_view MarketRegistry::symbol(MarketId id) const
+{
+    const MarketRecord &record = records[id];
+    return std::string_view(pool.data() + record.symbol_offset, record.symbol_length);
+}
+
+nlohmann::json MarketRegistry::to_json(MarketId id) const
+{
+    const MarketRecord &r = records[id];
+    bool spot = r.is(MarketRecord::Spot);
+    std::string type = "swap";
+    if (r.is(MarketRecord::Future))
+        type = "future";
+    else if (r.is(MarketRecord::Option))
+        type = "option";
+    else if (spot)
+        type = "spot";
+
+    nlohmann::json option_type;
+    if (r.is(MarketRecord::Call))
+        option_type = "call";
+    else if (r.is(MarketRecord::Put))
+        option_type = "put";
+
+    return {
+        {"id", std::string(name(id))},
+        {"symbol", std::string(symbol(id))},
+        {"base", currencies[r.base]},
+        {"quote", currencies[r.quote]},
+        {"settle", currencies[r.settle]},
+        {"baseId", currencies[r.base]},
+        {"quoteId", currencies[r.quote]},
+        {"settleId", currencies[r.settle]},
+        {"type", type},
+        {"spot", spot},
+        {"margin", false},
+        {"swap", r.is(MarketRecord::Swap)},
+        {"future", r.is(MarketRecord::Future)},
+        {"option", r.is(MarketRecord::Option)},
+        {"active", r.is(MarketRecord::Active)},
+        {"contract", !spot},
+        {"linear", r.is(MarketRecord::Linear)},
+        {"inverse", !r.is(MarketRecord::Linear)},
+        {"taker", r.taker},
+        {"maker", r.maker},
+        {"contractSize", r.contract_size},
+        {"expiry", r.expiry},
+        {"expiryDatetime", r.expiry > 0 ? std::to_string(r.expiry) : ""},
+        {"strike", number_or_null(r.strike)},
+        {"optionType", option_type},
+        {"precision", {{"amount", r.min_amount}, {"price", r.tick_size}}},
+        {"limits", {{"leverage", {{"min", nullptr}, {"max", nullptr}}}, {"amount", {{"min", r.min_amount}, {"max", nullptr}}}, {"price", {{"min", r.tick_size}, {"max", nullptr}}}, {"cost", {{"min", nullptr}, {"max", nullptr}}}}},
+        {"created", r.created}};
+}
+
+nlohmann::json MarketRegistry::to_json() const
+{
+    nlohmann::json result = nlohmann::json::array();
+    for (MarketId id = 0; id < records.size(); ++id)
+    {
+        result.push_back(to_json(id));
+    }
+    return result;
+}
+
+size_t MarketRegistry::memory_bytes() const
+{
+    size_t bytes = records.capacity() * sizeof(MarketRecord) + pool.capacity();
+    for (const auto &code : currencies)
+    {
+        bytes += sizeof(std::string) + (code.capacity() > 15 ? code.capacity() : 0);
+    }
+    for (const PerfectHash *table : {&by_name, &by_symbol})
+    {
+        bytes += table->seeds.capacity() * sizeof(uint32_t) + table->slots.capacity() * sizeof(MarketId);
+    }
+    return bytes;
+}
+
+uint64_t MarketRegistry::compute_hash() const
+{
+    uint64_t h = hash_bytes(records.data(), records.size() * sizeof(MarketRecord), 0x6d61726b657473ull);
+    for (const PerfectHash *table : {&by_name, &by_symbol})
+    {
+        h = hash_bytes(table->seeds.data(), table->seeds.size() * sizeof(uint32_t), h);
+        h = hash_bytes(table->slots.data(), table->slots.size() * sizeof(MarketId), h);
+    }
+    h = hash_bytes(pool.data(), pool.size(), h);
+    std::string joined = join_currencies(currencies);
+    return hash_bytes(joined.data(), joined.size(), h);
+}
+
+void MarketRegistry::save(const std::string &path, int64_t saved_at_ms) const
+{
+    std::string joined = join_currencies(currencies);
+    CacheHeader header = {};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_version;
+    header.record_size = sizeof(MarketRecord);
+    header.content_hash = digest;
+    header.saved_at_ms = saved_at_ms;
+    header.records = records.size();
+    header.name_buckets = by_name.seeds.size();
+    header.name_slots = by_name.slots.size();
+    header.symbol_buckets = by_symbol.seeds.size();
+    header.symbol_slots = by_symbol.slots.size();
+    header.pool_bytes = pool.size();
+    header.currency_bytes = joined.size();
+
+    std::string temporary = path + ".tmp";
+    FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (!file)
+    {
+        throw std::runtime_error("Failed to create market cache " + temporary + ": " + std::strerror(errno));
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    auto write = [&](const void *data, size_t bytes)
+    {
+        ok = ok && (bytes == 0 || std::fwrite(data, bytes, 1, file) == 1);
+    };
+    write(records.data(), records.size() * sizeof(MarketRecord));
+    write(by_name.seeds.data(), by_name.seeds.size() * sizeof(uint32_t));
+    write(by_name.slots.data(), by_name.slots.size() * sizeof(MarketId));
+    write(by_symbol.seeds.data(), by_symbol.seeds.size() * sizeof(uint32_t));
+    write(by_symbol.slots.data(), by_symbol.slots.size() * sizeof(MarketId));
+    write(pool.data(), pool.size());
+    write(joined.data(), joined.size());
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Failed to write market cache " + path);
+    }
+}
+
+std::shared_ptr<const MarketRegistry> MarketRegistry::load(const std::string &path, int64_t *saved_at_ms)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CacheHeader))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    size_t length = st.st_size;
+    void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    const char *base = static_cast<const char *>(mapped);
+
+    CacheHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    size_t expected = sizeof(header) + header.records * sizeof(MarketRecord) +
+                      (header.name_buckets + header.name_slots + header.symbol_buckets + header.symbol_slots) * sizeof(uint32_t) +
+                      header.pool_bytes + header.currency_bytes;
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != cache_version ||
+        header.record_size != sizeof(MarketRecord) || expected != length)
+    {
+        ::munmap(mapped, length);
+        return nullptr;
+    }
+
+    auto registry = std::make_shared<MarketRegistry>();
+    const char *cursor = base + sizeof(header);
+    auto read = [&cursor](auto &vector, size_t count)
+    {
+        using Value = typename std::decay_t<decltype(vector)>::value_type;
+        vector.resize(count);
+        std::memcpy(vector.data(), cursor, count * sizeof(Value));
+        cursor += count * sizeof(Value);
+    };
+    read(registry->records, header.records);
+    read(registry->by_name.seeds, header.name_buckets);
+    read(registry->by_name.slots, header.name_slots);
+    read(registry->by_symbol.seeds, header.symbol_buckets);
+    read(registry->by_symbol.slots, header.symbol_slots);
+    registry->pool.assign(cursor, header.pool_bytes);
+    cursor += header.pool_bytes;
+    for (const char *code = cursor, *end = cursor + header.currency_bytes; code < end;)
+    {
+        const char *terminator = static_cast<const char *>(std::memchr(code, '\0', end - code));
+        if (!terminator)
+        {
+            break;
+        }
+        registry->currencies.emplace_back(code, terminator);
+        code = terminator + 1;
+    }
+    ::munmap(mapped, length);
+
+    registry->digest = registry->compute_hash();
+    if (registry->digest != header.content_hash)
+    {
+        return nullptr;
+    }
+    if (saved_at_ms)
+    {
+        *saved_at_ms = header.saved_at_ms;
+    }
+    return registry;
+}
@@ -0,0 +1,128 @@
+#include "include/metrics_server.hpp"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace prometheus
+{
+    void family(std::string &out, std::string_view name, std::string_view type, std::string_view help)
+    {
+        out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+        out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+    }
+
+    void sample(std::string &out, std::string_view name, double value, std::string_view labels)
+    {
+        out.append(name);
+        if (!labels.empty())
+        {
+            out.append("{").append(labels).append("}");
+        }
+        char buffer[32];
+        if (std::isnan(value))
+        {
+            std::snprintf(buffer, sizeof(buffer), " NaN\n");
+        }
+        else if (value == std::floor(value) && std::abs(value) < 1e15)
+        {
+            std::snprintf(buffer, sizeof(buffer), " %.0f\n", value);
+        }
+        else
+        {
+            std::snprintf(buffer, sizeof(buffer), " %.9g\n", value);
+        }
+        out.append(buffer);
+    }
+
+    std::string label(std::string_view name, std::string_view value)
+    {
+        std::string result(name);
+        result.append("=\"");
+        for (char c : value)
+        {
+            if (c == '\\' || c == '"')
+            {
+                result.push_back('\\');
+                result.push_back(c);
+            }
+            else if (c == '\n')
+            {
+                result.append("\\n");
+            }
+            else
+            {
+                result.push_back(c);
+            }
+        }
+        result.push_back('"');
+        return result;
+    }
+}
+
+MetricsServer::MetricsServer(Render render, uint16_t port, const std::string &address)
+    : render(std::move(render))
+{
+    server.clear_access_channels(websocketpp::log::alevel::all);
+    server.clear_error_channels(websocketpp::log::elevel::all);
+    server.init_asio();
+    server.set_reuse_addr(true);
+    server.set_http_handler(std::bind(&MetricsServer::on_http, this, std::placeholders::_1));
+
+    websocketpp::lib::error_code ec;
+    server.listen(address, std::to_string(port), ec);
+    if (ec)
+    {
+        throw std::runtime_error("Metrics endpoint failed to listen on " + address + ":" + std::to_string(port) + ": " + ec.message());
+    }
+    websocketpp::lib::asio::error_code endpoint_ec;
+    bound_port = server.get_local_endpoint(endpoint_ec).port();
+
+    server.start_accept(ec);
+    if (ec)
+    {
+        throw std::runtime_error("Metrics endpoint failed to accept: " + ec.message());
+    }
+    worker = std::thread([this]()
+                         { server.run(); });
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+void MetricsServer::stop()
+{
+    if (!worker.joinable())
+    {
+        return;
+    }
+    websocketpp::lib::error_code ec;
+    server.stop_listening(ec);
+    server.stop();
+    worker.join();
+}
+
+void MetricsServer::on_http(websocketpp::connection_hdl hdl)
+{
+    auto con = server.get_con_from_hdl(hdl);
+    if (con->get_request().get_method() != "GET" || con->get_resource() != "/metrics")
+    {
+        con->set_status(websocketpp::http::status_code::not_found);
+        con->set_body("not found\n");
+        return;
+    }
+
+    try
+    {
+        con->set_body(render());
+        con->replace_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        con->set_status(websocketpp::http::status_code::ok);
+    }
+    catch (const std::exception &e)
+    {
+        con->set_status(websocketpp::http::status_code::internal_server_error);
+        con->set_body(std::string(e.what()) + "\n");
+    }
+}
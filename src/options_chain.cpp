@@ -0,0 +1,208 @@
+#include "include/options_chain.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double ms_per_year = 365.0 * 24 * 60 * 60 * 1000;
+
+    double quote(const nlohmann::json &ticker, const char *key)
+    {
+        auto it = ticker.find(key);
+        if (it == ticker.end() || !it->is_number())
+        {
+            return NAN;
+        }
+        double value = it->get<double>();
+        // Deribit reports an empty side as 0
+        return value > 0.0 ? value : NAN;
+    }
+
+    nlohmann::json number_or_null(double value)
+    {
+        return std::isfinite(value) ? nlohmann::json(value) : nlohmann::json();
+    }
+}
+
+OptionsChain::OptionsChain(const std::string &underlying, double rate)
+    : underlying_currency(underlying), rate(rate)
+{
+}
+
+void OptionsChain::resize(size_t count)
+{
+    for (auto *column : {&cols.strike, &cols.sign, &cols.contract_size, &cols.forward, &cols.log_moneyness,
+                         &cols.bid, &cols.ask, &cols.mark, &cols.time, &cols.sqrt_time, &cols.discount,
+                         &cols.bid_iv, &cols.ask_iv, &cols.mark_iv, &cols.delta, &cols.gamma, &cols.vega, &cols.theta})
+    {
+        column->resize(count, NAN);
+    }
+    cols.expiry.resize(count, 0);
+    inverse.resize(count, 0);
+}
+
+size_t OptionsChain::load_markets(const nlohmann::json &markets)
+{
+    return load_markets(MarketRegistry(markets));
+}
+
+size_t OptionsChain::load_markets(const MarketRegistry &markets)
+{
+    struct Entry
+    {
+        std::string id;
+        MarketRegistry::MarketId market;
+        int64_t expiry;
+        double strike;
+        double sign;
+        double contract_size;
+        bool inverse;
+    };
+
+    std::vector<Entry> entries;
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        entries.push_back({names[i], markets.id(names[i]), cols.expiry[i], cols.strike[i], cols.sign[i], cols.contract_size[i], inverse[i] != 0});
+    }
+
+    for (MarketRegistry::MarketId id = 0; id < markets.size(); ++id)
+    {
+        const MarketRecord &market = markets[id];
+        if (!market.is(MarketRecord::Option) || markets.currency(market.base) != underlying_currency ||
+            std::isnan(market.strike) || rows.count(std::string(markets.name(id))))
+        {
+            continue;
+        }
+        double sign = market.is(MarketRecord::Put) ? -1.0 : 1.0;
+        double contract_size = std::isnan(market.contract_size) ? 1.0 : market.contract_size;
+        entries.push_back({std::string(markets.name(id)), id, market.expiry, market.strike, sign,
+                           contract_size, !market.is(MarketRecord::Linear)});
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+              {
+                  if (a.expiry != b.expiry)
+                      return a.expiry < b.expiry;
+                  if (a.strike != b.strike)
+                      return a.strike < b.strike;
+                  return a.sign > b.sign; });
+
+    // Quotes are reset; the next ticker for each row refills them.
+    names.clear();
+    market_ids.clear();
+    rows.clear();
+    cols = Columns();
+    inverse.clear();
+    resize(entries.size());
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        names.push_back(entries[i].id);
+        market_ids.push_back(entries[i].market);
+        rows[entries[i].id] = i;
+        cols.strike[i] = entries[i].strike;
+        cols.sign[i] = entries[i].sign;
+        cols.expiry[i] = entries[i].expiry;
+        cols.contract_size[i] = entries[i].contract_size;
+        inverse[i] = entries[i].inverse ? 1 : 0;
+    }
+    return names.size();
+}
+
+int64_t OptionsChain::index_of(const std::string &instrument) const
+{
+    auto it = rows.find(instrument);
+    return it == rows.end() ? -1 : static_cast<int64_t>(it->second);
+}
+
+bool OptionsChain::on_ticker(const nlohmann::json &ticker)
+{
+    auto name_it = ticker.find("instrument_name");
+    if (name_it == ticker.end() || !name_it->is_string())
+    {
+        return false;
+    }
+    auto row_it = rows.find(name_it->get_ref<const std::string &>());
+    if (row_it == rows.end())
+    {
+        return false;
+    }
+
+    size_t i = row_it->second;
+    double forward = quote(ticker, "underlying_price");
+    if (std::isfinite(forward) && forward != cols.forward[i])
+    {
+        cols.forward[i] = forward;
+        cols.log_moneyness[i] = std::log(forward / cols.strike[i]);
+    }
+
+    double scale = inverse[i] ? cols.forward[i] : 1.0;
+    cols.bid[i] = quote(ticker, "best_bid_price") * scale;
+    cols.ask[i] = quote(ticker, "best_ask_price") * scale;
+    cols.mark[i] = quote(ticker, "mark_price") * scale;
+    pending_updates++;
+    return true;
+}
+
+std::function<void(const nlohmann::json &)> OptionsChain::handler()
+{
+    return [this](const nlohmann::json &ticker)
+    { on_ticker(ticker); };
+}
+
+black76::Inputs OptionsChain::inputs() const
+{
+    black76::Inputs in;
+    in.count = names.size();
+    in.forward = cols.forward.data();
+    in.strike = cols.strike.data();
+    in.log_moneyness = cols.log_moneyness.data();
+    in.time = cols.time.data();
+    in.sqrt_time = cols.sqrt_time.data();
+    in.sign = cols.sign.data();
+    in.discount = cols.discount.data();
+    return in;
+}
+
+void OptionsChain::reprice(int64_t now_ms)
+{
+    size_t n = names.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        double t = (cols.expiry[i] - now_ms) / ms_per_year;
+        cols.time[i] = t;
+        cols.sqrt_time[i] = t > 0.0 ? std::sqrt(t) : NAN;
+        cols.discount[i] = std::exp(-rate * t);
+    }
+
+    black76::Inputs in = inputs();
+    // Previous solutions are the starting guesses
+    black76::implied_vol(in, cols.mark.data(), cols.mark_iv.data());
+    std::copy(cols.mark_iv.begin(), cols.mark_iv.end(), cols.bid_iv.begin());
+    black76::implied_vol(in, cols.bid.data(), cols.bid_iv.data());
+    std::copy(cols.mark_iv.begin(), cols.mark_iv.end(), cols.ask_iv.begin());
+    black76::implied_vol(in, cols.ask.data(), cols.ask_iv.data());
+    black76::greeks(in, cols.mark_iv.data(), rate, cols.delta.data(), cols.gamma.data(), cols.vega.data(), cols.theta.data());
+
+    pending_updates = 0;
+}
+
+nlohmann::json OptionsChain::row(size_t i) const
+{
+    return {
+        {"instrument_name", names[i]},
+        {"strike", cols.strike[i]},
+        {"optionType", cols.sign[i] > 0.0 ? "call" : "put"},
+        {"expiry", cols.expiry[i]},
+        {"forward", number_or_null(cols.forward[i])},
+        {"bid", number_or_null(cols.bid[i])},
+        {"ask", number_or_null(cols.ask[i])},
+        {"mark", number_or_null(cols.mark[i])},
+        {"bidIv", number_or_null(cols.bid_iv[i])},
+        {"askIv", number_or_null(cols.ask_iv[i])},
+        {"markIv", number_or_null(cols.mark_iv[i])},
+        {"delta", number_or_null(cols.delta[i])},
+        {"gamma", number_or_null(cols.gamma[i])},
+        {"vega", number_or_null(cols.vega[i])},
+        {"theta", number_or_null(cols.theta[i])}};
+}
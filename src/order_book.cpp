@@ -0,0 +1,188 @@
+#include "include/order_book.hpp"
+#include <algorithm>
+
+namespace
+{
+    template <typename Levels>
+    std::vector<BookLevel> top_levels(const Levels &levels, size_t depth)
+    {
+        std::vector<BookLevel> result;
+        size_t count = depth == 0 ? levels.size() : std::min(depth, levels.size());
+        result.reserve(count);
+        for (auto it = levels.begin(); it != levels.end() && result.size() < count; ++it)
+        {
+            result.push_back({it->first, it->second});
+        }
+        return result;
+    }
+}
+
+OrderBook::OrderBook(const std::string &instrument) : instrument_name(instrument)
+{
+}
+
+template <typename Levels>
+void OrderBook::set_level(Levels &levels, bool is_bid, double price, double amount)
+{
+    auto it = levels.find(price);
+    double old_amount = it == levels.end() ? 0.0 : it->second;
+
+    if (amount == 0.0)
+    {
+        if (it == levels.end())
+        {
+            return;
+        }
+        levels.erase(it);
+    }
+    else if (it == levels.end())
+    {
+        levels.emplace(price, amount);
+    }
+    else
+    {
+        it->second = amount;
+    }
+
+    for (BookListener *listener : listeners)
+    {
+        listener->on_level(is_bid, price, old_amount, amount);
+    }
+}
+
+template <typename Levels>
+void OrderBook::apply_levels(Levels &levels, bool is_bid, const nlohmann::json &updates)
+{
+    for (const auto &entry : updates)
+    {
+        if (!entry.is_array())
+        {
+            continue;
+        }
+
+        // Incremental channel: ["new" | "change" | "delete", price, amount]
+        // Grouped channel: [price, amount]
+        if (entry.size() >= 3 && entry[0].is_string())
+        {
+            const std::string &action = entry[0].get_ref<const std::string &>();
+            double amount = action == "delete" ? 0.0 : entry[2].get<double>();
+            set_level(levels, is_bid, entry[1].get<double>(), amount);
+        }
+        else if (entry.size() >= 2)
+        {
+            set_level(levels, is_bid, entry[0].get<double>(), entry[1].get<double>());
+        }
+    }
+}
+
+void OrderBook::reset_levels()
+{
+    bid_levels.clear();
+    ask_levels.clear();
+    for (BookListener *listener : listeners)
+    {
+        listener->on_clear();
+    }
+}
+
+bool OrderBook::apply(const nlohmann::json &data)
+{
+    auto type_it = data.find("type");
+    bool is_change = type_it != data.end() && type_it->is_string() && type_it->get_ref<const std::string &>() == "change";
+    int64_t change_id = data.value("change_id", int64_t(0));
+
+    if (is_change)
+    {
+        if (!synced)
+        {
+            return false;
+        }
+        auto prev_it = data.find("prev_change_id");
+        if (prev_it != data.end() && prev_it->is_number_integer() && prev_it->get<int64_t>() != last_change_id)
+        {
+            synced = false;
+            gap_count++;
+            return false;
+        }
+    }
+    else
+    {
+        // "snapshot" on the incremental channel, or a full grouped book
+        reset_levels();
+        synced = true;
+    }
+
+    if (instrument_name.empty())
+    {
+        instrument_name = data.value("instrument_name", "");
+    }
+
+    auto bids_it = data.find("bids");
+    if (bids_it != data.end())
+    {
+        apply_levels(bid_levels, true, *bids_it);
+    }
+    auto asks_it = data.find("asks");
+    if (asks_it != data.end())
+    {
+        apply_levels(ask_levels, false, *asks_it);
+    }
+
+    last_change_id = change_id;
+    last_timestamp = data.value("timestamp", int64_t(0));
+
+    for (BookListener *listener : listeners)
+    {
+        listener->on_update(*this);
+    }
+    return true;
+}
+
+void OrderBook::clear()
+{
+    reset_levels();
+    last_change_id = 0;
+    last_timestamp = 0;
+    synced = false;
+}
+
+void OrderBook::invalidate()
+{
+    if (synced)
+    {
+        synced = false;
+        gap_count++;
+    }
+}
+
+void OrderBook::add_listener(BookListener *listener)
+{
+    listeners.push_back(listener);
+}
+
+void OrderBook::remove_listener(BookListener *listener)
+{
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+BookSnapshot OrderBook::snapshot(size_t depth) const
+{
+    BookSnapshot snap;
+    snap.instrument = instrument_name;
+    snap.timestamp = last_timestamp;
+    snap.change_id = last_change_id;
+    snap.in_sync = synced;
+    snap.bids = top_levels(bid_levels, depth);
+    snap.asks = top_levels(ask_levels, depth);
+    return snap;
+}
+
+std::vector<BookLevel> OrderBook::bids(size_t depth) const
+{
+    return top_levels(bid_levels, depth);
+}
+
+std::vector<BookLevel> OrderBook::asks(size_t depth) const
+{
+    return top_levels(ask_levels, depth);
+}
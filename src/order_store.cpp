@@ -0,0 +1,343 @@
+#include "include/order_store.hpp"
+#include <mutex>
+
+OrderStore::OrderStore(size_t max_closed) : max_closed(max_closed)
+{
+}
+
+void OrderStore::set_markets(std::shared_ptr<const MarketRegistry> registry)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    markets = std::move(registry);
+    auto unresolved = by_markets.find(MarketRegistry::npos);
+    if (unresolved == by_markets.end())
+    {
+        return;
+    }
+    std::vector<std::string> ids(unresolved->second.begin(), unresolved->second.end());
+    for (const auto &id : ids)
+    {
+        Entry &entry = orders.at(id);
+        if (resolve(entry.instrument) != MarketRegistry::npos)
+        {
+            unindex_market(entry, id);
+            index_market(entry, id);
+        }
+    }
+}
+
+MarketRegistry::MarketId OrderStore::resolve(const std::string &instrument) const
+{
+    return markets ? markets->id(instrument) : MarketRegistry::npos;
+}
+
+bool OrderStore::matches(const Entry &entry, MarketRegistry::MarketId market, const std::string &instrument) const
+{
+    return entry.market == market && (market != MarketRegistry::npos || entry.instrument == instrument);
+}
+
+bool OrderStore::is_open(std::string_view state)
+{
+    return state == "open" || state == "untriggered";
+}
+
+bool OrderStore::apply(const nlohmann::json &order)
+{
+    if (!order.is_object())
+    {
+        return false;
+    }
+    std::string id = order.value("order_id", "");
+    if (id.empty())
+    {
+        return false;
+    }
+    int64_t updated = order.value("last_update_timestamp", int64_t(0));
+
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    auto it = orders.find(id);
+    if (it == orders.end())
+    {
+        it = orders.emplace(id, Entry()).first;
+    }
+    else
+    {
+        Entry &entry = it->second;
+        if (updated < entry.updated)
+        {
+            return false;
+        }
+        unindex(labels, entry.label, id);
+        unindex_market(entry, id);
+        unindex(states, entry.state, id);
+    }
+
+    Entry &entry = it->second;
+    bool was_closed = !entry.state.empty() && !is_open(entry.state);
+    entry.order = order;
+    entry.label = order.value("label", "");
+    entry.instrument = order.value("instrument_name", "");
+    entry.state = order.value("order_state", "");
+    entry.updated = updated;
+    entry.version = ++current_version;
+    index(labels, entry.label, id);
+    index_market(entry, id);
+    index(states, entry.state, id);
+
+    if (!was_closed && !is_open(entry.state))
+    {
+        closed.push_back(id);
+        while (closed.size() > max_closed)
+        {
+            // A triggered stop can reopen under the same id; keep it then
+            auto oldest = orders.find(closed.front());
+            if (oldest != orders.end() && !is_open(oldest->second.state))
+            {
+                erase(closed.front());
+            }
+            closed.pop_front();
+        }
+    }
+    return true;
+}
+
+size_t OrderStore::apply_all(const nlohmann::json &orders)
+{
+    if (!orders.is_array())
+    {
+        return apply(orders) ? 1 : 0;
+    }
+    size_t applied = 0;
+    for (const auto &order : orders)
+    {
+        applied += apply(order) ? 1 : 0;
+    }
+    return applied;
+}
+
+size_t OrderStore::reconcile(const nlohmann::json &open_orders, uint64_t since)
+{
+    apply_all(open_orders);
+
+    std::unordered_set<std::string> listed;
+    for (const auto &order : open_orders)
+    {
+        listed.insert(order.value("order_id", ""));
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    std::vector<std::string> stale;
+    for (const char *state : {"open", "untriggered"})
+    {
+        auto ids = states.find(state);
+        if (ids == states.end())
+        {
+            continue;
+        }
+        for (const auto &id : ids->second)
+        {
+            if (!listed.count(id) && orders.at(id).version <= since)
+            {
+                stale.push_back(id);
+            }
+        }
+    }
+    for (const auto &id : stale)
+    {
+        erase(id);
+    }
+    return stale.size();
+}
+
+uint64_t OrderStore::version() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return current_version;
+}
+
+std::optional<nlohmann::json> OrderStore::find(const std::string &id) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    auto it = orders.find(id);
+    if (it == orders.end())
+    {
+        return std::nullopt;
+    }
+    return it->second.order;
+}
+
+std::vector<nlohmann::json> OrderStore::open(const std::string &instrument) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    MarketRegistry::MarketId market = resolve(instrument);
+    std::vector<nlohmann::json> result;
+    for (const char *state : {"open", "untriggered"})
+    {
+        auto ids = states.find(state);
+        if (ids == states.end())
+        {
+            continue;
+        }
+        for (const auto &id : ids->second)
+        {
+            const Entry &entry = orders.at(id);
+            if (instrument.empty() || matches(entry, market, instrument))
+            {
+                result.push_back(entry.order);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<nlohmann::json> OrderStore::by_label(const std::string &label) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return collect(labels, label);
+}
+
+std::vector<nlohmann::json> OrderStore::by_instrument(const std::string &instrument) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    MarketRegistry::MarketId market = resolve(instrument);
+    std::vector<nlohmann::json> result;
+    auto ids = by_markets.find(market);
+    if (ids == by_markets.end())
+    {
+        return result;
+    }
+    for (const auto &id : ids->second)
+    {
+        const Entry &entry = orders.at(id);
+        if (matches(entry, market, instrument))
+        {
+            result.push_back(entry.order);
+        }
+    }
+    return result;
+}
+
+std::vector<nlohmann::json> OrderStore::by_market(MarketRegistry::MarketId market) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    std::vector<nlohmann::json> result;
+    auto ids = by_markets.find(market);
+    if (market == MarketRegistry::npos || ids == by_markets.end())
+    {
+        return result;
+    }
+    result.reserve(ids->second.size());
+    for (const auto &id : ids->second)
+    {
+        result.push_back(orders.at(id).order);
+    }
+    return result;
+}
+
+std::vector<nlohmann::json> OrderStore::by_state(const std::string &state) const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return collect(states, state);
+}
+
+size_t OrderStore::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return orders.size();
+}
+
+size_t OrderStore::open_count() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    size_t count = 0;
+    for (const char *state : {"open", "untriggered"})
+    {
+        auto ids = states.find(state);
+        count += ids == states.end() ? 0 : ids->second.size();
+    }
+    return count;
+}
+
+void OrderStore::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    orders.clear();
+    labels.clear();
+    by_markets.clear();
+    states.clear();
+    closed.clear();
+}
+
+void OrderStore::index(Index &index, const std::string &key, const std::string &id)
+{
+    if (!key.empty())
+    {
+        index[key].insert(id);
+    }
+}
+
+void OrderStore::unindex(Index &index, const std::string &key, const std::string &id)
+{
+    auto it = index.find(key);
+    if (it == index.end())
+    {
+        return;
+    }
+    it->second.erase(id);
+    if (it->second.empty())
+    {
+        index.erase(it);
+    }
+}
+
+void OrderStore::index_market(Entry &entry, const std::string &id)
+{
+    if (!entry.instrument.empty())
+    {
+        entry.market = resolve(entry.instrument);
+        by_markets[entry.market].insert(id);
+    }
+}
+
+void OrderStore::unindex_market(const Entry &entry, const std::string &id)
+{
+    auto it = by_markets.find(entry.market);
+    if (entry.instrument.empty() || it == by_markets.end())
+    {
+        return;
+    }
+    it->second.erase(id);
+    if (it->second.empty())
+    {
+        by_markets.erase(it);
+    }
+}
+
+void OrderStore::erase(const std::string &id)
+{
+    auto it = orders.find(id);
+    if (it == orders.end())
+    {
+        return;
+    }
+    unindex(labels, it->second.label, id);
+    unindex_market(it->second, id);
+    unindex(states, it->second.state, id);
+    orders.erase(it);
+}
+
+std::vector<nlohmann::json> OrderStore::collect(const Index &index, const std::string &key) const
+{
+    std::vector<nlohmann::json> result;
+    auto ids = index.find(key);
+    if (ids == index.end())
+    {
+        return result;
+    }
+    result.reserve(ids->second.size());
+    for (const auto &id : ids->second)
+    {
+        result.push_back(orders.at(id).order);
+    }
+    return result;
+}
@@ -0,0 +1,145 @@
+#include "include/outbound_scheduler.hpp"
+#include "include/rate_limiter.hpp"
+#include <algorithm>
+
+namespace
+{
+    const char *priority_names[] = {"urgent", "normal", "bulk"};
+}
+
+OutboundScheduler::OutboundScheduler(Writer writer, Backlog backlog, Post post, size_t max_backlog,
+                                     std::chrono::microseconds retry_delay)
+    : writer(std::move(writer)), backlog(std::move(backlog)), post(std::move(post)), max_backlog(max_backlog),
+      retry_delay(retry_delay)
+{
+}
+
+OutboundScheduler::Priority OutboundScheduler::priority(std::string_view method)
+{
+    switch (RateLimiter::lane(method))
+    {
+    case RateLimiter::Lane::Cancel:
+        return Priority::Urgent;
+    case RateLimiter::Lane::Order:
+        return Priority::Normal;
+    default:
+        return Priority::Bulk;
+    }
+}
+
+void OutboundScheduler::enqueue(Priority priority, std::string frame, std::function<void()> on_written,
+                                std::function<void()> on_failed)
+{
+    size_t index = static_cast<size_t>(priority);
+    bool schedule;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queues[index].push_back({std::move(frame), std::move(on_written), std::move(on_failed)});
+        enqueued[index]++;
+        size_t queued = queues[0].size() + queues[1].size() + queues[2].size();
+        high_water = std::max(high_water, queued);
+        schedule = !drain_scheduled;
+        drain_scheduled = true;
+    }
+    if (schedule)
+    {
+        schedule_drain();
+    }
+}
+
+void OutboundScheduler::schedule_drain(std::chrono::microseconds delay)
+{
+    std::weak_ptr<OutboundScheduler> self = weak_from_this();
+    post([self]()
+         {
+        if (auto scheduler = self.lock())
+        {
+            scheduler->drain();
+        } },
+         delay);
+}
+
+void OutboundScheduler::drain()
+{
+    while (true)
+    {
+        if (backlog() >= max_backlog)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                yields++;
+            }
+            schedule_drain(retry_delay);
+            return;
+        }
+
+        Frame frame;
+        size_t index = 0;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            while (index < priority_count && queues[index].empty())
+            {
+                index++;
+            }
+            if (index == priority_count)
+            {
+                drain_scheduled = false;
+                return;
+            }
+            frame = std::move(queues[index].front());
+            queues[index].pop_front();
+        }
+
+        bool ok = writer(frame.payload);
+        auto &done = ok ? frame.on_written : frame.on_failed;
+        if (done)
+        {
+            done();
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        if (ok)
+        {
+            written[index]++;
+        }
+        else
+        {
+            failed++;
+        }
+    }
+}
+
+size_t OutboundScheduler::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    size_t count = 0;
+    for (auto &queue : queues)
+    {
+        count += queue.size();
+        queue.clear();
+    }
+    dropped += count;
+    return count;
+}
+
+size_t OutboundScheduler::depth() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return queues[0].size() + queues[1].size() + queues[2].size();
+}
+
+nlohmann::json OutboundScheduler::stats() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    nlohmann::json result = {{"depth", queues[0].size() + queues[1].size() + queues[2].size()},
+                             {"highWater", high_water},
+                             {"failed", failed},
+                             {"dropped", dropped},
+                             {"yields", yields}};
+    for (size_t i = 0; i < priority_count; ++i)
+    {
+        result["priorities"][priority_names[i]] = {{"enqueued", enqueued[i]},
+                                                   {"written", written[i]},
+                                                   {"queued", queues[i].size()}};
+    }
+    return result;
+}
@@ -0,0 +1,190 @@
+#include "include/rate_limiter.hpp"
+#include "include/tsc_clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    const char *lane_names[] = {"cancel", "order", "query"};
+    const char *pool_names[] = {"matching", "nonMatching"};
+
+    bool starts_with(std::string_view text, std::string_view prefix)
+    {
+        return text.substr(0, prefix.size()) == prefix;
+    }
+}
+
+RateLimiter::RateLimiter(const nlohmann::json &config)
+{
+    auto limits = [&config](const char *key, double capacity, double refill)
+    {
+        auto options = config.value(key, nlohmann::json::object());
+        return std::make_pair(options.value("capacity", capacity), options.value("refill", refill));
+    };
+    auto matching = limits("matching", 10000.0, 2500.0);
+    auto non_matching = limits("non_matching", 50000.0, 10000.0);
+    buckets[0].capacity = matching.first;
+    buckets[0].refill = matching.second;
+    buckets[1].capacity = non_matching.first;
+    buckets[1].refill = non_matching.second;
+
+    uint64_t now = TscClock::ticks();
+    for (auto &bucket : buckets)
+    {
+        bucket.credits = bucket.capacity;
+        bucket.updated = now;
+    }
+
+    default_cost = config.value("default_cost", default_cost);
+    cancel_reserve = config.value("cancel_reserve", cancel_reserve);
+    auto method_costs = config.value("costs", nlohmann::json::object());
+    for (const auto &[method, value] : method_costs.items())
+    {
+        costs[method] = value.get<double>();
+    }
+    auto waits = config.value("max_wait_ms", nlohmann::json::object());
+    for (size_t i = 0; i < lane_count; ++i)
+    {
+        max_wait_ms[i] = waits.value(lane_names[i], max_wait_ms[i]);
+    }
+}
+
+RateLimiter::Lane RateLimiter::lane(std::string_view method)
+{
+    if (starts_with(method, "private/cancel"))
+    {
+        return Lane::Cancel;
+    }
+    if (method == "private/buy" || method == "private/sell" || starts_with(method, "private/edit") ||
+        method == "private/close_position")
+    {
+        return Lane::Order;
+    }
+    return Lane::Query;
+}
+
+double RateLimiter::cost(std::string_view method) const
+{
+    auto it = costs.find(method);
+    return it != costs.end() ? it->second : default_cost;
+}
+
+void RateLimiter::refill(Bucket &bucket) const
+{
+    uint64_t now = TscClock::ticks();
+    double seconds = TscClock::instance().to_ns(now - bucket.updated) / 1e9;
+    bucket.credits = std::min(bucket.capacity, bucket.credits + seconds * bucket.refill);
+    bucket.updated = now;
+}
+
+bool RateLimiter::acquire(std::string_view method)
+{
+    return take(method, true);
+}
+
+bool RateLimiter::try_acquire(std::string_view method)
+{
+    return take(method, false);
+}
+
+bool RateLimiter::take(std::string_view method, bool wait)
+{
+    Lane request_lane = lane(method);
+    size_t lane_index = static_cast<size_t>(request_lane);
+    Bucket &bucket = buckets[static_cast<size_t>(pool(request_lane))];
+    double price = cost(method);
+    double floor = request_lane == Lane::Order ? cancel_reserve : 0.0;
+
+    std::unique_lock<std::mutex> lock(mtx);
+    auto blocked = [&]()
+    {
+        for (size_t higher = 0; higher < lane_index; ++higher)
+        {
+            if (bucket.waiting[higher] > 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    refill(bucket);
+    if (!blocked() && bucket.credits - price >= floor)
+    {
+        bucket.credits -= price;
+        lane_stats[lane_index].granted++;
+        return true;
+    }
+    if (!wait || max_wait_ms[lane_index] <= 0 || price + floor > bucket.capacity)
+    {
+        lane_stats[lane_index].rejected++;
+        return false;
+    }
+
+    lane_stats[lane_index].delayed++;
+    bucket.waiting[lane_index]++;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(max_wait_ms[lane_index]);
+    bool granted = false;
+    while (true)
+    {
+        refill(bucket);
+        if (!blocked() && bucket.credits - price >= floor)
+        {
+            bucket.credits -= price;
+            granted = true;
+            break;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            break;
+        }
+        // Sleep until the deficit has refilled; a served higher lane wakes us sooner
+        double deficit = std::max(price + floor - bucket.credits, 0.0);
+        auto refill_time = std::chrono::microseconds(static_cast<int64_t>(std::ceil(deficit / bucket.refill * 1e6)) + 1);
+        bucket.cv.wait_until(lock, std::min(deadline, now + refill_time));
+    }
+    bucket.waiting[lane_index]--;
+    bucket.cv.notify_all();
+
+    if (granted)
+    {
+        lane_stats[lane_index].granted++;
+    }
+    else
+    {
+        lane_stats[lane_index].rejected++;
+    }
+    return granted;
+}
+
+double RateLimiter::credits(Pool which) const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Bucket &bucket = buckets[static_cast<size_t>(which)];
+    refill(bucket);
+    return bucket.credits;
+}
+
+nlohmann::json RateLimiter::stats() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    nlohmann::json result;
+    for (size_t i = 0; i < pool_count; ++i)
+    {
+        refill(buckets[i]);
+        result["pools"][pool_names[i]] = {{"credits", buckets[i].credits},
+                                          {"capacity", buckets[i].capacity},
+                                          {"refill", buckets[i].refill}};
+    }
+    for (size_t i = 0; i < lane_count; ++i)
+    {
+        uint32_t waiting = buckets[static_cast<size_t>(pool(static_cast<Lane>(i)))].waiting[i];
+        result["lanes"][lane_names[i]] = {{"granted", lane_stats[i].granted},
+                                          {"delayed", lane_stats[i].delayed},
+                                          {"rejected", lane_stats[i].rejected},
+                                          {"waiting", waiting}};
+    }
+    return result;
+}
@@ -0,0 +1,105 @@
+#include "include/replay.hpp"
+#include "include/frame_recorder.hpp"
+#include "include/tsc_clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+double ReplayStats::frames_per_second() const
+{
+    return wall_seconds > 0.0 ? frames / wall_seconds : 0.0;
+}
+
+double ReplayStats::megabytes_per_second() const
+{
+    return wall_seconds > 0.0 ? bytes / wall_seconds / 1e6 : 0.0;
+}
+
+nlohmann::json ReplayStats::to_json() const
+{
+    return {{"frames", frames},
+            {"bytes", bytes},
+            {"wallSeconds", wall_seconds},
+            {"recordedSeconds", recorded_seconds},
+            {"framesPerSecond", frames_per_second()},
+            {"megabytesPerSecond", megabytes_per_second()}};
+}
+
+ReplayDriver::ReplayDriver(Sink sink) : sink(std::move(sink))
+{
+}
+
+ReplayDriver::ReplayDriver(Deribit &client)
+    : sink([&client](std::string_view payload)
+           { client.handle_message(payload); })
+{
+}
+
+std::vector<std::string> ReplayDriver::segments(const std::string &directory, const std::string &prefix)
+{
+    std::vector<std::string> result;
+    std::string start = prefix + "-";
+    for (const auto &entry : std::filesystem::directory_iterator(directory))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(start, 0) == 0 && entry.path().extension() == ".frames")
+        {
+            result.push_back(entry.path().string());
+        }
+    }
+    // Segment indices are zero padded, so name order is recording order
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+ReplayStats ReplayDriver::run(const std::vector<std::string> &segments, const ReplayOptions &options)
+{
+    const TscClock &clock = TscClock::instance();
+
+    ReplayStats stats;
+    int64_t first_ns = 0;
+    int64_t last_ns = 0;
+    uint64_t started = TscClock::ticks();
+
+    for (const auto &path : segments)
+    {
+        FrameReader reader(path);
+        FrameRecord record;
+        while (reader.next(record))
+        {
+            if (record.direction != FrameRecorder::Inbound ||
+                (options.connection >= 0 && record.connection != options.connection))
+            {
+                continue;
+            }
+            if (stats.frames == 0)
+            {
+                first_ns = record.timestamp_ns;
+            }
+            last_ns = std::max(last_ns, record.timestamp_ns);
+
+            if (options.speed > 0.0)
+            {
+                int64_t due = static_cast<int64_t>((record.timestamp_ns - first_ns) / options.speed);
+                // Sleep through long gaps, spin the last stretch to keep spacing tight
+                int64_t remaining = due - static_cast<int64_t>(clock.to_ns(TscClock::ticks() - started));
+                if (remaining > 200000)
+                {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(remaining - 100000));
+                }
+                while (static_cast<int64_t>(clock.to_ns(TscClock::ticks() - started)) < due)
+                {
+                }
+            }
+
+            sink(record.payload);
+            stats.frames++;
+            stats.bytes += record.payload.size();
+        }
+    }
+
+    stats.wall_seconds = clock.to_ns(TscClock::ticks() - started) / 1e9;
+    stats.recorded_seconds = stats.frames > 0 ? (last_ns - first_ns) / 1e9 : 0.0;
+    return stats;
+}
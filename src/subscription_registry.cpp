@@ -0,0 +1,185 @@
+#include "include/subscription_registry.hpp"
+#include <algorithm>
+
+SubscriptionRegistry::SubscriptionRegistry()
+{
+    table.store(std::make_shared<const Table>());
+}
+
+std::shared_ptr<const SubscriptionRegistry::Table> SubscriptionRegistry::current() const
+{
+    return table.load(std::memory_order_acquire);
+}
+
+const std::vector<SubscriptionRegistry::Entry> *SubscriptionRegistry::Table::find(std::string_view channel) const
+{
+    auto it = ids.find(channel);
+    return it == ids.end() ? nullptr : &entries[it->second];
+}
+
+SubscriptionRegistry::HandlerId SubscriptionRegistry::add(const std::vector<std::string> &channels, Handler handler, std::vector<std::string> *activated)
+{
+    auto shared = std::make_shared<const Handler>(std::move(handler));
+
+    std::lock_guard<std::mutex> lock(write_mtx);
+    HandlerId id = next_id++;
+    auto next = std::make_shared<Table>(*current());
+
+    for (const auto &channel : channels)
+    {
+        auto [it, inserted] = next->ids.try_emplace(channel, static_cast<ChannelId>(next->names.size()));
+        if (inserted)
+        {
+            next->names.push_back(channel);
+            next->entries.emplace_back();
+            next->stats.push_back(std::make_shared<ChannelStats>());
+        }
+        auto &entries = next->entries[it->second];
+        if (entries.empty() && activated)
+        {
+            activated->push_back(channel);
+        }
+        entries.push_back({id, shared});
+    }
+
+    table.store(std::move(next), std::memory_order_release);
+    return id;
+}
+
+bool SubscriptionRegistry::remove(HandlerId id, std::vector<std::string> *deactivated)
+{
+    std::lock_guard<std::mutex> lock(write_mtx);
+    auto next = std::make_shared<Table>(*current());
+
+    bool found = false;
+    for (ChannelId c = 0; c < next->entries.size(); ++c)
+    {
+        auto &entries = next->entries[c];
+        auto end = std::remove_if(entries.begin(), entries.end(), [id](const Entry &e)
+                                  { return e.id == id; });
+        if (end == entries.end())
+        {
+            continue;
+        }
+        found = true;
+        entries.erase(end, entries.end());
+        if (entries.empty() && deactivated)
+        {
+            deactivated->push_back(next->names[c]);
+        }
+    }
+
+    if (found)
+    {
+        table.store(std::move(next), std::memory_order_release);
+    }
+    return found;
+}
+
+size_t SubscriptionRegistry::remove_channels(const std::vector<std::string> &channels, std::vector<std::string> *deactivated)
+{
+    std::lock_guard<std::mutex> lock(write_mtx);
+    auto next = std::make_shared<Table>(*current());
+
+    size_t removed = 0;
+    for (const auto &channel : channels)
+    {
+        auto it = next->ids.find(channel);
+        if (it == next->ids.end() || next->entries[it->second].empty())
+        {
+            continue;
+        }
+        next->entries[it->second].clear();
+        removed++;
+        if (deactivated)
+        {
+            deactivated->push_back(channel);
+        }
+    }
+
+    if (removed > 0)
+    {
+        table.store(std::move(next), std::memory_order_release);
+    }
+    return removed;
+}
+
+size_t SubscriptionRegistry::dispatch(std::string_view channel, const nlohmann::json &data) const
+{
+    auto snapshot = current();
+    const auto *entries = snapshot->find(channel);
+    if (!entries)
+    {
+        return 0;
+    }
+    for (const auto &entry : *entries)
+    {
+        (*entry.handler)(data);
+    }
+    return entries->size();
+}
+
+bool SubscriptionRegistry::route(std::string_view channel, size_t bytes, const nlohmann::json *data) const
+{
+    auto snapshot = current();
+    auto it = snapshot->ids.find(channel);
+    if (it == snapshot->ids.end())
+    {
+        return false;
+    }
+    ChannelStats &stats = *snapshot->stats[it->second];
+    stats.messages.fetch_add(1, std::memory_order_relaxed);
+    stats.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (data)
+    {
+        for (const auto &entry : snapshot->entries[it->second])
+        {
+            (*entry.handler)(*data);
+        }
+    }
+    return true;
+}
+
+int64_t SubscriptionRegistry::channel_id(std::string_view channel) const
+{
+    auto snapshot = current();
+    auto it = snapshot->ids.find(channel);
+    return it == snapshot->ids.end() ? -1 : static_cast<int64_t>(it->second);
+}
+
+size_t SubscriptionRegistry::handler_count(std::string_view channel) const
+{
+    auto snapshot = current();
+    const auto *entries = snapshot->find(channel);
+    return entries ? entries->size() : 0;
+}
+
+std::vector<std::string> SubscriptionRegistry::active_channels() const
+{
+    auto snapshot = current();
+    std::vector<std::string> result;
+    for (ChannelId c = 0; c < snapshot->entries.size(); ++c)
+    {
+        if (!snapshot->entries[c].empty())
+        {
+            result.push_back(snapshot->names[c]);
+        }
+    }
+    return result;
+}
+
+SubscriptionRegistry::ChannelStats *SubscriptionRegistry::stats(std::string_view channel) const
+{
+    auto snapshot = current();
+    auto it = snapshot->ids.find(channel);
+    return it == snapshot->ids.end() ? nullptr : snapshot->stats[it->second].get();
+}
+
+void SubscriptionRegistry::visit_stats(const std::function<void(const std::string &, const ChannelStats &)> &visitor) const
+{
+    auto snapshot = current();
+    for (ChannelId c = 0; c < snapshot->names.size(); ++c)
+    {
+        visitor(snapshot->names[c], *snapshot->stats[c]);
+    }
+}
@@ -0,0 +1,109 @@
+#include "include/tsc_clock.hpp"
+
+TscClock &TscClock::instance()
+{
+    static TscClock clock;
+    return clock;
+}
+
+// Takes the steady_clock and system_clock readings bracketed by the
+// tightest pair of tick reads out of a few attempts, so preemption does not
+// skew the anchor.
+TscClock::Sample TscClock::sample()
+{
+    Sample result;
+    uint64_t best = UINT64_MAX;
+    for (int attempt = 0; attempt < 5; ++attempt)
+    {
+        uint64_t before = TscClock::ticks();
+        auto steady = std::chrono::steady_clock::now();
+        auto system = std::chrono::system_clock::now();
+        uint64_t after = TscClock::ticks();
+        if (after - before < best)
+        {
+            best = after - before;
+            result.ticks = before + (after - before) / 2;
+            result.steady_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(steady.time_since_epoch()).count();
+            result.epoch_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(system.time_since_epoch()).count();
+        }
+    }
+    return result;
+}
+
+TscClock::TscClock()
+{
+    Sample origin = sample();
+    origin_ticks = origin.ticks;
+    origin_steady_ns = origin.steady_ns;
+
+    // Initial rate from a short busy interval; calibrate() refines it later
+    Sample end;
+    do
+    {
+        end = sample();
+    } while (end.steady_ns - origin_steady_ns < 5000000 || end.ticks == origin_ticks);
+
+    double rate = static_cast<double>(end.steady_ns - origin_steady_ns) / static_cast<double>(end.ticks - origin_ticks);
+    ns_per_tick.store(rate, std::memory_order_relaxed);
+    anchor_ticks.store(end.ticks, std::memory_order_relaxed);
+    anchor_ns.store(end.epoch_ns, std::memory_order_relaxed);
+
+    refresher = std::thread([this]()
+                            {
+        std::unique_lock<std::mutex> lock(refresh_mutex);
+        while (!refresh_cv.wait_for(lock, recalibrate_interval, [this]() { return stopping; }))
+        {
+            calibrate();
+        } });
+}
+
+TscClock::~TscClock()
+{
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex);
+        stopping = true;
+    }
+    refresh_cv.notify_one();
+    refresher.join();
+}
+
+void TscClock::calibrate() const
+{
+    if (calibrating.test_and_set(std::memory_order_acquire))
+    {
+        return;
+    }
+    Sample now = sample();
+    double rate = static_cast<double>(now.steady_ns - origin_steady_ns) / static_cast<double>(now.ticks - origin_ticks);
+
+    sequence.fetch_add(1, std::memory_order_acq_rel);
+    anchor_ticks.store(now.ticks, std::memory_order_relaxed);
+    anchor_ns.store(now.epoch_ns, std::memory_order_relaxed);
+    ns_per_tick.store(rate, std::memory_order_relaxed);
+    sequence.fetch_add(1, std::memory_order_release);
+
+    calibrating.clear(std::memory_order_release);
+}
+
+int64_t TscClock::to_epoch_ns(uint64_t ticks) const
+{
+    uint64_t seq, base_ticks;
+    int64_t base_ns;
+    double rate;
+    do
+    {
+        seq = sequence.load(std::memory_order_acquire);
+        base_ticks = anchor_ticks.load(std::memory_order_relaxed);
+        base_ns = anchor_ns.load(std::memory_order_relaxed);
+        rate = ns_per_tick.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != sequence.load(std::memory_order_relaxed));
+
+    int64_t delta = static_cast<int64_t>(ticks - base_ticks);
+    return base_ns + static_cast<int64_t>(delta * rate);
+}
+
+uint64_t TscClock::to_ns(uint64_t elapsed_ticks) const
+{
+    return static_cast<uint64_t>(elapsed_ticks * ns_per_tick.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,352 @@
+#include "include/vol_surface.hpp"
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+namespace
+{
+    constexpr size_t svi_params = 5;
+    constexpr size_t min_points = 5;
+    constexpr int max_iterations = 200;
+
+    double weighted_cost(const SviParams &p, double time, const SmileQuotes &quotes)
+    {
+        double cost = 0.0;
+        for (size_t i = 0; i < quotes.iv.size(); ++i)
+        {
+            double r = p.total_variance(quotes.log_moneyness[i]) - quotes.iv[i] * quotes.iv[i] * time;
+            cost += quotes.weight[i] * r * r;
+        }
+        return cost;
+    }
+
+    void clamp(SviParams &p)
+    {
+        p.b = std::max(p.b, 0.0);
+        p.rho = std::clamp(p.rho, -0.999, 0.999);
+        p.sigma = std::max(p.sigma, 1e-4);
+        // keep the minimum total variance non-negative
+        p.a = std::max(p.a, -p.b * p.sigma * std::sqrt(1.0 - p.rho * p.rho));
+    }
+
+    // Solves the 5x5 system a * x = rhs with partial pivoting.
+    bool solve(double a[svi_params][svi_params], double rhs[svi_params], double x[svi_params])
+    {
+        for (size_t col = 0; col < svi_params; ++col)
+        {
+            size_t pivot = col;
+            for (size_t row = col + 1; row < svi_params; ++row)
+            {
+                if (std::abs(a[row][col]) > std::abs(a[pivot][col]))
+                {
+                    pivot = row;
+                }
+            }
+            if (std::abs(a[pivot][col]) < 1e-300)
+            {
+                return false;
+            }
+            std::swap(a[col], a[pivot]);
+            std::swap(rhs[col], rhs[pivot]);
+            for (size_t row = col + 1; row < svi_params; ++row)
+            {
+                double factor = a[row][col] / a[col][col];
+                for (size_t k = col; k < svi_params; ++k)
+                {
+                    a[row][k] -= factor * a[col][k];
+                }
+                rhs[row] -= factor * rhs[col];
+            }
+        }
+        for (size_t i = svi_params; i-- > 0;)
+        {
+            double sum = rhs[i];
+            for (size_t k = i + 1; k < svi_params; ++k)
+            {
+                sum -= a[i][k] * x[k];
+            }
+            x[i] = sum / a[i][i];
+        }
+        return true;
+    }
+
+    SmileQuotes smile_quotes(const OptionsChain::Columns &cols, size_t begin, size_t end)
+    {
+        SmileQuotes quotes;
+        for (size_t i = begin; i < end; ++i)
+        {
+            double forward = cols.forward[i];
+            if (!std::isfinite(forward) || !(cols.time[i] > 0.0))
+            {
+                continue;
+            }
+            // Out-of-the-money side only: calls above the forward, puts below
+            bool call = cols.sign[i] > 0.0;
+            if (call != (cols.strike[i] >= forward))
+            {
+                continue;
+            }
+
+            double iv = std::isfinite(cols.bid_iv[i]) && std::isfinite(cols.ask_iv[i])
+                            ? 0.5 * (cols.bid_iv[i] + cols.ask_iv[i])
+                            : cols.mark_iv[i];
+            if (!std::isfinite(iv))
+            {
+                continue;
+            }
+            quotes.log_moneyness.push_back(-cols.log_moneyness[i]);
+            quotes.iv.push_back(iv);
+            quotes.weight.push_back(1.0);
+        }
+        return quotes;
+    }
+}
+
+double SviParams::total_variance(double k) const
+{
+    double x = k - m;
+    return a + b * (rho * x + std::sqrt(x * x + sigma * sigma));
+}
+
+double SmileFit::implied_vol(double log_moneyness) const
+{
+    double w = params.total_variance(log_moneyness);
+    return w > 0.0 && time > 0.0 ? std::sqrt(w / time) : NAN;
+}
+
+const SmileFit *VolSurface::smile(int64_t expiry) const
+{
+    auto it = std::lower_bound(smiles.begin(), smiles.end(), expiry, [](const SmileFit &fit, int64_t value)
+                               { return fit.expiry < value; });
+    return it != smiles.end() && it->expiry == expiry ? &*it : nullptr;
+}
+
+nlohmann::json VolSurface::to_json() const
+{
+    nlohmann::json result;
+    result["timestamp"] = timestamp;
+    result["smiles"] = nlohmann::json::array();
+    for (const auto &fit : smiles)
+    {
+        result["smiles"].push_back({{"expiry", fit.expiry},
+                                    {"time", fit.time},
+                                    {"a", fit.params.a},
+                                    {"b", fit.params.b},
+                                    {"rho", fit.params.rho},
+                                    {"m", fit.params.m},
+                                    {"sigma", fit.params.sigma},
+                                    {"rmse", fit.rmse},
+                                    {"points", fit.points}});
+    }
+    return result;
+}
+
+SurfaceEngine::SurfaceEngine(size_t threads, double refit_threshold)
+    : pool(threads), refit_threshold(refit_threshold)
+{
+    published.store(std::make_shared<const VolSurface>());
+}
+
+double SurfaceEngine::quote_rmse(const SmileFit &fit, const SmileQuotes &quotes)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < quotes.iv.size(); ++i)
+    {
+        double diff = fit.implied_vol(quotes.log_moneyness[i]) - quotes.iv[i];
+        sum += diff * diff;
+    }
+    return quotes.iv.empty() ? 0.0 : std::sqrt(sum / quotes.iv.size());
+}
+
+SmileFit SurfaceEngine::fit_smile(int64_t expiry, double time, const SmileQuotes &quotes, const SviParams *start)
+{
+    SmileFit fit;
+    fit.expiry = expiry;
+    fit.time = time;
+    fit.points = quotes.iv.size();
+
+    SviParams p;
+    if (start)
+    {
+        p = *start;
+    }
+    else
+    {
+        double min_w = INFINITY;
+        for (double iv : quotes.iv)
+        {
+            min_w = std::min(min_w, iv * iv * time);
+        }
+        p.rho = -0.3;
+        p.a = std::max(min_w - p.b * p.sigma * std::sqrt(1.0 - p.rho * p.rho), 0.0);
+    }
+    clamp(p);
+
+    // Levenberg-Marquardt on the weighted total variance residuals
+    double cost = weighted_cost(p, time, quotes);
+    double lambda = 1e-3;
+    for (int it = 0; it < max_iterations; ++it)
+    {
+        double jtj[svi_params][svi_params] = {};
+        double jtr[svi_params] = {};
+        for (size_t i = 0; i < quotes.iv.size(); ++i)
+        {
+            double x = quotes.log_moneyness[i] - p.m;
+            double root = std::sqrt(x * x + p.sigma * p.sigma);
+            double r = p.a + p.b * (p.rho * x + root) - quotes.iv[i] * quotes.iv[i] * time;
+            double j[svi_params] = {1.0, p.rho * x + root, p.b * x, -p.b * (p.rho + x / root), p.b * p.sigma / root};
+            for (size_t row = 0; row < svi_params; ++row)
+            {
+                jtr[row] += quotes.weight[i] * j[row] * r;
+                for (size_t col = 0; col < svi_params; ++col)
+                {
+                    jtj[row][col] += quotes.weight[i] * j[row] * j[col];
+                }
+            }
+        }
+
+        double system[svi_params][svi_params];
+        double rhs[svi_params];
+        for (size_t row = 0; row < svi_params; ++row)
+        {
+            for (size_t col = 0; col < svi_params; ++col)
+            {
+                system[row][col] = jtj[row][col];
+            }
+            system[row][row] += lambda * std::max(jtj[row][row], 1e-12);
+            rhs[row] = -jtr[row];
+        }
+
+        double step[svi_params];
+        if (!solve(system, rhs, step))
+        {
+            break;
+        }
+
+        SviParams candidate{p.a + step[0], p.b + step[1], p.rho + step[2], p.m + step[3], p.sigma + step[4]};
+        clamp(candidate);
+        double candidate_cost = weighted_cost(candidate, time, quotes);
+        if (candidate_cost < cost)
+        {
+            bool converged = cost - candidate_cost < 1e-14 * std::max(cost, 1e-30);
+            p = candidate;
+            cost = candidate_cost;
+            lambda = std::max(lambda * 0.3, 1e-12);
+            if (converged)
+            {
+                break;
+            }
+        }
+        else
+        {
+            lambda *= 10.0;
+            if (lambda > 1e12)
+            {
+                break;
+            }
+        }
+    }
+
+    fit.params = p;
+    fit.rmse = quote_rmse(fit, quotes);
+    return fit;
+}
+
+size_t SurfaceEngine::update(const OptionsChain &chain, int64_t now_ms)
+{
+    const auto &cols = chain.columns();
+    size_t rows = chain.size();
+
+    struct Job
+    {
+        int64_t expiry;
+        double time;
+        SmileQuotes quotes;
+        bool warm;
+        SviParams start;
+    };
+    std::vector<Job> jobs;
+    std::vector<int64_t> live_expiries;
+
+    // Rows are sorted by expiry, so each smile is a contiguous range
+    for (size_t begin = 0; begin < rows;)
+    {
+        size_t end = begin;
+        while (end < rows && cols.expiry[end] == cols.expiry[begin])
+        {
+            end++;
+        }
+        int64_t expiry = cols.expiry[begin];
+        double time = cols.time[begin];
+        SmileQuotes quotes = smile_quotes(cols, begin, end);
+        begin = end;
+
+        if (quotes.iv.size() < min_points || !(time > 0.0))
+        {
+            continue;
+        }
+        live_expiries.push_back(expiry);
+
+        auto previous = fits.find(expiry);
+        if (previous != fits.end())
+        {
+            // Re-evaluate the existing fit at the current time to expiry
+            SmileFit current = previous->second;
+            current.params.a *= time / current.time;
+            current.params.b *= time / current.time;
+            current.time = time;
+            if (quote_rmse(current, quotes) <= refit_threshold)
+            {
+                continue;
+            }
+            jobs.push_back({expiry, time, std::move(quotes), true, current.params});
+        }
+        else
+        {
+            jobs.push_back({expiry, time, std::move(quotes), false, SviParams()});
+        }
+    }
+
+    std::vector<std::future<SmileFit>> results;
+    results.reserve(jobs.size());
+    for (const auto &job : jobs)
+    {
+        const Job *j = &job;
+        results.push_back(pool.submit([j]()
+                                      { return fit_smile(j->expiry, j->time, j->quotes, j->warm ? &j->start : nullptr); }));
+    }
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        SmileFit fit = results[i].get();
+        auto previous = fits.find(fit.expiry);
+        fit.fits = previous == fits.end() ? 1 : previous->second.fits + 1;
+        fits[fit.expiry] = fit;
+    }
+
+    // Drop expiries that have left the chain or lost their quotes
+    for (auto it = fits.begin(); it != fits.end();)
+    {
+        if (!std::binary_search(live_expiries.begin(), live_expiries.end(), it->first))
+        {
+            it = fits.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    auto surface = std::make_shared<VolSurface>();
+    surface->timestamp = now_ms;
+    for (const auto &entry : fits)
+    {
+        surface->smiles.push_back(entry.second);
+    }
+    published.store(std::move(surface), std::memory_order_release);
+    return jobs.size();
+}
+
+std::shared_ptr<const VolSurface> SurfaceEngine::surface() const
+{
+    return published.load(std::memory_order_acquire);
+}
@@ -0,0 +1,173 @@
+#include "../src/include/account_cache.hpp"
+#include <json.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class AccountCacheTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    static nlohmann::json position(const string& instrument, double size) {
+        return {{"instrument_name", instrument},
+                {"size", size},
+                {"direction", size > 0 ? "buy" : size < 0 ? "sell" : "zero"},
+                {"average_price", 50000.0}};
+    }
+
+    static shared_ptr<const MarketRegistry> registry(const vector<string>& names) {
+        nlohmann::json markets = nlohmann::json::array();
+        for (const auto& name : names) {
+            markets.push_back({{"id", name}, {"symbol", name}, {"base", "BTC"}, {"quote", "USD"}, {"settle", "BTC"}, {"swap", true}});
+        }
+        return make_shared<const MarketRegistry>(markets);
+    }
+
+public:
+    bool test_balances() {
+        cout << "Testing AccountCache balances" << endl;
+
+        AccountCache cache;
+        cache.apply_balance({{"currency", "BTC"}, {"equity", 1.5}, {"available_funds", 1.0}});
+        cache.apply_balance({{"currency", "ETH"}, {"equity", 20.0}});
+        cache.apply_balance({{"currency", "BTC"}, {"equity", 1.25}, {"available_funds", 0.75}});
+
+        log_test_result("account_cache - latest summary wins", cache.balance("BTC") &&
+                                                                   (*cache.balance("BTC"))["equity"] == 1.25);
+        log_test_result("account_cache - all currencies", cache.balances().size() == 2 &&
+                                                              cache.balances().begin()->first == "BTC");
+        log_test_result("account_cache - unknown currency", !cache.balance("SOL").has_value());
+        log_test_result("account_cache - summary without currency rejected",
+                        !cache.apply_balance({{"equity", 1.0}}) && cache.balances().size() == 2);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_positions() {
+        cout << "Testing AccountCache positions" << endl;
+
+        AccountCache cache;
+        cache.replace_positions("BTC", nlohmann::json::array({position("BTC-PERPETUAL", 100), position("BTC-27JUN25", -50)}));
+        cache.replace_positions("ETH", nlohmann::json::array({position("ETH-PERPETUAL", 10)}));
+        log_test_result("account_cache - snapshot", cache.position_count() == 3 && cache.positions("BTC").size() == 2);
+
+        cache.apply_positions("BTC", position("BTC-PERPETUAL", 250));
+        log_test_result("account_cache - update", (*cache.position("BTC-PERPETUAL"))["size"] == 250.0);
+
+        cache.apply_positions("BTC", nlohmann::json::array({position("BTC-27JUN25", 0), position("BTC-PERPETUAL", 300)}));
+        log_test_result("account_cache - zero size closes", !cache.position("BTC-27JUN25") &&
+                                                                cache.positions("BTC").size() == 1 &&
+                                                                (*cache.position("BTC-PERPETUAL"))["size"] == 300.0);
+
+        cache.replace_positions("BTC", nlohmann::json::array({position("BTC-26SEP25", 20)}));
+        auto all = cache.positions();
+        log_test_result("account_cache - snapshot replaces one currency", all.size() == 2 &&
+                                                                              all[0]["instrument_name"] == "BTC-26SEP25" &&
+                                                                              all[1]["instrument_name"] == "ETH-PERPETUAL");
+
+        cache.clear();
+        log_test_result("account_cache - clear", cache.position_count() == 0 && cache.balances().empty());
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_markets() {
+        cout << "Testing AccountCache market keys" << endl;
+
+        auto markets = registry({"BTC-PERPETUAL"});
+        AccountCache cache;
+        cache.set_markets(markets);
+        cache.replace_positions("BTC", nlohmann::json::array({position("BTC-PERPETUAL", 100), position("BTC-NEW", 5)}));
+        log_test_result("account_cache - by market id", cache.position(markets->id("BTC-PERPETUAL")).has_value() &&
+                                                            cache.position("BTC-NEW").has_value() &&
+                                                            cache.position_count() == 2);
+
+        auto listed = make_shared<const MarketRegistry>(
+            nlohmann::json::array({{{"id", "BTC-NEW"}, {"symbol", "BTC-NEW"}, {"future", true}}}), *markets);
+        cache.set_markets(listed);
+        auto all = cache.positions("BTC");
+        log_test_result("account_cache - moved to market id once listed",
+                        cache.position(listed->id("BTC-NEW")).has_value() && all.size() == 2 &&
+                            all[0]["instrument_name"] == "BTC-NEW");
+
+        cache.apply_positions("BTC", position("BTC-NEW", 0));
+        log_test_result("account_cache - close by market id", !cache.position("BTC-NEW") && cache.position_count() == 1);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_snapshot_versions() {
+        cout << "Testing AccountCache snapshot versions" << endl;
+
+        AccountCache cache;
+        cache.apply_balance({{"currency", "BTC"}, {"equity", 1.0}});
+        cache.apply_positions("BTC", position("BTC-PERPETUAL", 100));
+        cache.apply_positions("BTC", position("BTC-27JUN25", 10));
+        uint64_t since = cache.version();
+
+        // Stream updates land while the snapshot is in flight
+        cache.apply_balance({{"currency", "BTC"}, {"equity", 2.0}});
+        cache.apply_positions("BTC", position("BTC-PERPETUAL", 200));
+        cache.apply_positions("BTC", position("BTC-27JUN25", 0));
+        cache.apply_positions("BTC", position("BTC-26SEP25", 30));
+
+        // The snapshot reflects the state before them
+        bool stale_balance = cache.apply_balance({{"currency", "BTC"}, {"equity", 1.0}}, since);
+        cache.replace_positions("BTC", nlohmann::json::array({position("BTC-PERPETUAL", 100), position("BTC-27JUN25", 10),
+                                                             position("BTC-27DEC25", 5)}),
+                                since);
+
+        log_test_result("account_cache - newer balance kept", !stale_balance && (*cache.balance("BTC"))["equity"] == 2.0);
+        log_test_result("account_cache - newer positions kept",
+                        (*cache.position("BTC-PERPETUAL"))["size"] == 200 && !cache.position("BTC-27JUN25") &&
+                            cache.position("BTC-26SEP25").has_value());
+        log_test_result("account_cache - untouched snapshot positions applied",
+                        cache.position("BTC-27DEC25").has_value() && cache.position_count() == 3);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " ACCOUNT CACHE TEST" << endl;
+
+        test_balances();
+        test_positions();
+        test_markets();
+        test_snapshot_versions();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        AccountCacheTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,411 @@
+#include "../src/include/book_manager.hpp"
+#include <json.hpp>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+class BookManagerTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    static nlohmann::json snapshot_frame(const string& instrument, int64_t change_id) {
+        return {
+            {"type", "snapshot"},
+            {"instrument_name", instrument},
+            {"timestamp", 1000},
+            {"change_id", change_id},
+            {"bids", {{"new", 100.0, 1.0}, {"new", 99.5, 2.0}}},
+            {"asks", {{"new", 100.5, 3.0}, {"new", 101.0, 4.0}}}
+        };
+    }
+
+    static nlohmann::json change_frame(const string& instrument, int64_t prev, int64_t change_id, double bid_amount) {
+        return {
+            {"type", "change"},
+            {"instrument_name", instrument},
+            {"timestamp", 1000 + change_id},
+            {"prev_change_id", prev},
+            {"change_id", change_id},
+            {"bids", {{"change", 100.0, bid_amount}}},
+            {"asks", nlohmann::json::array()}
+        };
+    }
+
+public:
+    bool test_order_book_apply() {
+        cout << "Testing OrderBook::apply()" << endl;
+
+        OrderBook book("BTC-PERPETUAL");
+        bool rejected_before_snapshot = !book.apply(change_frame("BTC-PERPETUAL", 1, 2, 5.0));
+        log_test_result("order_book - change before snapshot rejected", rejected_before_snapshot);
+
+        book.apply(snapshot_frame("BTC-PERPETUAL", 1));
+        auto bids = book.bids();
+        auto asks = book.asks();
+        bool sorted = bids.size() == 2 && bids[0].price == 100.0 && asks.size() == 2 && asks[0].price == 100.5;
+        log_test_result("order_book - snapshot sorted", sorted);
+
+        book.apply(change_frame("BTC-PERPETUAL", 1, 2, 5.0));
+        log_test_result("order_book - change applied", book.bids()[0].amount == 5.0 && book.change_id() == 2);
+
+        nlohmann::json del = change_frame("BTC-PERPETUAL", 2, 3, 0.0);
+        del["bids"] = {{"delete", 100.0, 0.0}};
+        book.apply(del);
+        log_test_result("order_book - delete removes level", book.bids().size() == 1 && book.bids()[0].price == 99.5);
+
+        bool gap_detected = !book.apply(change_frame("BTC-PERPETUAL", 7, 8, 1.0)) && !book.in_sync() && book.gaps() == 1;
+        log_test_result("order_book - gap detected", gap_detected);
+
+        book.apply(snapshot_frame("BTC-PERPETUAL", 10));
+        log_test_result("order_book - snapshot resyncs", book.in_sync() && book.bids().size() == 2);
+
+        OrderBook grouped("ETH-PERPETUAL");
+        grouped.apply({{"instrument_name", "ETH-PERPETUAL"}, {"change_id", 5}, {"bids", {{10.0, 1.0}}}, {"asks", {{11.0, 2.0}}}});
+        grouped.apply({{"instrument_name", "ETH-PERPETUAL"}, {"change_id", 6}, {"bids", {{9.0, 1.0}}}, {"asks", {{12.0, 2.0}}}});
+        log_test_result("order_book - grouped book replaced", grouped.bids().size() == 1 && grouped.bids()[0].price == 9.0);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_depth_ladder() {
+        cout << "Testing DepthLadder" << endl;
+
+        OrderBook book("BTC-PERPETUAL");
+        DepthLadder ladder(5.0);
+        book.add_listener(&ladder);
+
+        book.apply({
+            {"type", "snapshot"}, {"instrument_name", "BTC-PERPETUAL"}, {"change_id", 1},
+            {"bids", {{"new", 100.0, 1.0}, {"new", 99.5, 2.0}, {"new", 94.0, 4.0}}},
+            {"asks", {{"new", 100.5, 3.0}, {"new", 105.0, 1.0}, {"new", 106.0, 2.0}}}
+        });
+
+        LadderView view = ladder.view();
+        bool grouped = view.bids.size() == 3 && view.bids[0].price == 100.0 && view.bids[0].amount == 1.0
+                    && view.bids[1].price == 95.0 && view.bids[1].amount == 2.0
+                    && view.asks.size() == 2 && view.asks[0].price == 105.0 && view.asks[0].amount == 4.0
+                    && view.asks[1].price == 110.0 && view.asks[1].amount == 2.0;
+        log_test_result("depth_ladder - initial grouping", grouped);
+
+        book.apply({
+            {"type", "change"}, {"instrument_name", "BTC-PERPETUAL"}, {"prev_change_id", 1}, {"change_id", 2},
+            {"bids", {{"delete", 100.0, 0.0}, {"new", 97.0, 1.5}}},
+            {"asks", {{"change", 105.0, 0.5}}}
+        });
+        view = ladder.view();
+        bool incremental = view.bids.size() == 2 && view.bids[0].price == 95.0 && view.bids[0].amount == 3.5
+                        && view.asks[0].amount == 3.5;
+        log_test_result("depth_ladder - incremental update", incremental);
+
+        BookManager manager(1, 64, 5);
+        manager.set_ladder_groups({0.5, 5.0, 50.0});
+        manager.start();
+        manager.submit(snapshot_frame("BTC-PERPETUAL", 1));
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+        while (manager.processed() < 1 && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        auto snap = manager.snapshot("BTC-PERPETUAL");
+        bool published = snap && snap->ladders.size() == 3 && snap->ladders[2].group == 50.0
+                      && snap->ladders[2].bids.size() == 2 && snap->ladders[2].bids[1].price == 50.0
+                      && snap->ladders[2].asks.size() == 1 && snap->ladders[2].asks[0].amount == 7.0;
+        log_test_result("depth_ladder - published in snapshot", published);
+        manager.stop();
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_book_analytics() {
+        cout << "Testing BookAnalytics" << endl;
+
+        const size_t levels = 3;
+        const double vwap_size = 4.0;
+        OrderBook book("BTC-PERPETUAL");
+        BookAnalytics analytics(levels, vwap_size);
+        book.add_listener(&analytics);
+
+        book.apply({
+            {"type", "snapshot"}, {"instrument_name", "BTC-PERPETUAL"}, {"change_id", 1},
+            {"bids", {{"new", 100.0, 1.0}, {"new", 99.0, 2.0}, {"new", 98.0, 3.0}, {"new", 97.0, 4.0}}},
+            {"asks", {{"new", 101.0, 3.0}, {"new", 102.0, 1.0}, {"new", 103.0, 5.0}}}
+        });
+
+        const BookSignals& s = analytics.signals();
+        bool top = s.best_bid == 100.0 && s.best_ask == 101.0 && abs(s.microprice - (100.0 * 3.0 + 101.0 * 1.0) / 4.0) < 1e-12;
+        log_test_result("book_analytics - microprice", top);
+        log_test_result("book_analytics - imbalance", s.bid_depth == 6.0 && s.ask_depth == 9.0 && abs(s.imbalance + 0.2) < 1e-12);
+        log_test_result("book_analytics - depth vwap", abs(s.vwap_buy - (3.0 * 101.0 + 102.0) / 4.0) < 1e-12
+                                                    && abs(s.vwap_sell - (100.0 + 2.0 * 99.0 + 98.0) / 4.0) < 1e-12);
+
+        // Random walk of deltas checked against a full recomputation
+        srand(7);
+        bool consistent = true;
+        for (int64_t change = 2; change < 500 && consistent; ++change) {
+            double bid_price = 90.0 + rand() % 11;
+            double ask_price = 101.0 + rand() % 11;
+            double bid_amount = (rand() % 4 == 0) ? 0.0 : 1.0 + rand() % 5;
+            double ask_amount = (rand() % 4 == 0) ? 0.0 : 1.0 + rand() % 5;
+            book.apply({
+                {"type", "change"}, {"instrument_name", "BTC-PERPETUAL"}, {"prev_change_id", change - 1}, {"change_id", change},
+                {"bids", {{bid_amount == 0.0 ? "delete" : "change", bid_price, bid_amount}}},
+                {"asks", {{ask_amount == 0.0 ? "delete" : "change", ask_price, ask_amount}}}
+            });
+
+            auto bids = book.bids();
+            auto asks = book.asks();
+            double bid_depth = 0.0, ask_depth = 0.0;
+            for (size_t i = 0; i < levels && i < bids.size(); ++i) bid_depth += bids[i].amount;
+            for (size_t i = 0; i < levels && i < asks.size(); ++i) ask_depth += asks[i].amount;
+
+            auto fill = [vwap_size](const vector<BookLevel>& side) -> double {
+                double remaining = vwap_size, notional = 0.0;
+                for (const auto& level : side) {
+                    double take = min(remaining, level.amount);
+                    notional += take * level.price;
+                    remaining -= take;
+                    if (remaining <= 0.0) return notional / vwap_size;
+                }
+                return NAN;
+            };
+            double vwap_buy = fill(asks);
+            double vwap_sell = fill(bids);
+
+            const BookSignals& cur = analytics.signals();
+            auto same = [](double a, double b) { return (isnan(a) && isnan(b)) || abs(a - b) < 1e-9; };
+            if (!same(cur.bid_depth, bid_depth) || !same(cur.ask_depth, ask_depth)
+                || !same(cur.vwap_buy, vwap_buy) || !same(cur.vwap_sell, vwap_sell)) {
+                consistent = false;
+            }
+        }
+        log_test_result("book_analytics - incremental matches recomputation", consistent);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_book_manager() {
+        cout << "Testing BookManager" << endl;
+
+        BookManager manager(4, 1024, 5);
+
+        bool stable = manager.shard_for("BTC-PERPETUAL") == manager.shard_for("BTC-PERPETUAL");
+        bool in_range = manager.shard_for("ETH-PERPETUAL") < manager.shard_count();
+        log_test_result("book_manager - consistent shard assignment", stable && in_range);
+
+        manager.start();
+
+        const int instruments = 16;
+        const int updates = 200;
+        for (int i = 0; i < instruments; ++i) {
+            while (!manager.submit(snapshot_frame("TEST-" + to_string(i), 1))) {
+                this_thread::yield();
+            }
+        }
+        for (int u = 0; u < updates; ++u) {
+            for (int i = 0; i < instruments; ++i) {
+                while (!manager.submit(change_frame("TEST-" + to_string(i), u + 1, u + 2, u + 1.0))) {
+                    this_thread::yield();
+                }
+            }
+        }
+
+        uint64_t expected = instruments + instruments * updates;
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+        while (manager.processed() < expected && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        log_test_result("book_manager - all updates processed", manager.processed() == expected,
+                        "processed " + to_string(manager.processed()) + " of " + to_string(expected));
+
+        bool ordered = true;
+        for (int i = 0; i < instruments; ++i) {
+            auto snap = manager.snapshot("TEST-" + to_string(i));
+            if (!snap || snap->change_id != updates + 1 || snap->bids.empty() || snap->bids[0].amount != updates) {
+                ordered = false;
+                break;
+            }
+        }
+        log_test_result("book_manager - per-instrument ordering preserved", ordered);
+
+        nlohmann::json stats = manager.stats();
+        uint64_t gaps = 0;
+        for (auto& shard : stats) {
+            gaps += shard["gaps"].get<uint64_t>();
+        }
+        log_test_result("book_manager - no sequence gaps", gaps == 0);
+        log_test_result("book_manager - unknown instrument", manager.snapshot("UNKNOWN") == nullptr);
+
+        manager.stop();
+
+        // Books of registered instruments are keyed by MarketId
+        auto markets = make_shared<const MarketRegistry>(nlohmann::json::array(
+            {{{"id", "TEST-0"}, {"symbol", "TEST-0"}, {"swap", true}}, {{"id", "TEST-1"}, {"symbol", "TEST-1"}, {"swap", true}}}));
+        BookManager keyed(2, 1024, 5);
+        keyed.set_markets(markets);
+        keyed.start();
+        keyed.submit(snapshot_frame("TEST-1", 7));
+        keyed.submit(snapshot_frame("OTHER", 3));
+        deadline = chrono::steady_clock::now() + chrono::seconds(10);
+        while (keyed.processed() < 2 && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        auto by_id = keyed.snapshot(markets->id("TEST-1"));
+        log_test_result("book_manager - snapshot by market id", by_id && by_id->change_id == 7 &&
+                                                                    keyed.snapshot("TEST-1") == by_id &&
+                                                                    !keyed.snapshot(markets->id("TEST-0")));
+        log_test_result("book_manager - unregistered instrument", keyed.snapshot("OTHER") &&
+                                                                      keyed.snapshot("OTHER")->change_id == 3);
+        keyed.stop();
+        return tests_passed == tests_run;
+    }
+
+    bool test_book_manager_sync() {
+        cout << "Testing BookManager backpressure and resync" << endl;
+
+        // Room for every frame, so none is dropped
+        BookManager manager(1, 4096, 5);
+        atomic<int> resyncs{0};
+        string resynced;
+        manager.set_resync_handler([&](const string& instrument) {
+            resynced = instrument;
+            resyncs++;
+        });
+        manager.start();
+
+        auto handler = manager.handler();
+        const int updates = 2000;
+        handler(snapshot_frame("SYNC-1", 1));
+        for (int u = 0; u < updates; ++u) {
+            handler(change_frame("SYNC-1", u + 1, u + 2, u + 1.0));
+        }
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+        while (manager.processed() < updates + 1 && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        auto snap = manager.snapshot("SYNC-1");
+        log_test_result("book_manager - incremental frames applied in order",
+                        manager.dropped() == 0 && snap && snap->in_sync && snap->change_id == updates + 1,
+                        "dropped " + to_string(manager.dropped()));
+
+        // Skip a change id: readers see the book flagged, the owner is asked to resync
+        handler(change_frame("SYNC-1", updates + 5, updates + 6, 1.0));
+        handler(change_frame("SYNC-1", updates + 6, updates + 7, 1.0));
+        deadline = chrono::steady_clock::now() + chrono::seconds(10);
+        while (manager.processed() < updates + 3 && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        snap = manager.snapshot("SYNC-1");
+        log_test_result("book_manager - gap publishes out-of-sync snapshot", snap && !snap->in_sync &&
+                                                                              snap->change_id == updates + 1);
+        log_test_result("book_manager - gap requests one resync", resyncs == 1 && resynced == "SYNC-1",
+                        to_string(resyncs.load()));
+
+        handler(snapshot_frame("SYNC-1", updates + 10));
+        deadline = chrono::steady_clock::now() + chrono::seconds(10);
+        while (manager.processed() < updates + 4 && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        snap = manager.snapshot("SYNC-1");
+        log_test_result("book_manager - snapshot restores sync", snap && snap->in_sync && snap->change_id == updates + 10);
+
+        manager.stop();
+        return tests_passed == tests_run;
+    }
+
+    bool test_book_manager_overflow() {
+        cout << "Testing BookManager full shard queue" << endl;
+
+        // Stall the worker inside the first update so the 2-slot queue fills
+        BookManager manager(1, 2, 5);
+        atomic<bool> release{false};
+        atomic<int> resyncs{0};
+        manager.set_update_handler([&](const OrderBook&) {
+            while (!release) {
+                this_thread::yield();
+            }
+        });
+        manager.set_resync_handler([&](const string& instrument) {
+            if (instrument == "OVER-1") {
+                resyncs++;
+            }
+        });
+        manager.start();
+
+        auto handler = manager.handler();
+        handler(snapshot_frame("OVER-1", 1));
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+        while (manager.stats()[0]["queueDepth"] != 0 && chrono::steady_clock::now() < deadline) {
+            this_thread::yield();
+        }
+
+        auto started = chrono::steady_clock::now();
+        for (int u = 1; u <= 10; ++u) {
+            handler(change_frame("OVER-1", u, u + 1, 1.0));
+        }
+        auto elapsed = chrono::steady_clock::now() - started;
+        log_test_result("book_manager - full queue does not stall the producer",
+                        manager.dropped() > 0 && elapsed < chrono::seconds(1),
+                        "dropped " + to_string(manager.dropped()));
+
+        release = true;
+        deadline = chrono::steady_clock::now() + chrono::seconds(10);
+        while (resyncs == 0 && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        auto snap = manager.snapshot("OVER-1");
+        log_test_result("book_manager - dropped frame resyncs the book",
+                        resyncs == 1 && snap && !snap->in_sync, to_string(resyncs.load()));
+
+        manager.stop();
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " BOOK MANAGER TEST" << endl;
+
+        test_order_book_apply();
+        test_depth_ladder();
+        test_book_analytics();
+        test_book_manager();
+        test_book_manager_sync();
+        test_book_manager_overflow();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        BookManagerTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
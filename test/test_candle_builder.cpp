@@ -0,0 +1,177 @@
+#include "../src/include/candle_builder.hpp"
+#include <json.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static atomic<uint64_t> allocations{0};
+
+void *operator new(size_t size)
+{
+    allocations++;
+    if (void *p = malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+class CandleBuilderTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+public:
+    bool test_bars() {
+        cout << "Testing CandleBuilder bars" << endl;
+
+        CandleBuilder builder({1000, 60000}, 4);
+        vector<pair<int64_t, Candle>> closed;
+        builder.set_close_handler([&](const string &, int64_t frame, const Candle &bar)
+                                  { closed.push_back({frame, bar}); });
+
+        builder.add_trade("BTC-PERPETUAL", 1000, 100.0, 1.0);
+        builder.add_trade("BTC-PERPETUAL", 1500, 105.0, 2.0);
+        builder.add_trade("BTC-PERPETUAL", 1999, 95.0, 1.0);
+        builder.add_trade("BTC-PERPETUAL", 2100, 101.0, 3.0);
+
+        const Candle *open = builder.current("BTC-PERPETUAL", 60000);
+        auto seconds = builder.candles("BTC-PERPETUAL", 1000);
+        bool first = seconds.size() == 1 && seconds[0].start == 1000 && seconds[0].open == 100.0 &&
+                     seconds[0].high == 105.0 && seconds[0].low == 95.0 && seconds[0].close == 95.0 &&
+                     seconds[0].volume == 4.0 && seconds[0].trades == 3;
+        log_test_result("candle_builder - ohlcv", first);
+        log_test_result("candle_builder - close callback", closed.size() == 1 && closed[0].first == 1000);
+        log_test_result("candle_builder - minute bar still open",
+                        open && open->start == 0 && open->trades == 4 && open->volume == 7.0);
+
+        builder.add_trade("BTC-PERPETUAL", 1800, 200.0, 1.0);
+        log_test_result("candle_builder - late trade ignored",
+                        builder.late_trades() == 1 && builder.current("BTC-PERPETUAL", 1000)->high == 101.0);
+
+        for (int64_t t = 3000; t < 10000; t += 1000)
+        {
+            builder.add_trade("BTC-PERPETUAL", t, 100.0 + t / 1000, 1.0);
+        }
+        auto kept = builder.candles("BTC-PERPETUAL", 1000);
+        auto last_two = builder.candles("BTC-PERPETUAL", 1000, 2);
+        log_test_result("candle_builder - ring keeps latest bars",
+                        kept.size() == 4 && kept.front().start == 5000 && kept.back().start == 8000);
+        log_test_result("candle_builder - limit", last_two.size() == 2 && last_two[0].start == 7000);
+
+        closed.clear();
+        builder.flush(60000);
+        log_test_result("candle_builder - flush closes due bars",
+                        closed.size() == 2 && builder.current("BTC-PERPETUAL", 1000) == nullptr);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_notifications() {
+        cout << "Testing CandleBuilder::on_trades()" << endl;
+
+        CandleBuilder builder;
+        auto handler = builder.handler();
+        handler(nlohmann::json::parse(R"([
+            {"instrument_name": "BTC-PERPETUAL", "timestamp": 1700000000100, "price": 35000.5, "amount": 10, "direction": "buy"},
+            {"instrument_name": "ETH-PERPETUAL", "timestamp": 1700000000200, "price": 1900.0, "amount": 3, "direction": "sell"},
+            {"instrument_name": "BTC-PERPETUAL", "timestamp": 1700000000300, "price": 35001.0, "amount": 5, "direction": "buy"}
+        ])"));
+
+        const Candle *btc = builder.current("BTC-PERPETUAL", 3600000);
+        const Candle *eth = builder.current("ETH-PERPETUAL", 1000);
+        log_test_result("candle_builder - instruments separated",
+                        btc && btc->trades == 2 && btc->close == 35001.0 && eth && eth->volume == 3.0);
+        log_test_result("candle_builder - default timeframes", builder.timeframes().size() == 4);
+
+        bool threw = false;
+        try
+        {
+            builder.candles("BTC-PERPETUAL", 42);
+        }
+        catch (const exception &)
+        {
+            threw = true;
+        }
+        log_test_result("candle_builder - unknown timeframe rejected", threw);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_no_allocation() {
+        cout << "Testing CandleBuilder steady-state allocations" << endl;
+
+        CandleBuilder builder;
+        uint64_t closes = 0;
+        builder.set_close_handler([&](const string &, int64_t, const Candle &)
+                                  { closes++; });
+        string instrument = "BTC-PERPETUAL";
+        builder.add_trade(instrument, 0, 100.0, 1.0);
+
+        uint64_t before = allocations.load();
+        for (int64_t t = 1; t < 2000000; t += 97)
+        {
+            builder.add_trade(instrument, t, 100.0 + (t % 13), 1.0);
+        }
+        uint64_t used = allocations.load() - before;
+
+        log_test_result("candle_builder - no per-trade allocation", used == 0 && closes > 0,
+                        to_string(used) + " allocations");
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " CANDLE BUILDER TEST" << endl;
+
+        test_bars();
+        test_notifications();
+        test_no_allocation();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        CandleBuilderTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -5,6 +5,9 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <set>
+#include <algorithm>
 
 using namespace std;
 
@@ -417,7 +420,19 @@ public:
                               string("Failed on repeated auth: ") + e.what());
             }
             
-            // Test 3: Test authentication timeout/expiry handling
+            // Test 3: Authenticated calls take the lock-free fast path
+            {
+                const int calls = 100000;
+                auto started = chrono::steady_clock::now();
+                for (int i = 0; i < calls; i++) {
+                    client->authenticate();
+                }
+                double ns_per_call = chrono::duration<double, nano>(chrono::steady_clock::now() - started).count() / calls;
+                log_test_result("authentication - fast path", ns_per_call < 100.0,
+                              to_string(ns_per_call) + " ns per call");
+            }
+
+            // Test 4: Test authentication timeout/expiry handling
             cout << "Testing authentication persistence..." << endl;
             
             // Wait a short time and test again
@@ -433,7 +448,7 @@ public:
                               string("Auth persistence failed: ") + e.what());
             }
             
-            // Test 4: Test that authenticated calls work - try a private endpoint
+            // Test 5: Test that authenticated calls work - try a private endpoint
             bool private_endpoint_test = false;
             try {
                 // Try to fetch balance (requires authentication)
@@ -466,7 +481,7 @@ public:
                 }
             }
             
-            // Test 5: Test signature generation (indirect test)
+            // Test 6: Test signature generation (indirect test)
             bool signature_test = true;
             try {
                 // Call authenticate again to test signature generation
@@ -479,7 +494,7 @@ public:
                               string("Signature generation failed: ") + e.what());
             }
             
-            // Test 6: Validate that we're using testnet
+            // Test 7: Validate that we're using testnet
             cout << "Environment Check:" << endl;
             cout << "  Using testnet environment: true" << endl;
             log_test_result("authentication - environment check", true, "Running on testnet");
@@ -1287,6 +1302,17 @@ bool test_watch_orders()
         cout << "Waiting for initial order updates (5 seconds)..." << endl;
         this_thread::sleep_for(chrono::seconds(5));
 
+        // Open orders are now answered from the local store
+        bool live = client->order_stream_live();
+        log_test_result("watch_orders - order store live", live);
+        if (!test_order_id.empty())
+        {
+            auto open = client->fetch_open_orders("BTC-PERPETUAL");
+            bool listed = std::any_of(open.begin(), open.end(), [&](const nlohmann::json &o)
+                                      { return o.value("id", "") == test_order_id; });
+            log_test_result("fetch_open_orders - order listed", listed, to_string(open.size()) + " open");
+        }
+
         // Step 6: If we created an order, modify it to generate updates
         if (!test_order_id.empty())
         {
@@ -1662,6 +1688,303 @@ bool test_watch_order_book()
     }
 }
 
+bool test_watch_ticker()
+{
+    cout << "Testing watch_ticker()" << endl;
+
+    try
+    {
+        std::atomic<int> updates_received{0};
+        std::atomic<bool> fields_valid{false};
+        string test_symbol = "BTC-PERPETUAL";
+
+        auto tickerHandler = [&](const nlohmann::json &ticker)
+        {
+            updates_received++;
+            if (ticker.value("instrument_name", "") == test_symbol &&
+                ticker.contains("best_bid_price") && ticker.contains("best_ask_price") &&
+                ticker.contains("mark_price"))
+            {
+                fields_valid = true;
+            }
+        };
+
+        client->watch_ticker(tickerHandler, test_symbol, {{"interval", "100ms"}});
+
+        for (int i = 0; i < 50 && updates_received < 3; ++i)
+        {
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+
+        log_test_result("watch_ticker - updates received", updates_received > 0,
+                        "Updates received: " + to_string(updates_received.load()));
+        log_test_result("watch_ticker - ticker fields", fields_valid);
+
+        return updates_received > 0 && fields_valid;
+    }
+    catch (const exception &e)
+    {
+        log_test_result("watch_ticker - exception handling", false,
+                        string("Exception: ") + e.what());
+        return false;
+    }
+}
+
+bool test_watch_trades()
+{
+    cout << "Testing watch_trades()" << endl;
+
+    try
+    {
+        std::atomic<int> batches_received{0};
+        std::atomic<bool> fields_valid{false};
+        string test_symbol = "BTC-PERPETUAL";
+
+        auto tradesHandler = [&](const nlohmann::json &trades)
+        {
+            batches_received++;
+            if (trades.is_array() && !trades.empty() &&
+                trades[0].value("instrument_name", "") == test_symbol &&
+                trades[0].contains("price") && trades[0].contains("amount") &&
+                trades[0].contains("timestamp"))
+            {
+                fields_valid = true;
+            }
+        };
+
+        client->watch_trades(tradesHandler, test_symbol, 0, 0, {{"interval", "100ms"}});
+
+        for (int i = 0; i < 100 && batches_received < 1; ++i)
+        {
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+
+        log_test_result("watch_trades - trades received", batches_received > 0,
+                        "Batches received: " + to_string(batches_received.load()));
+        log_test_result("watch_trades - trade fields", fields_valid);
+
+        return batches_received > 0 && fields_valid;
+    }
+    catch (const exception &e)
+    {
+        log_test_result("watch_trades - exception handling", false,
+                        string("Exception: ") + e.what());
+        return false;
+    }
+}
+
+bool test_watch_tickers()
+{
+    cout << "Testing watch_tickers()" << endl;
+
+    try
+    {
+        std::mutex seen_mutex;
+        std::set<string> seen;
+        vector<string> symbols = {"BTC-PERPETUAL", "ETH-PERPETUAL"};
+
+        auto tickersHandler = [&](const nlohmann::json &ticker)
+        {
+            std::lock_guard<std::mutex> lock(seen_mutex);
+            seen.insert(ticker.value("instrument_name", ""));
+        };
+
+        client->watch_tickers(tickersHandler, symbols, {{"interval", "100ms"}});
+
+        size_t seen_count = 0;
+        for (int i = 0; i < 50 && seen_count < symbols.size(); ++i)
+        {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            std::lock_guard<std::mutex> lock(seen_mutex);
+            seen_count = seen.count(symbols[0]) + seen.count(symbols[1]);
+        }
+
+        log_test_result("watch_tickers - all symbols received", seen_count == symbols.size(),
+                        "Symbols received: " + to_string(seen_count));
+
+        return seen_count == symbols.size();
+    }
+    catch (const exception &e)
+    {
+        log_test_result("watch_tickers - exception handling", false,
+                        string("Exception: ") + e.what());
+        return false;
+    }
+}
+
+bool test_unwatch_ticker()
+{
+    cout << "Testing unwatch_ticker()" << endl;
+
+    try
+    {
+        std::atomic<int> updates_received{0};
+        string test_symbol = "ETH-PERPETUAL";
+
+        client->watch_ticker([&](const nlohmann::json &)
+                             { updates_received++; },
+                             test_symbol, {{"interval", "100ms"}});
+
+        for (int i = 0; i < 50 && updates_received == 0; ++i)
+        {
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+
+        client->unwatch_ticker(test_symbol, {{"interval", "100ms"}});
+        this_thread::sleep_for(chrono::milliseconds(200));
+        int after_unwatch = updates_received;
+        this_thread::sleep_for(chrono::milliseconds(1000));
+
+        log_test_result("unwatch_ticker - updates received before", after_unwatch > 0);
+        log_test_result("unwatch_ticker - updates stopped", updates_received == after_unwatch,
+                        "Updates after unwatch: " + to_string(updates_received - after_unwatch));
+
+        return after_unwatch > 0 && updates_received == after_unwatch;
+    }
+    catch (const exception &e)
+    {
+        log_test_result("unwatch_ticker - exception handling", false,
+                        string("Exception: ") + e.what());
+        return false;
+    }
+}
+
+bool test_rpc_stats()
+{
+    cout << "Testing rpc_stats()" << endl;
+
+    try
+    {
+        client->reset_rpc_stats();
+        client->fetch_ticker("BTC-PERPETUAL");
+        auto stats = client->rpc_stats();
+        auto ticker = stats["methods"].value("public/ticker", nlohmann::json::object());
+
+        bool counted = ticker.value("requests", 0) == 1 && ticker["latency"].value("count", 0) == 1;
+        log_test_result("rpc_stats - request counted", counted, stats.dump());
+        log_test_result("rpc_stats - latency recorded", counted && ticker["latency"].value("p50Us", 0.0) > 0.0);
+
+        return counted;
+    }
+    catch (const exception &e)
+    {
+        log_test_result("rpc_stats - exception handling", false,
+                        string("Exception: ") + e.what());
+        return false;
+    }
+}
+
+bool test_load_markets_subset()
+{
+    cout << "Testing load_markets() by currency" << endl;
+
+    try
+    {
+        Deribit subset_client({{"is_test", true}});
+        subset_client.load_markets(true, {{"currencies", {"BTC"}}});
+        auto btc = subset_client.market_registry();
+        bool only_btc = btc && !btc->empty() && btc->id("BTC-PERPETUAL") != MarketRegistry::npos &&
+                        btc->id("ETH-PERPETUAL") == MarketRegistry::npos;
+        log_test_result("load_markets - currency subset", only_btc);
+
+        subset_client.load_markets(true, {{"currencies", {"ETH"}}, {"merge", true}});
+        auto merged = subset_client.market_registry();
+        bool both = merged && merged->size() > btc->size() && merged->id("BTC-PERPETUAL") != MarketRegistry::npos &&
+                    merged->id("ETH-PERPETUAL") != MarketRegistry::npos;
+        log_test_result("load_markets - merged subsets", both);
+
+        auto requests = subset_client.rpc_stats()["methods"]["public/get_instruments"].value("requests", 0);
+        log_test_result("load_markets - one request per currency and kind", requests == 10, to_string(requests));
+
+        return only_btc && both;
+    }
+    catch (const exception &e)
+    {
+        log_test_result("load_markets - subset exception handling", false,
+                        string("Exception: ") + e.what());
+        return false;
+    }
+}
+
+bool test_watch_account()
+{
+    cout << "Testing watch_account()" << endl;
+
+    try
+    {
+        client->watch_account({{"currencies", {"BTC", "ETH", "USDC"}}});
+        bool live = client->account_stream_live();
+        log_test_result("watch_account - cache live", live);
+
+        auto balances = client->account_cache().balances();
+        bool seeded = balances.count("BTC") && balances.count("ETH") && balances.count("USDC");
+        log_test_result("watch_account - balances seeded", seeded, to_string(balances.size()) + " currencies");
+
+        client->reset_rpc_stats();
+        auto balance = client->fetch_balance();
+        auto positions = client->fetch_positions();
+        auto methods = client->rpc_stats()["methods"];
+        bool cached = balance.contains("BTC") && balance.contains("ETH") && positions.is_array() &&
+                      !methods.contains("private/get_account_summary") && !methods.contains("private/get_positions");
+        log_test_result("watch_account - reads served from cache", cached, methods.dump());
+
+        client->unwatch_account();
+        log_test_result("unwatch_account - cache no longer live", !client->account_stream_live());
+
+        return live && seeded && cached;
+    }
+    catch (const exception &e)
+    {
+        log_test_result("watch_account - exception handling", false,
+                        string("Exception: ") + e.what());
+        return false;
+    }
+}
+
+bool test_bulk_order_operations()
+{
+    cout << "Testing edit_order() and bulk cancels" << endl;
+
+    try
+    {
+        string test_symbol = "BTC-PERPETUAL";
+        nlohmann::json params = {{"postOnly", true}, {"timeInForce", "GTC"}};
+        vector<string> ids;
+        for (double price : {1000.0, 1010.0, 1020.0})
+        {
+            ids.push_back(client->create_order(test_symbol, "limit", "buy", 10, price, params).value("id", ""));
+        }
+
+        auto edited = client->edit_order(ids[0], test_symbol, "limit", "buy", 20, 1005.0);
+        bool amended = edited.value("id", "") == ids[0] && edited["info"].value("amount", 0.0) == 20.0 &&
+                       edited["info"].value("price", 0.0) == 1005.0;
+        log_test_result("edit_order - amended in place", amended, edited["info"].dump());
+
+        auto cancelled = client->cancel_orders({ids[0], ids[1]}, test_symbol);
+        bool all_cancelled = cancelled.size() == 2;
+        for (size_t i = 0; i < cancelled.size() && all_cancelled; ++i)
+        {
+            all_cancelled = cancelled[i].value("id", "") == ids[i] && cancelled[i].value("status", "") == "cancelled";
+        }
+        log_test_result("cancel_orders - replies in request order", all_cancelled, cancelled.dump());
+
+        auto rest = client->cancel_all_orders(test_symbol);
+        bool swept = rest.value("cancelled", 0) >= 1;
+        log_test_result("cancel_all_orders - by instrument", swept, rest.dump());
+
+        auto none = client->cancel_all_by_label("no-such-label");
+        log_test_result("cancel_all_by_label - nothing to cancel", none.value("cancelled", -1) == 0, none.dump());
+
+        return amended && all_cancelled && swept;
+    }
+    catch (const exception &e)
+    {
+        log_test_result("bulk order operations - exception handling", false,
+                        string("Exception: ") + e.what());
+        return false;
+    }
+}
+
     void run_all_tests() {
 
         cout << " DERIBIT EXCHANGE TEST" << endl;
@@ -1669,6 +1992,7 @@ bool test_watch_order_book()
 
         //working 
         bool load_markets_passed = test_load_markets();
+        bool load_markets_subset_passed = test_load_markets_subset();
         bool fetch_markets_passed = test_fetch_markets();
         bool fetch_order_book_passed = test_fetch_order_book();
         bool fetch_ticker_passed = test_fetch_ticker();
@@ -1679,6 +2003,13 @@ bool test_watch_order_book()
         bool cancel_order_passed = test_cancel_order();
         bool watch_orders_passed = test_watch_orders();
         bool watch_order_book_passed = test_watch_order_book();
+        bool watch_ticker_passed = test_watch_ticker();
+        bool watch_trades_passed = test_watch_trades();
+        bool watch_tickers_passed = test_watch_tickers();
+        bool unwatch_ticker_passed = test_unwatch_ticker();
+        bool rpc_stats_passed = test_rpc_stats();
+        bool bulk_order_operations_passed = test_bulk_order_operations();
+        bool watch_account_passed = test_watch_account();
         
      
         cout << "TEST SUMMARY" << endl;
@@ -0,0 +1,165 @@
+#include "../src/include/dispatch_queue.hpp"
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class DispatchQueueTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    struct Recorder
+    {
+        mutex mtx;
+        vector<pair<string, int>> seen;
+        atomic<bool> gate{true};
+
+        DispatchQueue::Sink sink()
+        {
+            return [this](const string &channel, const nlohmann::json &data)
+            {
+                while (!gate.load())
+                {
+                    this_thread::sleep_for(chrono::microseconds(100));
+                }
+                lock_guard<mutex> lock(mtx);
+                seen.push_back({channel, data.get<int>()});
+            };
+        }
+    };
+
+public:
+    bool test_policies() {
+        cout << "Testing DispatchQueue policies" << endl;
+
+        Recorder recorder;
+        DispatchQueue queue(recorder.sink(), 4);
+        vector<string> gaps;
+        queue.set_gap_handler([&](const string &channel)
+                              {
+            lock_guard<mutex> lock(recorder.mtx);
+            gaps.push_back(channel); });
+        queue.set_policy("ticker.", DispatchQueue::Policy::ConflateLatest);
+        queue.set_policy("ticker.BTC-PERPETUAL.raw", DispatchQueue::Policy::DeliverAll);
+
+        log_test_result("dispatch_queue - longest prefix wins",
+                        queue.policy_for("ticker.ETH-PERPETUAL.100ms") == DispatchQueue::Policy::ConflateLatest &&
+                            queue.policy_for("ticker.BTC-PERPETUAL.raw") == DispatchQueue::Policy::DeliverAll &&
+                            queue.policy_for("user.orders.any.any.raw") == DispatchQueue::Policy::DeliverAll);
+
+        // Hold the worker so everything queues up behind the first item
+        recorder.gate = false;
+        queue.start();
+        queue.push("user.orders.any.any.raw", 0);
+        while (queue.depth() != 0)
+        {
+            this_thread::yield();
+        }
+
+        for (int i = 1; i <= 100; ++i)
+        {
+            queue.push("ticker.ETH-PERPETUAL.100ms", i);
+        }
+        queue.push("user.orders.any.any.raw", 1);
+        queue.push("user.orders.any.any.raw", 2);
+        queue.push("user.orders.any.any.raw", 3);
+        auto started = chrono::steady_clock::now();
+        bool accepted = queue.push("user.orders.any.any.raw", 4);
+        auto waited = chrono::steady_clock::now() - started;
+        queue.push("user.orders.any.any.raw", 5);
+        queue.push("ticker.ETH-PERPETUAL.100ms", 101);
+
+        auto stats = queue.stats();
+        log_test_result("dispatch_queue - full queue does not block the pusher",
+                        waited < chrono::milliseconds(10));
+        log_test_result("dispatch_queue - drops counted per channel",
+                        !accepted && stats["dropped"] == 2 && stats["droppedChannels"]["user.orders.any.any.raw"] == 2);
+        log_test_result("dispatch_queue - one gap marker queued", stats["depth"] == 5);
+        log_test_result("dispatch_queue - tickers conflated", stats["conflated"] == 100);
+
+        recorder.gate = true;
+        queue.stop();
+
+        vector<pair<string, int>> expected = {{"user.orders.any.any.raw", 0},
+                                              {"ticker.ETH-PERPETUAL.100ms", 101},
+                                              {"user.orders.any.any.raw", 1},
+                                              {"user.orders.any.any.raw", 2},
+                                              {"user.orders.any.any.raw", 3}};
+        log_test_result("dispatch_queue - latest ticker delivered in order", recorder.seen == expected);
+        log_test_result("dispatch_queue - gap reported after earlier messages",
+                        gaps == vector<string>{"user.orders.any.any.raw"});
+        log_test_result("dispatch_queue - delivered counter", queue.stats()["delivered"] == 5);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_throughput() {
+        cout << "Testing DispatchQueue delivery" << endl;
+
+        atomic<int> total{0};
+        DispatchQueue queue([&](const string &, const nlohmann::json &data)
+                            { total += data.get<int>(); },
+                            1024);
+        queue.start();
+
+        int pushed = 0;
+        for (int i = 0; i < 100000; ++i)
+        {
+            while (!queue.push("trades.BTC-PERPETUAL.100ms", 1))
+            {
+                this_thread::yield();
+            }
+            pushed++;
+        }
+        queue.stop();
+
+        log_test_result("dispatch_queue - deliver all", total == pushed, to_string(total.load()) + " of " + to_string(pushed));
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " DISPATCH QUEUE TEST" << endl;
+
+        test_policies();
+        test_throughput();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        DispatchQueueTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,195 @@
+#include "../src/include/fill_ledger.hpp"
+#include <json.hpp>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+class FillLedgerTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    static bool near(double a, double b, double tolerance = 1e-9) {
+        return abs(a - b) <= tolerance;
+    }
+
+    static nlohmann::json market(const string& id, bool linear) {
+        return {{"id", id}, {"symbol", id}, {"base", "BTC"}, {"quote", "USD"}, {"settle", linear ? "USDC" : "BTC"},
+                {"swap", true}, {"linear", linear}, {"inverse", !linear}};
+    }
+
+    static shared_ptr<const MarketRegistry> registry() {
+        return make_shared<const MarketRegistry>(nlohmann::json::array(
+            {market("ETH_USDC-PERPETUAL", true), market("BTC-PERPETUAL", false), market("ETH-PERPETUAL", false)}));
+    }
+
+    static nlohmann::json trade(const string& id, const string& instrument, const string& direction, double amount,
+                                double price, double fee = 0.0) {
+        return {{"trade_id", id},
+                {"instrument_name", instrument},
+                {"direction", direction},
+                {"amount", amount},
+                {"price", price},
+                {"fee", fee},
+                {"liquidity", "M"},
+                {"timestamp", 1700000000000}};
+    }
+
+public:
+    bool test_linear() {
+        cout << "Testing FillLedger linear PnL" << endl;
+
+        FillLedger ledger;
+        ledger.set_markets(registry());
+        ledger.on_trade(trade("1", "ETH_USDC-PERPETUAL", "buy", 2, 100, 0.1));
+        ledger.on_trade(trade("2", "ETH_USDC-PERPETUAL", "buy", 2, 110, 0.1));
+        auto p = *ledger.position("ETH_USDC-PERPETUAL");
+        log_test_result("fill_ledger - average entry", near(p.size, 4) && near(p.average_entry, 105));
+
+        ledger.on_trade(trade("3", "ETH_USDC-PERPETUAL", "sell", 3, 120, 0.1));
+        p = *ledger.position("ETH_USDC-PERPETUAL");
+        log_test_result("fill_ledger - realized on reduce", near(p.realized, 45) && near(p.size, 1) &&
+                                                                near(p.average_entry, 105),
+                        to_string(p.realized));
+
+        ledger.on_trade(trade("4", "ETH_USDC-PERPETUAL", "sell", 2, 100, 0.1));
+        p = *ledger.position("ETH_USDC-PERPETUAL");
+        log_test_result("fill_ledger - flip reopens at fill price", near(p.realized, 40) && near(p.size, -1) &&
+                                                                        near(p.average_entry, 100));
+
+        ledger.on_mark("ETH_USDC-PERPETUAL", 90);
+        p = *ledger.position("ETH_USDC-PERPETUAL");
+        log_test_result("fill_ledger - unrealized follows mark", near(p.unrealized, 10) && near(p.mark, 90));
+        log_test_result("fill_ledger - fees and volume", near(p.fees, 0.4) && near(p.volume, 9) && p.fills == 4);
+
+        log_test_result("fill_ledger - duplicate trade ignored",
+                        !ledger.on_trade(trade("4", "ETH_USDC-PERPETUAL", "sell", 2, 100)) && ledger.size() == 4);
+        log_test_result("fill_ledger - untraded mark ignored", !ledger.on_mark("BTC-PERPETUAL", 50000) &&
+                                                                   !ledger.position("BTC-PERPETUAL"));
+
+        ledger.on_trade(trade("5", "ETH_USDC-PERPETUAL", "buy", 1, 95));
+        p = *ledger.position("ETH_USDC-PERPETUAL");
+        log_test_result("fill_ledger - flat position resets", near(p.size, 0) && near(p.average_entry, 0) &&
+                                                                  near(p.unrealized, 0) && near(p.realized, 45));
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_inverse() {
+        cout << "Testing FillLedger inverse PnL" << endl;
+
+        FillLedger ledger;
+        ledger.set_markets(registry());
+        ledger.on_trade(trade("a", "BTC-PERPETUAL", "buy", 1000, 50000));
+        ledger.on_trade(trade("b", "BTC-PERPETUAL", "buy", 1000, 40000));
+        auto p = *ledger.position("BTC-PERPETUAL");
+        log_test_result("fill_ledger - harmonic average entry", near(p.average_entry, 2000.0 / 0.045, 1e-6),
+                        to_string(p.average_entry));
+
+        ledger.on_mark("BTC-PERPETUAL", 50000);
+        p = *ledger.position("BTC-PERPETUAL");
+        log_test_result("fill_ledger - inverse unrealized in coin", near(p.unrealized, 0.005), to_string(p.unrealized));
+
+        ledger.on_trade(trade("c", "BTC-PERPETUAL", "sell", 2000, 50000));
+        p = *ledger.position("BTC-PERPETUAL");
+        log_test_result("fill_ledger - inverse realized in coin", near(p.realized, 0.005) && near(p.size, 0),
+                        to_string(p.realized));
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_columns() {
+        cout << "Testing FillLedger columns" << endl;
+
+        FillLedger ledger;
+        ledger.set_markets(registry());
+        ledger.on_trade(trade("1", "BTC-PERPETUAL", "buy", 10, 50000));
+        ledger.on_trade(trade("2", "ETH-PERPETUAL", "sell", 5, 3000));
+        ledger.on_trade(trade("3", "BTC-PERPETUAL", "sell", 10, 51000));
+        log_test_result("fill_ledger - malformed trade rejected", !ledger.on_trade({{"trade_id", "4"}}) && ledger.size() == 3);
+
+        auto all = ledger.fills();
+        log_test_result("fill_ledger - rows", all.size() == 3 && all.amount[1] == -5 && all.maker[2] == 1 &&
+                                                  ledger.instrument(all.instrument[1]) == "ETH-PERPETUAL" &&
+                                                  all.instrument[0] == all.instrument[2]);
+        log_test_result("fill_ledger - realized per fill", all.realized[0] == 0 && all.realized[2] > 0);
+
+        auto tail = ledger.fills(2);
+        log_test_result("fill_ledger - incremental read", tail.size() == 1 && tail.price[0] == 51000 && ledger.fills(3).size() == 0);
+
+        auto summary = ledger.to_json();
+        log_test_result("fill_ledger - summary", summary["fills"] == 3 && summary["instruments"].size() == 2 &&
+                                                     near(summary["realizedPnl"].get<double>(), all.realized[2]));
+
+        auto markets = registry();
+        log_test_result("fill_ledger - rows keyed by market id",
+                        all.instrument[1] == markets->id("ETH-PERPETUAL") && !ledger.position("ETH_USDC-PERPETUAL"));
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_deferred() {
+        cout << "Testing FillLedger held-back trades" << endl;
+
+        FillLedger ledger;
+        log_test_result("fill_ledger - held back without markets",
+                        !ledger.on_trade(trade("1", "BTC-PERPETUAL", "buy", 1000, 50000)) && ledger.size() == 0 &&
+                            ledger.deferred() == 1);
+
+        ledger.set_markets(registry());
+        log_test_result("fill_ledger - recorded once markets load", ledger.size() == 1 && ledger.deferred() == 0 &&
+                                                                       ledger.position("BTC-PERPETUAL")->inverse &&
+                                                                       !ledger.on_trade(trade("1", "BTC-PERPETUAL", "buy", 1000, 50000)));
+
+        ledger.on_trade(trade("2", "SOL-PERPETUAL", "buy", 1, 100));
+        auto listed = nlohmann::json::array({market("SOL-PERPETUAL", false)});
+        ledger.set_markets(make_shared<const MarketRegistry>(listed, *registry()));
+        log_test_result("fill_ledger - new listing recorded after reload",
+                        ledger.size() == 2 && ledger.tracks("SOL-PERPETUAL") && ledger.position("BTC-PERPETUAL")->fills == 1);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " FILL LEDGER TEST" << endl;
+
+        test_linear();
+        test_inverse();
+        test_columns();
+        test_deferred();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        FillLedgerTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
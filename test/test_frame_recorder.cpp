@@ -0,0 +1,166 @@
+#include "../src/include/frame_recorder.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+class FrameRecorderTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+    string directory;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    vector<string> segment_files() const {
+        vector<string> files;
+        for (const auto &entry : filesystem::directory_iterator(directory))
+        {
+            files.push_back(entry.path().string());
+        }
+        sort(files.begin(), files.end());
+        return files;
+    }
+
+public:
+    FrameRecorderTester()
+        : directory((filesystem::temp_directory_path() / ("frame_recorder_test_" + to_string(getpid()))).string())
+    {
+        filesystem::remove_all(directory);
+    }
+
+    ~FrameRecorderTester()
+    {
+        filesystem::remove_all(directory);
+    }
+
+    bool test_round_trip() {
+        cout << "Testing FrameRecorder concurrent writes and rotation" << endl;
+
+        const int threads = 4;
+        const int per_thread = 5000;
+        FrameRecorder recorder(directory, "test", 64 * 1024);
+
+        vector<thread> writers;
+        for (int t = 0; t < threads; ++t)
+        {
+            writers.emplace_back([&, t]()
+                                 {
+                for (int i = 0; i < per_thread; ++i)
+                {
+                    string payload = to_string(t) + ":" + to_string(i) + string(i % 37, 'x');
+                    recorder.record(t % 2 ? FrameRecorder::Outbound : FrameRecorder::Inbound, t, payload, 1000 + i);
+                } });
+        }
+        for (auto &writer : writers)
+        {
+            writer.join();
+        }
+        bool oversized = !recorder.record(FrameRecorder::Inbound, 0, string(128 * 1024, 'y'));
+        recorder.record(FrameRecorder::Inbound, 9, "");
+        recorder.close();
+
+        log_test_result("frame_recorder - oversized frame rejected", oversized && recorder.dropped() == 1);
+        log_test_result("frame_recorder - rotated segments", recorder.segments() > 3 && segment_files().size() == recorder.segments(),
+                        to_string(segment_files().size()) + " files");
+
+        vector<int> next(threads, 0);
+        bool ordered = true, fields = true;
+        size_t total = 0, empty = 0;
+        uint64_t expected_index = 0;
+        bool indices = true;
+        for (const auto &path : segment_files())
+        {
+            FrameReader reader(path);
+            indices = indices && reader.header().index == expected_index++;
+            FrameRecord record;
+            while (reader.next(record))
+            {
+                total++;
+                if (record.payload.empty())
+                {
+                    empty += record.connection == 9;
+                    continue;
+                }
+                string payload(record.payload);
+                int t = stoi(payload.substr(0, payload.find(':')));
+                int i = stoi(payload.substr(payload.find(':') + 1));
+                ordered = ordered && i == next[t]++;
+                fields = fields && record.connection == t && record.timestamp_ns == 1000 + i &&
+                         record.direction == (t % 2 ? FrameRecorder::Outbound : FrameRecorder::Inbound) &&
+                         payload.size() == to_string(t).size() + 1 + to_string(i).size() + i % 37;
+            }
+        }
+
+        log_test_result("frame_recorder - every frame read back", total == threads * per_thread + 1,
+                        to_string(total) + " frames");
+        log_test_result("frame_recorder - per-writer order kept", ordered);
+        log_test_result("frame_recorder - record fields", fields && empty == 1);
+        log_test_result("frame_recorder - segment headers", indices);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_bad_file() {
+        cout << "Testing FrameReader validation" << endl;
+
+        string path = directory + "/not_a_segment";
+        FILE *file = fopen(path.c_str(), "w");
+        fputs(string(100, 'z').c_str(), file);
+        fclose(file);
+
+        bool threw = false;
+        try
+        {
+            FrameReader reader(path);
+        }
+        catch (const exception &)
+        {
+            threw = true;
+        }
+        log_test_result("frame_recorder - foreign file rejected", threw);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " FRAME RECORDER TEST" << endl;
+
+        test_round_trip();
+        test_bad_file();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        FrameRecorderTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
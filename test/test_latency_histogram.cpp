@@ -0,0 +1,158 @@
+#include "../src/include/latency_histogram.hpp"
+#include <json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class LatencyHistogramTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+public:
+    bool test_buckets() {
+        cout << "Testing LatencyHistogram buckets" << endl;
+
+        bool contiguous = true, bounded = true;
+        uint64_t previous_index = 0;
+        for (uint64_t v = 1; v < (uint64_t(1) << 20); v += 1 + v / 1000)
+        {
+            size_t index = LatencyHistogram::index_of(v);
+            contiguous = contiguous && index >= previous_index && index - previous_index <= 1;
+            bounded = bounded && LatencyHistogram::upper_bound(index) >= v &&
+                      LatencyHistogram::upper_bound(index) - v <= v / LatencyHistogram::sub_count;
+            previous_index = index;
+        }
+        log_test_result("latency_histogram - buckets contiguous", contiguous);
+        log_test_result("latency_histogram - bucket error bounded", bounded);
+        log_test_result("latency_histogram - huge values clamp",
+                        LatencyHistogram::index_of(UINT64_MAX) == LatencyHistogram::bucket_count - 1 &&
+                            LatencyHistogram::index_of(uint64_t(1) << 40) < LatencyHistogram::bucket_count);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_percentiles() {
+        cout << "Testing LatencyHistogram percentiles" << endl;
+
+        LatencyHistogram histogram;
+        mt19937_64 rng(7);
+        lognormal_distribution<double> latency(12.0, 1.0); // ~160us median
+        vector<uint64_t> values;
+        for (int i = 0; i < 100000; ++i)
+        {
+            values.push_back(static_cast<uint64_t>(latency(rng)));
+            histogram.record(values.back());
+        }
+        sort(values.begin(), values.end());
+
+        auto snap = histogram.snapshot();
+        double worst = 0.0;
+        for (double q : {0.5, 0.9, 0.99, 0.999})
+        {
+            uint64_t exact = values[static_cast<size_t>(ceil(q * values.size())) - 1];
+            worst = max(worst, abs(double(snap.percentile(q)) - exact) / exact);
+        }
+        log_test_result("latency_histogram - percentiles within 1.6%", worst < 0.016, to_string(worst));
+        log_test_result("latency_histogram - min/max/count",
+                        snap.count == values.size() && snap.min == values.front() && snap.max == values.back());
+
+        histogram.reset();
+        auto cleared = histogram.snapshot();
+        log_test_result("latency_histogram - reset", cleared.count == 0 && cleared.min == 0 && cleared.percentile(0.5) == 0);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_rpc_metrics() {
+        cout << "Testing RpcMetrics" << endl;
+
+        RpcMetrics metrics;
+        vector<thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&metrics, t]()
+                                 {
+                auto &buy = metrics.method("private/buy");
+                auto &ticker = metrics.method("public/ticker");
+                for (int i = 0; i < 10000; ++i)
+                {
+                    metrics.start(buy);
+                    metrics.finish(buy, 1000 + i, i % 100 == 0 ? RpcMetrics::Outcome::Error : RpcMetrics::Outcome::Ok);
+                    metrics.start(ticker);
+                    metrics.finish(ticker, 500, i % 1000 == 0 ? RpcMetrics::Outcome::Timeout : RpcMetrics::Outcome::Ok);
+                } });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        auto &held = metrics.method("private/cancel");
+        metrics.start(held);
+        metrics.sent(held, 2000);
+
+        auto stats = metrics.snapshot();
+        auto buy = stats["methods"]["private/buy"];
+        auto ticker = stats["methods"]["public/ticker"];
+        log_test_result("rpc_metrics - counters",
+                        buy["requests"] == 40000 && buy["errors"] == 400 && ticker["timeouts"] == 40);
+        log_test_result("rpc_metrics - timeouts excluded from latency", ticker["latency"]["count"] == 39960);
+        log_test_result("rpc_metrics - in flight", stats["inFlight"] == 1 && stats["maxInFlight"] >= 1);
+        auto cancel = stats["methods"]["private/cancel"];
+        log_test_result("rpc_metrics - queueing recorded apart from latency",
+                        cancel["queueing"]["count"] == 1 && cancel["latency"]["count"] == 0 && buy["queueing"]["count"] == 0);
+
+        metrics.reset();
+        stats = metrics.snapshot();
+        log_test_result("rpc_metrics - reset keeps in flight",
+                        stats["methods"]["private/buy"]["requests"] == 0 && stats["inFlight"] == 1);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " LATENCY HISTOGRAM TEST" << endl;
+
+        test_buckets();
+        test_percentiles();
+        test_rpc_metrics();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        LatencyHistogramTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,260 @@
+#include "../src/include/deribit.hpp"
+#include "../src/include/market_registry.hpp"
+#include "../src/include/options_chain.hpp"
+#include <json.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+class MarketRegistryTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    // Markets shaped like Deribit::fetch_markets() output, including "info"
+    static nlohmann::json option_market(const string& base, int64_t expiry, int strike, bool call) {
+        string id = base + "-" + to_string(expiry) + "-" + to_string(strike) + (call ? "-C" : "-P");
+        string symbol = base + "/USD:" + base + "-" + to_string(expiry) + "-" + to_string(strike) + (call ? "-C" : "-P");
+        return {
+            {"id", id}, {"symbol", symbol}, {"base", base}, {"quote", "USD"}, {"settle", base},
+            {"baseId", base}, {"quoteId", "USD"}, {"settleId", base},
+            {"type", "option"}, {"spot", false}, {"margin", false}, {"swap", false}, {"future", false},
+            {"option", true}, {"active", true}, {"contract", true}, {"linear", false}, {"inverse", true},
+            {"taker", 0.0003}, {"maker", 0.0003}, {"contractSize", 1.0}, {"expiry", expiry},
+            {"expiryDatetime", to_string(expiry)}, {"strike", double(strike)}, {"optionType", call ? "call" : "put"},
+            {"precision", {{"amount", 0.1}, {"price", 0.0001}}},
+            {"limits", {{"leverage", {{"min", nullptr}, {"max", nullptr}}}, {"amount", {{"min", 0.1}, {"max", nullptr}}},
+                        {"price", {{"min", 0.0001}, {"max", nullptr}}}, {"cost", {{"min", nullptr}, {"max", nullptr}}}}},
+            {"created", 1700000000000LL},
+            {"info", {{"instrument_name", id}, {"kind", "option"}, {"tick_size", 0.0001}, {"min_trade_amount", 0.1},
+                      {"strike", double(strike)}, {"option_type", call ? "call" : "put"}, {"expiration_timestamp", expiry}}}};
+    }
+
+    static nlohmann::json universe() {
+        nlohmann::json markets = nlohmann::json::array();
+        for (const string base : {"BTC", "ETH"}) {
+            for (int e = 0; e < 40; ++e) {
+                int64_t expiry = 1700000000000LL + e * 86400000LL;
+                for (int k = 0; k < 150; ++k) {
+                    markets.push_back(option_market(base, expiry, 10000 + k * 500, true));
+                    markets.push_back(option_market(base, expiry, 10000 + k * 500, false));
+                }
+            }
+        }
+        markets.push_back({{"id", "BTC-PERPETUAL"}, {"symbol", "BTC/USD:BTC"}, {"base", "BTC"}, {"quote", "USD"},
+                           {"settle", "BTC"}, {"swap", true}, {"inverse", true}, {"contractSize", 10.0},
+                           {"precision", {{"amount", 10.0}, {"price", 0.5}}}});
+        return markets;
+    }
+
+public:
+    bool test_lookup() {
+        cout << "Testing MarketRegistry lookup" << endl;
+
+        nlohmann::json markets = universe();
+        auto started = chrono::steady_clock::now();
+        MarketRegistry registry(markets);
+        double build_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        cout << "Built " << registry.size() << " markets in " << build_ms << " ms, "
+             << registry.memory_bytes() / 1024 << " KiB" << endl;
+
+        log_test_result("market_registry - size", registry.size() == markets.size());
+
+        bool by_name = true, by_symbol = true;
+        for (size_t i = 0; i < markets.size(); ++i) {
+            MarketRegistry::MarketId id = registry.id(markets[i]["id"].get<string>());
+            by_name = by_name && id == i && registry.name(id) == markets[i]["id"].get<string>();
+            by_symbol = by_symbol && registry.id_by_symbol(markets[i]["symbol"].get<string>()) == i;
+        }
+        log_test_result("market_registry - every name resolves", by_name);
+        log_test_result("market_registry - every symbol resolves", by_symbol);
+
+        bool misses = registry.id("BTC-1-1-C") == MarketRegistry::npos &&
+                      registry.id("") == MarketRegistry::npos &&
+                      registry.id_by_symbol("BTC-PERPETUAL") == MarketRegistry::npos;
+        for (int i = 0; i < 10000 && misses; ++i) {
+            misses = registry.id("XRP-" + to_string(i)) == MarketRegistry::npos;
+        }
+        log_test_result("market_registry - unknown names miss", misses);
+
+        MarketRegistry empty(nlohmann::json::array());
+        log_test_result("market_registry - empty", empty.empty() && empty.id("BTC-PERPETUAL") == MarketRegistry::npos);
+
+        nlohmann::json duplicated = nlohmann::json::array({markets[0], markets[1], markets[0]});
+        MarketRegistry deduplicated(duplicated);
+        log_test_result("market_registry - duplicates dropped",
+                        deduplicated.size() == 2 && deduplicated.id(markets[1]["id"].get<string>()) == 1);
+
+        log_test_result("market_registry - smaller than json",
+                        registry.memory_bytes() * 4 < markets.dump().size(),
+                        to_string(registry.memory_bytes()) + " vs " + to_string(markets.dump().size()) + " serialized");
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_records() {
+        cout << "Testing MarketRegistry records" << endl;
+
+        nlohmann::json markets = universe();
+        MarketRegistry registry(markets);
+
+        const nlohmann::json &put = markets[1];
+        MarketRegistry::MarketId id = registry.id(put["id"].get<string>());
+        const MarketRecord &record = registry[id];
+        log_test_result("market_registry - record fields",
+                        record.is(MarketRecord::Option) && record.is(MarketRecord::Put) && !record.is(MarketRecord::Call) &&
+                            !record.is(MarketRecord::Linear) && record.strike == put["strike"].get<double>() &&
+                            record.tick_size == 0.0001 && record.min_amount == 0.1 &&
+                            registry.currency(record.base) == "BTC" && record.expiry == put["expiry"].get<int64_t>());
+
+        nlohmann::json round_trip = registry.to_json(id);
+        nlohmann::json expected = put;
+        expected.erase("info");
+        log_test_result("market_registry - to_json matches market without info", round_trip == expected,
+                        round_trip.dump());
+
+        nlohmann::json perpetual = registry.to_json(registry.id("BTC-PERPETUAL"));
+        log_test_result("market_registry - perpetual", perpetual["type"] == "swap" && perpetual["strike"].is_null() &&
+                                                           perpetual["optionType"].is_null() && perpetual["inverse"] == true);
+
+        OptionsChain chain("ETH");
+        size_t loaded = chain.load_markets(registry);
+        bool ids = loaded == 40 * 300;
+        for (size_t row = 0; row < chain.size() && ids; ++row) {
+            ids = registry.name(chain.market_id(row)) == chain.instrument(row);
+        }
+        log_test_result("market_registry - options chain keyed by id", ids);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_reload() {
+        cout << "Testing MarketRegistry reload keeps ids" << endl;
+
+        nlohmann::json markets = universe();
+        MarketRegistry previous(markets);
+        MarketRegistry::MarketId perpetual = previous.id("BTC-PERPETUAL");
+        MarketRegistry::MarketId expired = previous.id(markets[0]["id"].get<string>());
+
+        // Next load: the first expiry is gone, a new strike is listed first
+        nlohmann::json fetched = nlohmann::json::array({option_market("BTC", 1800000000000LL, 99000, true)});
+        for (size_t i = 1; i < markets.size(); ++i) {
+            fetched.push_back(markets[i]);
+        }
+        MarketRegistry reloaded(fetched, previous);
+        log_test_result("market_registry - ids carry over", reloaded.id("BTC-PERPETUAL") == perpetual &&
+                                                             reloaded.size() == previous.size() + 1);
+        log_test_result("market_registry - missing market kept inactive",
+                        reloaded.id(markets[0]["id"].get<string>()) == expired &&
+                            !reloaded[expired].is(MarketRecord::Active) && reloaded[perpetual].is(MarketRecord::Active));
+        log_test_result("market_registry - new market appended",
+                        reloaded.id("BTC-1800000000000-99000-C") == previous.size());
+
+        MarketRegistry merged(fetched, previous, true);
+        log_test_result("market_registry - merge keeps missing market active", merged[expired].is(MarketRecord::Active));
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_cache() {
+        cout << "Testing MarketRegistry cache file" << endl;
+
+        string path = (filesystem::temp_directory_path() / ("markets_" + to_string(getpid()) + ".bin")).string();
+        nlohmann::json markets = universe();
+        MarketRegistry registry(markets);
+        registry.save(path, 1700000000000LL);
+
+        int64_t saved_at = 0;
+        auto started = chrono::steady_clock::now();
+        auto loaded = MarketRegistry::load(path, &saved_at);
+        double load_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        cout << "Loaded " << (loaded ? loaded->size() : 0) << " markets in " << load_ms << " ms" << endl;
+
+        bool same = loaded && loaded->size() == registry.size() && saved_at == 1700000000000LL &&
+                    loaded->content_hash() == registry.content_hash();
+        for (size_t i = 0; same && i < markets.size(); i += 97) {
+            same = loaded->id(markets[i]["id"].get<string>()) == i && loaded->to_json(i) == registry.to_json(i);
+        }
+        log_test_result("market_cache - round trip", same);
+
+        MarketRegistry changed(nlohmann::json::array({markets[0], markets[2]}));
+        log_test_result("market_cache - hash tracks content",
+                        changed.content_hash() != registry.content_hash() &&
+                            MarketRegistry(markets).content_hash() == registry.content_hash());
+
+        {
+            fstream file(path, ios::in | ios::out | ios::binary);
+            file.seekp(200);
+            file.put('\x7f');
+        }
+        log_test_result("market_cache - corrupt file rejected", MarketRegistry::load(path) == nullptr);
+        log_test_result("market_cache - missing file", MarketRegistry::load(path + ".missing") == nullptr);
+
+        // An offline client serves the cache whatever its age
+        registry.save(path, 1);
+        Deribit client({{"offline", true}, {"market_cache", {{"path", path}, {"ttl", 60}}}});
+        nlohmann::json served = client.load_markets();
+        auto published = client.market_registry();
+        log_test_result("market_cache - offline load_markets served from cache",
+                        served.size() == markets.size() && published && published->content_hash() == registry.content_hash());
+
+        Deribit uncached({{"offline", true}});
+        bool threw = false;
+        try {
+            uncached.load_markets();
+        } catch (const exception&) {
+            threw = true;
+        }
+        log_test_result("market_cache - no cache falls back to fetch", threw && !uncached.market_registry());
+
+        filesystem::remove(path);
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " MARKET REGISTRY TEST" << endl;
+
+        test_lookup();
+        test_records();
+        test_reload();
+        test_cache();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        MarketRegistryTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,124 @@
+#include "../src/include/deribit.hpp"
+#include "../src/include/metrics_server.hpp"
+#include <json.hpp>
+#include <boost/asio.hpp>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+class MetricsServerTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    static string http_get(uint16_t port, const string& path) {
+        boost::asio::io_context io;
+        boost::asio::ip::tcp::socket socket(io);
+        socket.connect({boost::asio::ip::make_address("127.0.0.1"), port});
+        string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+        boost::asio::write(socket, boost::asio::buffer(request));
+
+        string response;
+        boost::system::error_code ec;
+        char buffer[4096];
+        size_t n;
+        while ((n = socket.read_some(boost::asio::buffer(buffer), ec)) > 0)
+        {
+            response.append(buffer, n);
+        }
+        return response;
+    }
+
+    static string notification(const string& channel, const nlohmann::json& data) {
+        return nlohmann::json({{"jsonrpc", "2.0"}, {"method", "subscription"},
+                               {"params", {{"channel", channel}, {"data", data}}}}).dump();
+    }
+
+public:
+    bool test_format() {
+        cout << "Testing prometheus helpers" << endl;
+
+        string out;
+        prometheus::family(out, "x_total", "counter", "Things.");
+        prometheus::sample(out, "x_total", 3, prometheus::label("channel", "a\"b"));
+        prometheus::sample(out, "x_seconds", 0.25);
+        log_test_result("metrics - exposition format",
+                        out == "# HELP x_total Things.\n# TYPE x_total counter\nx_total{channel=\"a\\\"b\"} 3\nx_seconds 0.25\n", out);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_endpoint() {
+        cout << "Testing /metrics endpoint" << endl;
+
+        Deribit client({{"offline", true}, {"metrics", {{"port", 0}, {"address", "127.0.0.1"}}}});
+        client.watch_ticker([](const nlohmann::json &) {}, "BTC-PERPETUAL");
+        string frame = notification("ticker.BTC-PERPETUAL.100ms", {{"instrument_name", "BTC-PERPETUAL"}});
+        for (int i = 0; i < 3; ++i)
+        {
+            client.handle_message(frame);
+        }
+        client.handle_message(notification("ticker.ETH-PERPETUAL.100ms", {}));
+        client.handle_message("not json");
+
+        uint16_t port = client.metrics_port();
+        log_test_result("metrics - listening", port != 0);
+
+        string response = http_get(port, "/metrics");
+        auto has = [&response](const string &line)
+        { return response.find(line) != string::npos; };
+
+        log_test_result("metrics - http ok", has("HTTP/1.1 200") && has("text/plain; version=0.0.4"));
+        log_test_result("metrics - connection state", has("\nderibit_connected 0\n") && has("# TYPE deribit_connects_total counter"));
+        log_test_result("metrics - frames and bytes", has("deribit_frames_total{direction=\"in\"} 5\n"));
+        log_test_result("metrics - per channel",
+                        has("deribit_channel_messages_total{channel=\"ticker.BTC-PERPETUAL.100ms\"} 3\n") &&
+                            has("deribit_channel_bytes_total{channel=\"ticker.BTC-PERPETUAL.100ms\"} " + to_string(3 * frame.size()) + "\n"));
+        log_test_result("metrics - unrouted and errors",
+                        has("deribit_unrouted_messages_total 1\n") && has("deribit_message_errors_total 1\n"));
+
+        string missing = http_get(port, "/other");
+        log_test_result("metrics - unknown path", missing.find("HTTP/1.1 404") != string::npos);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " METRICS SERVER TEST" << endl;
+
+        test_format();
+        test_endpoint();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        MetricsServerTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,186 @@
+#include "../src/include/options_chain.hpp"
+#include <json.hpp>
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+class OptionsChainTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    static nlohmann::json option_market(const string& id, double strike, const string& type, int64_t expiry) {
+        return {
+            {"id", id}, {"symbol", id}, {"base", "BTC"}, {"quote", "USD"}, {"settle", "BTC"},
+            {"type", "option"}, {"option", true}, {"inverse", true},
+            {"strike", strike}, {"optionType", type}, {"expiry", expiry}, {"contractSize", 1.0}
+        };
+    }
+
+public:
+    bool test_kernels() {
+        cout << "Testing black76 kernels" << endl;
+
+        double max_cdf_error = 0.0;
+        for (double x = -10.0; x <= 10.0; x += 0.01) {
+            double exact = 0.5 * erfc(-x / sqrt(2.0));
+            max_cdf_error = max(max_cdf_error, abs(black76::norm_cdf(x) - exact));
+        }
+        log_test_result("black76 - norm_cdf accuracy", max_cdf_error < 1e-13,
+                        "max error " + to_string(max_cdf_error));
+
+        const size_t n = 64;
+        vector<double> forward(n, 60000.0), strike(n), lnfk(n), t(n), sqrt_t(n), sign(n), disc(n), sigma(n), premium(n), iv(n, NAN);
+        for (size_t i = 0; i < n; ++i) {
+            strike[i] = 30000.0 + i * 1000.0;
+            lnfk[i] = log(forward[i] / strike[i]);
+            t[i] = 0.01 + 0.02 * (i % 8);
+            sqrt_t[i] = sqrt(t[i]);
+            sign[i] = (i % 2 == 0) ? 1.0 : -1.0;
+            disc[i] = exp(-0.01 * t[i]);
+            sigma[i] = 0.3 + 0.01 * (i % 20);
+        }
+        black76::Inputs in;
+        in.count = n;
+        in.forward = forward.data();
+        in.strike = strike.data();
+        in.log_moneyness = lnfk.data();
+        in.time = t.data();
+        in.sqrt_time = sqrt_t.data();
+        in.sign = sign.data();
+        in.discount = disc.data();
+
+        black76::price(in, sigma.data(), premium.data());
+        black76::implied_vol(in, premium.data(), iv.data());
+
+        double max_iv_error = 0.0;
+        int solvable = 0;
+        for (size_t i = 0; i < n; ++i) {
+            // Deep in/out of the money options carry no time value to invert
+            double intrinsic = max(sign[i] * (forward[i] - strike[i]), 0.0) * disc[i];
+            if (premium[i] - intrinsic < 1e-6 * forward[i]) continue;
+            solvable++;
+            max_iv_error = max(max_iv_error, abs(iv[i] - sigma[i]));
+        }
+        log_test_result("black76 - implied vol round trip", solvable > 20 && max_iv_error < 1e-8,
+                        "max error " + to_string(max_iv_error) + " over " + to_string(solvable));
+
+        vector<double> delta(n), gamma(n), vega(n), theta(n), up(n), down(n);
+        black76::greeks(in, sigma.data(), 0.01, delta.data(), gamma.data(), vega.data(), theta.data());
+        vector<double> f_up(forward), f_down(forward), ln_up(n), ln_down(n);
+        const double h = 1.0;
+        for (size_t i = 0; i < n; ++i) {
+            f_up[i] += h;
+            f_down[i] -= h;
+            ln_up[i] = log(f_up[i] / strike[i]);
+            ln_down[i] = log(f_down[i] / strike[i]);
+        }
+        black76::Inputs in_up = in, in_down = in;
+        in_up.forward = f_up.data();
+        in_up.log_moneyness = ln_up.data();
+        in_down.forward = f_down.data();
+        in_down.log_moneyness = ln_down.data();
+        black76::price(in_up, sigma.data(), up.data());
+        black76::price(in_down, sigma.data(), down.data());
+
+        bool delta_ok = true;
+        for (size_t i = 0; i < n; ++i) {
+            double fd_delta = (up[i] - down[i]) / (2 * h);
+            double fd_gamma = (up[i] - 2 * premium[i] + down[i]) / (h * h);
+            if (abs(fd_delta - delta[i]) > 1e-5 || abs(fd_gamma - gamma[i]) > 1e-6) {
+                delta_ok = false;
+            }
+        }
+        log_test_result("black76 - delta/gamma match finite differences", delta_ok);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_chain() {
+        cout << "Testing OptionsChain" << endl;
+
+        const int64_t now = 1700000000000LL;
+        const int64_t expiry = now + 30LL * 24 * 3600 * 1000;
+        nlohmann::json markets = nlohmann::json::array();
+        markets.push_back(option_market("BTC-X-70000-C", 70000.0, "call", expiry));
+        markets.push_back(option_market("BTC-X-50000-P", 50000.0, "put", expiry));
+        markets.push_back(option_market("BTC-X-60000-C", 60000.0, "call", expiry));
+        markets.push_back({{"id", "BTC-PERPETUAL"}, {"base", "BTC"}, {"option", false}});
+        markets.push_back(option_market("ETH-X-3000-C", 3000.0, "call", expiry));
+        markets.back()["base"] = "ETH";
+
+        OptionsChain chain("BTC");
+        size_t loaded = chain.load_markets(markets);
+        log_test_result("options_chain - filters underlying and options", loaded == 3);
+        log_test_result("options_chain - sorted by strike", chain.instrument(0) == "BTC-X-50000-P" && chain.instrument(2) == "BTC-X-70000-C");
+
+        // Price the 60000 call at 55% vol and quote it in BTC like the exchange does
+        double t = (expiry - now) / (365.0 * 24 * 3600 * 1000);
+        double f = 60000.0, k = 60000.0, sigma = 0.55;
+        double d1 = (log(f / k) + 0.5 * sigma * sigma * t) / (sigma * sqrt(t));
+        double d2 = d1 - sigma * sqrt(t);
+        double usd = f * black76::norm_cdf(d1) - k * black76::norm_cdf(d2);
+
+        bool applied = chain.on_ticker({
+            {"instrument_name", "BTC-X-60000-C"}, {"underlying_price", f},
+            {"mark_price", usd / f}, {"best_bid_price", 0.9 * usd / f}, {"best_ask_price", 0}
+        });
+        log_test_result("options_chain - ticker applied", applied && !chain.on_ticker({{"instrument_name", "OTHER"}}));
+
+        chain.reprice(now);
+        size_t row = chain.index_of("BTC-X-60000-C");
+        const auto& cols = chain.columns();
+        log_test_result("options_chain - mark iv recovered", abs(cols.mark_iv[row] - sigma) < 1e-8,
+                        "iv " + to_string(cols.mark_iv[row]));
+        log_test_result("options_chain - bid iv below mark iv", cols.bid_iv[row] < cols.mark_iv[row]);
+        log_test_result("options_chain - empty ask gives no iv", isnan(cols.ask_iv[row]));
+        log_test_result("options_chain - atm delta", cols.delta[row] > 0.5 && cols.delta[row] < 0.6);
+        log_test_result("options_chain - unquoted rows stay empty", isnan(cols.mark_iv[chain.index_of("BTC-X-50000-P")]));
+
+        nlohmann::json json_row = chain.row(row);
+        log_test_result("options_chain - row json", json_row["optionType"] == "call" && json_row["askIv"].is_null());
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " OPTIONS CHAIN TEST" << endl;
+
+        test_kernels();
+        test_chain();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        OptionsChainTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,187 @@
+#include "../src/include/order_store.hpp"
+#include <json.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class OrderStoreTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    static nlohmann::json order(const string& id, const string& instrument, const string& state, int64_t updated,
+                                const string& label = "") {
+        return {{"order_id", id},
+                {"instrument_name", instrument},
+                {"order_state", state},
+                {"label", label},
+                {"creation_timestamp", 1000},
+                {"last_update_timestamp", updated},
+                {"amount", 10.0}};
+    }
+
+    static shared_ptr<const MarketRegistry> registry(const vector<string>& names) {
+        nlohmann::json markets = nlohmann::json::array();
+        for (const auto& name : names) {
+            markets.push_back({{"id", name}, {"symbol", name}, {"base", "BTC"}, {"quote", "USD"}, {"settle", "BTC"}, {"swap", true}});
+        }
+        return make_shared<const MarketRegistry>(markets);
+    }
+
+public:
+    bool test_indexes() {
+        cout << "Testing OrderStore indexes" << endl;
+
+        OrderStore store;
+        store.apply(order("1", "BTC-PERPETUAL", "open", 1, "quote"));
+        store.apply(order("2", "BTC-PERPETUAL", "untriggered", 1));
+        store.apply(order("3", "ETH-PERPETUAL", "open", 1, "quote"));
+        store.apply_all(nlohmann::json::array({order("4", "ETH-PERPETUAL", "filled", 1)}));
+
+        log_test_result("order_store - size", store.size() == 4 && store.open_count() == 3);
+        log_test_result("order_store - find", store.find("3").has_value() &&
+                                                  (*store.find("3"))["instrument_name"] == "ETH-PERPETUAL" &&
+                                                  !store.find("9").has_value());
+        log_test_result("order_store - open by instrument", store.open("BTC-PERPETUAL").size() == 2 &&
+                                                                store.open("ETH-PERPETUAL").size() == 1 &&
+                                                                store.open().size() == 3);
+        log_test_result("order_store - by label", store.by_label("quote").size() == 2);
+        log_test_result("order_store - by state", store.by_state("filled").size() == 1 &&
+                                                      store.by_state("open").size() == 2);
+
+        store.apply(order("1", "BTC-PERPETUAL", "cancelled", 2, "quote"));
+        log_test_result("order_store - state change reindexes", store.open("BTC-PERPETUAL").size() == 1 &&
+                                                                    store.by_state("cancelled").size() == 1 &&
+                                                                    store.by_label("quote").size() == 2);
+
+        log_test_result("order_store - missing id rejected", !store.apply({{"order_state", "open"}}) && store.size() == 4);
+
+        store.clear();
+        log_test_result("order_store - clear", store.size() == 0 && store.open().empty() && store.by_label("quote").empty());
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_ordering() {
+        cout << "Testing OrderStore update ordering" << endl;
+
+        OrderStore store;
+        store.apply(order("1", "BTC-PERPETUAL", "open", 100));
+        store.apply(order("1", "BTC-PERPETUAL", "filled", 200));
+        // The RPC ack of the original placement arrives after the fill
+        bool stale = !store.apply(order("1", "BTC-PERPETUAL", "open", 100));
+        log_test_result("order_store - stale update ignored", stale && (*store.find("1"))["order_state"] == "filled" &&
+                                                                  store.open_count() == 0);
+
+        auto amended = order("1", "BTC-PERPETUAL", "filled", 200);
+        amended["amount"] = 20.0;
+        log_test_result("order_store - same timestamp applies", store.apply(amended) &&
+                                                                    (*store.find("1"))["amount"] == 20.0);
+
+        OrderStore bounded(2);
+        bounded.apply(order("open", "BTC-PERPETUAL", "open", 1));
+        for (int i = 0; i < 5; ++i) {
+            bounded.apply(order("closed" + to_string(i), "BTC-PERPETUAL", "cancelled", 1));
+        }
+        log_test_result("order_store - closed orders bounded", bounded.size() == 3 && bounded.find("open") &&
+                                                                   !bounded.find("closed2") && bounded.find("closed4") &&
+                                                                   bounded.by_instrument("BTC-PERPETUAL").size() == 3);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_reconcile() {
+        cout << "Testing OrderStore snapshot reconcile" << endl;
+
+        OrderStore store;
+        // Known from acks before the stream went live; "2" filled unseen
+        store.apply(order("1", "BTC-PERPETUAL", "open", 100));
+        store.apply(order("2", "BTC-PERPETUAL", "open", 100));
+        store.apply(order("3", "BTC-PERPETUAL", "filled", 100));
+        uint64_t since = store.version();
+        // Placed while the snapshot was in flight, so not in it
+        store.apply(order("4", "ETH-PERPETUAL", "open", 300));
+
+        auto snapshot = nlohmann::json::array({order("1", "BTC-PERPETUAL", "open", 200),
+                                               order("5", "ETH-PERPETUAL", "untriggered", 200)});
+        size_t evicted = store.reconcile(snapshot, since);
+        log_test_result("order_store - ghost open order evicted", evicted == 1 && !store.find("2") &&
+                                                                      store.open("BTC-PERPETUAL").size() == 1,
+                        to_string(evicted));
+        log_test_result("order_store - newer than snapshot kept", store.find("4").has_value() && store.find("5").has_value() &&
+                                                                      store.open_count() == 3);
+        log_test_result("order_store - closed orders untouched", store.find("3").has_value());
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_markets() {
+        cout << "Testing OrderStore market keys" << endl;
+
+        auto markets = registry({"BTC-PERPETUAL", "ETH-PERPETUAL"});
+        OrderStore store;
+        store.apply(order("1", "SOL-PERPETUAL", "open", 1));
+        store.set_markets(markets);
+        store.apply(order("2", "BTC-PERPETUAL", "open", 1));
+        store.apply(order("3", "BTC-PERPETUAL", "filled", 1));
+        store.apply(order("4", "NEW-PERPETUAL", "open", 1));
+        log_test_result("order_store - by market id", store.by_market(markets->id("BTC-PERPETUAL")).size() == 2 &&
+                                                          store.by_instrument("BTC-PERPETUAL").size() == 2 &&
+                                                          store.by_market(MarketRegistry::npos).empty());
+        log_test_result("order_store - unknown instruments kept apart", store.open("SOL-PERPETUAL").size() == 1 &&
+                                                                           store.by_instrument("NEW-PERPETUAL").size() == 1 &&
+                                                                           store.by_instrument("ETH-PERPETUAL").empty());
+
+        auto listed = make_shared<const MarketRegistry>(
+            nlohmann::json::array({{{"id", "NEW-PERPETUAL"}, {"symbol", "NEW-PERPETUAL"}, {"swap", true}}}), *markets);
+        store.set_markets(listed);
+        log_test_result("order_store - reindexed once listed", store.by_market(listed->id("NEW-PERPETUAL")).size() == 1 &&
+                                                                   store.open("NEW-PERPETUAL").size() == 1 &&
+                                                                   store.open("SOL-PERPETUAL").size() == 1);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " ORDER STORE TEST" << endl;
+
+        test_indexes();
+        test_ordering();
+        test_reconcile();
+        test_markets();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        OrderStoreTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,162 @@
+#include "../src/include/outbound_scheduler.hpp"
+#include <json.hpp>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class OutboundSchedulerTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    // Stand-in for the io thread and the transport's write buffer
+    struct Harness {
+        deque<function<void()>> io;
+        vector<string> wire;
+        size_t buffered = 0;
+        chrono::microseconds last_delay{0};
+        shared_ptr<OutboundScheduler> scheduler;
+
+        explicit Harness(size_t max_backlog) {
+            scheduler = make_shared<OutboundScheduler>(
+                [this](const string& frame) {
+                    wire.push_back(frame);
+                    buffered += frame.size();
+                    return frame != "fail";
+                },
+                [this]() { return buffered; },
+                [this](function<void()> task, chrono::microseconds delay) {
+                    last_delay = delay;
+                    io.push_back(std::move(task));
+                },
+                max_backlog, chrono::microseconds(100));
+        }
+
+        // Runs at most `steps` posted tasks
+        void run(size_t steps = 1000) {
+            while (!io.empty() && steps-- > 0) {
+                auto task = std::move(io.front());
+                io.pop_front();
+                task();
+            }
+        }
+    };
+
+public:
+    bool test_ordering() {
+        cout << "Testing OutboundScheduler ordering" << endl;
+
+        log_test_result("outbound - priorities",
+                        OutboundScheduler::priority("private/cancel_all") == OutboundScheduler::Priority::Urgent &&
+                            OutboundScheduler::priority("private/edit") == OutboundScheduler::Priority::Normal &&
+                            OutboundScheduler::priority("public/subscribe") == OutboundScheduler::Priority::Bulk);
+
+        Harness harness(100);
+        for (int i = 0; i < 5; ++i) {
+            harness.scheduler->enqueue(OutboundScheduler::Priority::Bulk, "query-" + to_string(i));
+        }
+        log_test_result("outbound - one drain posted", harness.io.size() == 1 && harness.last_delay.count() == 0);
+        harness.run();
+        log_test_result("outbound - drains in order", harness.wire.size() == 5 && harness.wire[0] == "query-0" &&
+                                                          harness.wire[4] == "query-4");
+
+        // Saturate the transport, queue bulk work, then an order and a cancel
+        harness.wire.clear();
+        harness.buffered = 100;
+        for (int i = 0; i < 3; ++i) {
+            harness.scheduler->enqueue(OutboundScheduler::Priority::Bulk, "query-" + to_string(i));
+        }
+        harness.run(5);
+        log_test_result("outbound - holds frames while saturated",
+                        harness.wire.empty() && harness.scheduler->depth() == 3 && harness.io.size() == 1);
+        log_test_result("outbound - saturated drain re-arms after a delay", harness.last_delay.count() == 100);
+
+        harness.scheduler->enqueue(OutboundScheduler::Priority::Normal, "order");
+        harness.scheduler->enqueue(OutboundScheduler::Priority::Urgent, "cancel");
+        harness.buffered = 0;
+        harness.run();
+        log_test_result("outbound - urgent overtakes queued frames",
+                        harness.wire.size() == 5 && harness.wire[0] == "cancel" && harness.wire[1] == "order" &&
+                            harness.wire[2] == "query-0");
+
+        auto stats = harness.scheduler->stats();
+        log_test_result("outbound - stats", stats["priorities"]["bulk"]["written"] == 8 &&
+                                                stats["priorities"]["urgent"]["written"] == 1 &&
+                                                stats["yields"].get<uint64_t>() >= 5 && stats["depth"] == 0);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_lifecycle() {
+        cout << "Testing OutboundScheduler lifecycle" << endl;
+
+        Harness harness(100);
+        harness.buffered = 100;
+        harness.scheduler->enqueue(OutboundScheduler::Priority::Bulk, "a");
+        harness.scheduler->enqueue(OutboundScheduler::Priority::Urgent, "b");
+        harness.run(3);
+        log_test_result("outbound - clear drops queued frames", harness.scheduler->clear() == 2 &&
+                                                                    harness.scheduler->depth() == 0);
+        harness.buffered = 0;
+        harness.run();
+        log_test_result("outbound - idle after clear", harness.io.empty() && harness.wire.empty());
+
+        bool written = false, failed = false;
+        harness.scheduler->enqueue(
+            OutboundScheduler::Priority::Bulk, "fail", [&]() { written = true; }, [&]() { failed = true; });
+        harness.run();
+        log_test_result("outbound - failed writes counted and reported",
+                        harness.scheduler->stats()["failed"] == 1 && failed && !written);
+
+        harness.scheduler->enqueue(OutboundScheduler::Priority::Bulk, "late");
+        harness.scheduler.reset();
+        harness.run();
+        log_test_result("outbound - posted drain outlives scheduler", harness.wire.size() == 1 && harness.wire[0] == "fail");
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " OUTBOUND SCHEDULER TEST" << endl;
+
+        test_ordering();
+        test_lifecycle();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        OutboundSchedulerTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
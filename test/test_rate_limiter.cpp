@@ -0,0 +1,143 @@
+#include "../src/include/rate_limiter.hpp"
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class RateLimiterTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+public:
+    bool test_credits() {
+        cout << "Testing RateLimiter credits" << endl;
+
+        log_test_result("rate_limiter - lanes",
+                        RateLimiter::lane("private/cancel") == RateLimiter::Lane::Cancel &&
+                            RateLimiter::lane("private/cancel_all_by_instrument") == RateLimiter::Lane::Cancel &&
+                            RateLimiter::lane("private/buy") == RateLimiter::Lane::Order &&
+                            RateLimiter::lane("private/edit") == RateLimiter::Lane::Order &&
+                            RateLimiter::lane("public/subscribe") == RateLimiter::Lane::Query &&
+                            RateLimiter::lane("private/get_open_orders_by_currency") == RateLimiter::Lane::Query);
+
+        RateLimiter limiter(nlohmann::json{{"non_matching", {{"capacity", 5000}, {"refill", 1}}},
+                             {"costs", {{"private/get_transaction_log", 2000}}}});
+        int granted = 0;
+        while (limiter.try_acquire("public/ticker")) {
+            granted++;
+        }
+        log_test_result("rate_limiter - burst capacity", granted == 10, to_string(granted));
+        log_test_result("rate_limiter - empty pool rejects", limiter.credits(RateLimiter::Pool::NonMatching) < 500.0 &&
+                                                                 limiter.stats()["lanes"]["query"]["rejected"] == 1);
+        log_test_result("rate_limiter - pools independent", limiter.credits(RateLimiter::Pool::Matching) == 10000.0);
+        log_test_result("rate_limiter - method cost", limiter.cost("private/get_transaction_log") == 2000.0 &&
+                                                          limiter.cost("public/ticker") == 500.0);
+
+        RateLimiter refilling(nlohmann::json{{"non_matching", {{"capacity", 1000}, {"refill", 200000}}}});
+        refilling.try_acquire("public/ticker");
+        refilling.try_acquire("public/ticker");
+        this_thread::sleep_for(chrono::milliseconds(30));
+        log_test_result("rate_limiter - refill", refilling.credits(RateLimiter::Pool::NonMatching) == 1000.0);
+
+        RateLimiter reserved(nlohmann::json{{"matching", {{"capacity", 2000}, {"refill", 1}}}, {"cancel_reserve", 1000}});
+        bool orders = reserved.try_acquire("private/buy") && reserved.try_acquire("private/sell") &&
+                      !reserved.try_acquire("private/buy");
+        bool cancels = reserved.try_acquire("private/cancel") && reserved.try_acquire("private/cancel");
+        log_test_result("rate_limiter - orders leave cancel reserve", orders && cancels);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_waiting() {
+        cout << "Testing RateLimiter waiting" << endl;
+
+        // Empty matching pool refilling one request every 20ms
+        RateLimiter limiter(nlohmann::json{{"matching", {{"capacity", 500}, {"refill", 25000}}}, {"cancel_reserve", 0},
+                             {"max_wait_ms", {{"cancel", 2000}, {"order", 2000}}}});
+        limiter.try_acquire("private/buy");
+
+        mutex order_mtx;
+        vector<string> served;
+        vector<thread> threads;
+        for (int i = 0; i < 3; ++i) {
+            threads.emplace_back([&]() {
+                if (limiter.acquire("private/buy")) {
+                    lock_guard<mutex> lock(order_mtx);
+                    served.push_back("order");
+                } });
+        }
+        this_thread::sleep_for(chrono::milliseconds(5));
+        threads.emplace_back([&]() {
+            if (limiter.acquire("private/cancel")) {
+                lock_guard<mutex> lock(order_mtx);
+                served.push_back("cancel");
+            } });
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        log_test_result("rate_limiter - queued requests granted", served.size() == 4);
+        log_test_result("rate_limiter - cancel served before waiting orders",
+                        served.size() == 4 && (served[0] == "cancel" || served[1] == "cancel"),
+                        served.empty() ? "" : served[0] + "," + served[1]);
+
+        RateLimiter starved(nlohmann::json{{"non_matching", {{"capacity", 500}, {"refill", 1}}}, {"max_wait_ms", {{"query", 50}}}});
+        starved.try_acquire("public/ticker");
+        auto started = chrono::steady_clock::now();
+        bool rejected = !starved.acquire("public/ticker");
+        auto waited = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started).count();
+        log_test_result("rate_limiter - rejects after max wait", rejected && waited >= 45 && waited < 500,
+                        to_string(waited) + " ms");
+
+        auto stats = starved.stats();
+        log_test_result("rate_limiter - stats", stats["lanes"]["query"]["delayed"] == 1 &&
+                                                    stats["lanes"]["query"]["rejected"] == 1 &&
+                                                    stats["lanes"]["query"]["waiting"] == 0);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " RATE LIMITER TEST" << endl;
+
+        test_credits();
+        test_waiting();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        RateLimiterTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,156 @@
+#include "../src/include/deribit.hpp"
+#include "../src/include/frame_recorder.hpp"
+#include "../src/include/order_book.hpp"
+#include "../src/include/replay.hpp"
+#include <json.hpp>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+class ReplayTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+    string directory;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    static string notification(const string& channel, const nlohmann::json& data) {
+        return nlohmann::json({{"jsonrpc", "2.0"}, {"method", "subscription"},
+                               {"params", {{"channel", channel}, {"data", data}}}}).dump();
+    }
+
+    // 100 frames, one per recorded millisecond
+    void record_session() {
+        FrameRecorder recorder(directory, "deribit", 16 * 1024);
+        int64_t t0 = 1700000000000000000LL;
+
+        recorder.record(FrameRecorder::Outbound, 1, R"({"jsonrpc":"2.0","id":1,"method":"public/subscribe"})", t0);
+        recorder.record(FrameRecorder::Inbound, 1, R"({"jsonrpc":"2.0","id":1,"result":["book.BTC-PERPETUAL.100ms"]})", t0);
+        recorder.record(FrameRecorder::Inbound, 1, notification("book.BTC-PERPETUAL.100ms", {
+            {"type", "snapshot"}, {"instrument_name", "BTC-PERPETUAL"}, {"timestamp", 1000}, {"change_id", 1},
+            {"bids", {{"new", 100.0, 1.0}}}, {"asks", {{"new", 101.0, 1.0}}}}), t0 + 1000000);
+
+        for (int i = 2; i < 100; ++i)
+        {
+            int64_t ts = t0 + i * 1000000LL;
+            if (i % 2 == 0)
+            {
+                recorder.record(FrameRecorder::Inbound, 1, notification("book.BTC-PERPETUAL.100ms", {
+                    {"type", "change"}, {"instrument_name", "BTC-PERPETUAL"}, {"timestamp", 1000 + i},
+                    {"prev_change_id", i - 2 == 0 ? 1 : i - 2}, {"change_id", i},
+                    {"bids", {{"change", 100.0, double(i)}}}, {"asks", nlohmann::json::array()}}), ts);
+            }
+            else
+            {
+                recorder.record(FrameRecorder::Inbound, 1, notification("ticker.BTC-PERPETUAL.100ms", {
+                    {"instrument_name", "BTC-PERPETUAL"}, {"mark_price", 100.0 + i}}), ts);
+            }
+        }
+        // A second connection that should be filtered out
+        recorder.record(FrameRecorder::Inbound, 2, notification("ticker.BTC-PERPETUAL.100ms", {
+            {"instrument_name", "BTC-PERPETUAL"}, {"mark_price", 1.0}}), t0 + 99000000LL);
+    }
+
+public:
+    ReplayTester()
+        : directory((filesystem::temp_directory_path() / ("replay_test_" + to_string(getpid()))).string())
+    {
+        filesystem::remove_all(directory);
+    }
+
+    ~ReplayTester()
+    {
+        filesystem::remove_all(directory);
+    }
+
+    bool test_replay() {
+        cout << "Testing ReplayDriver::run()" << endl;
+
+        record_session();
+        auto segments = ReplayDriver::segments(directory);
+
+        Deribit client({{"offline", true}});
+        OrderBook book("BTC-PERPETUAL");
+        int tickers = 0;
+        double last_mark = 0.0;
+        client.watch_order_book([&](const nlohmann::json &data)
+                                { book.apply(data); },
+                                "BTC-PERPETUAL");
+        client.watch_ticker([&](const nlohmann::json &ticker)
+                            {
+                                tickers++;
+                                last_mark = ticker["mark_price"];
+                            },
+                            "BTC-PERPETUAL");
+
+        ReplayOptions options;
+        options.connection = 1;
+        ReplayStats stats = ReplayDriver(client).run(segments, options);
+
+        log_test_result("replay - inbound frames of one connection", stats.frames == 100,
+                        to_string(stats.frames) + " frames");
+        log_test_result("replay - ticker handlers ran", tickers == 49 && last_mark == 199.0);
+        log_test_result("replay - book rebuilt", book.in_sync() && book.change_id() == 98 &&
+                                                     !book.bids(1).empty() && book.bids(1)[0].amount == 98.0);
+        log_test_result("replay - throughput reported", stats.frames_per_second() > 0.0 &&
+                                                            abs(stats.recorded_seconds - 0.099) < 1e-9);
+
+        ReplayOptions paced;
+        paced.speed = 4.0;
+        ReplayStats timed = ReplayDriver([](string_view) {}).run(segments, paced);
+        log_test_result("replay - paced replay", timed.frames == 101 && timed.wall_seconds >= 0.099 / 4.0,
+                        to_string(timed.wall_seconds) + " s");
+
+        bool threw = false;
+        try
+        {
+            client.fetch_ticker("BTC-PERPETUAL");
+        }
+        catch (const exception &)
+        {
+            threw = true;
+        }
+        log_test_result("replay - offline client rejects requests", threw);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " REPLAY TEST" << endl;
+
+        test_replay();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        ReplayTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
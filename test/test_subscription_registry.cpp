@@ -0,0 +1,144 @@
+#include "../src/include/subscription_registry.hpp"
+#include <json.hpp>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class SubscriptionRegistryTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+public:
+    bool test_handlers() {
+        cout << "Testing SubscriptionRegistry handlers" << endl;
+
+        SubscriptionRegistry registry;
+        int first = 0, second = 0;
+        vector<string> activated;
+
+        auto a = registry.add({"ticker.BTC-PERPETUAL.100ms", "ticker.ETH-PERPETUAL.100ms"},
+                              [&](const nlohmann::json &data)
+                              { first += data.get<int>(); },
+                              &activated);
+        log_test_result("subscription_registry - new channels activated", activated.size() == 2);
+
+        activated.clear();
+        auto b = registry.add({"ticker.BTC-PERPETUAL.100ms"}, [&](const nlohmann::json &data)
+                              { second += data.get<int>(); },
+                              &activated);
+        log_test_result("subscription_registry - existing channel not reactivated", activated.empty());
+
+        size_t ran = registry.dispatch("ticker.BTC-PERPETUAL.100ms", 5);
+        log_test_result("subscription_registry - all handlers invoked", ran == 2 && first == 5 && second == 5);
+        log_test_result("subscription_registry - unknown channel ignored", registry.dispatch("ticker.SOL.100ms", 1) == 0);
+
+        nlohmann::json routed = 7;
+        bool known = registry.route("ticker.BTC-PERPETUAL.100ms", 40, &routed) &&
+                     registry.route("ticker.BTC-PERPETUAL.100ms", 60);
+        auto *counters = registry.stats("ticker.BTC-PERPETUAL.100ms");
+        log_test_result("subscription_registry - route counts and dispatches",
+                        known && first == 12 && second == 12 && counters->messages == 2 && counters->bytes == 100);
+        log_test_result("subscription_registry - route reports unknown channel", !registry.route("ticker.SOL.100ms", 10));
+
+        int64_t id = registry.channel_id("ticker.ETH-PERPETUAL.100ms");
+        vector<string> deactivated;
+        registry.remove(a, &deactivated);
+        log_test_result("subscription_registry - remove one registration",
+                        deactivated == vector<string>{"ticker.ETH-PERPETUAL.100ms"} &&
+                            registry.handler_count("ticker.BTC-PERPETUAL.100ms") == 1);
+
+        registry.add({"ticker.ETH-PERPETUAL.100ms"}, [](const nlohmann::json &) {});
+        log_test_result("subscription_registry - interned id stable", registry.channel_id("ticker.ETH-PERPETUAL.100ms") == id && id >= 0);
+
+        deactivated.clear();
+        size_t removed = registry.remove_channels({"ticker.BTC-PERPETUAL.100ms", "ticker.SOL.100ms"}, &deactivated);
+        log_test_result("subscription_registry - remove channels",
+                        removed == 1 && deactivated.size() == 1 && !registry.remove(b) &&
+                            registry.active_channels() == vector<string>{"ticker.ETH-PERPETUAL.100ms"});
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_concurrent() {
+        cout << "Testing SubscriptionRegistry concurrent access" << endl;
+
+        SubscriptionRegistry registry;
+        atomic<uint64_t> calls{0};
+        registry.add({"book.BTC-PERPETUAL.100ms"}, [&](const nlohmann::json &)
+                     { calls++; });
+
+        atomic<bool> done{false};
+        uint64_t dispatched = 0;
+        thread io([&]()
+                  {
+            nlohmann::json data = 1;
+            while (!done.load())
+            {
+                dispatched += registry.dispatch("book.BTC-PERPETUAL.100ms", data) > 0;
+                registry.dispatch("trades.ETH-PERPETUAL.100ms", data);
+            } });
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            auto id = registry.add({"trades.ETH-PERPETUAL.100ms", "ticker.X-" + to_string(i) + ".100ms"},
+                                   [](const nlohmann::json &) {});
+            if (i % 2 == 0)
+            {
+                registry.remove(id);
+            }
+        }
+        done = true;
+        io.join();
+
+        log_test_result("subscription_registry - dispatch during registration",
+                        dispatched > 0 && calls.load() == dispatched);
+        log_test_result("subscription_registry - writes all applied",
+                        registry.handler_count("trades.ETH-PERPETUAL.100ms") == 1000 &&
+                            registry.active_channels().size() == 1002);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " SUBSCRIPTION REGISTRY TEST" << endl;
+
+        test_handlers();
+        test_concurrent();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        SubscriptionRegistryTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
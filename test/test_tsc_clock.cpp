@@ -0,0 +1,151 @@
+#include "../src/include/tsc_clock.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class TscClockTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    static int64_t system_ns() {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    bool test_epoch() {
+        cout << "Testing TscClock epoch conversion" << endl;
+
+        const TscClock &clock = TscClock::instance();
+        log_test_result("tsc_clock - rate positive", clock.ticks_per_ns() > 0.0);
+
+        int64_t before = system_ns();
+        int64_t stamp = clock.epoch_ns();
+        int64_t after = system_ns();
+        log_test_result("tsc_clock - agrees with system clock",
+                        stamp > before - 1000000 && stamp < after + 1000000,
+                        to_string(stamp - before) + " ns from system_clock");
+
+        bool monotonic = true;
+        int64_t previous = clock.epoch_ns();
+        for (int i = 0; i < 100000; ++i)
+        {
+            int64_t now = clock.epoch_ns();
+            monotonic = monotonic && now >= previous;
+            previous = now;
+        }
+        log_test_result("tsc_clock - monotonic", monotonic);
+
+        // A stamp taken before a recalibration still converts consistently
+        uint64_t ticks = TscClock::ticks();
+        int64_t early = clock.to_epoch_ns(ticks);
+        clock.calibrate();
+        int64_t late = clock.to_epoch_ns(ticks);
+        log_test_result("tsc_clock - stable across calibration", llabs(late - early) < 1000000,
+                        to_string(late - early) + " ns shift");
+
+        // The anchor is refreshed in the background, not by readers
+        uint64_t calibrations = clock.calibrations();
+        this_thread::sleep_for(TscClock::recalibrate_interval + chrono::milliseconds(200));
+        log_test_result("tsc_clock - background recalibration", clock.calibrations() > calibrations);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_durations() {
+        cout << "Testing TscClock durations" << endl;
+
+        const TscClock &clock = TscClock::instance();
+        auto started = chrono::steady_clock::now();
+        uint64_t start_ticks = TscClock::ticks();
+        this_thread::sleep_for(chrono::milliseconds(50));
+        uint64_t elapsed = clock.to_ns(TscClock::ticks() - start_ticks);
+        auto reference = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count();
+        log_test_result("tsc_clock - duration matches steady clock",
+                        llabs(static_cast<long long>(elapsed) - reference) < reference / 20,
+                        to_string(elapsed) + " vs " + to_string(reference));
+
+        // Concurrent readers while another thread recalibrates
+        bool ordered = true;
+        vector<thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&clock, &ordered]()
+                                 {
+                int64_t previous = 0;
+                for (int i = 0; i < 200000; ++i)
+                {
+                    int64_t now = clock.epoch_ns();
+                    if (now + 1000000 < previous)
+                    {
+                        ordered = false;
+                    }
+                    previous = now;
+                } });
+        }
+        for (int i = 0; i < 200; ++i)
+        {
+            clock.calibrate();
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        log_test_result("tsc_clock - concurrent calibration", ordered);
+
+        const int calls = 1000000;
+        auto timed = chrono::steady_clock::now();
+        int64_t sink = 0;
+        for (int i = 0; i < calls; ++i)
+        {
+            sink += clock.epoch_ns();
+        }
+        double ns_per_call = chrono::duration<double, nano>(chrono::steady_clock::now() - timed).count() / calls;
+        cout << "epoch_ns: " << ns_per_call << " ns/call" << (sink == 0 ? " " : "") << endl;
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " TSC CLOCK TEST" << endl;
+
+        test_epoch();
+        test_durations();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        TscClockTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
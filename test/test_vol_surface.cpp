@@ -0,0 +1,167 @@
+#include "../src/include/vol_surface.hpp"
+#include <json.hpp>
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+class VolSurfaceTester {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+
+    const int64_t now = 1700000000000LL;
+    const double forward = 60000.0;
+
+    void log_test_result(const string& test_name, bool passed, const string& message = "") {
+        tests_run++;
+        if (passed) {
+            tests_passed++;
+            cout << "" << test_name << " PASSED" << endl;
+        } else {
+            cout << "" << test_name << " FAILED";
+            if (!message.empty()) {
+                cout << " - " << message;
+            }
+            cout << endl;
+        }
+    }
+
+    static SviParams true_smile(int e) {
+        return SviParams{0.02 + 0.01 * e, 0.12 + 0.02 * e, -0.35, 0.02, 0.15};
+    }
+
+    int64_t expiry_at(int e) const {
+        return now + (7LL + 21LL * e) * 24 * 3600 * 1000;
+    }
+
+    nlohmann::json markets(int expiries) const {
+        nlohmann::json result = nlohmann::json::array();
+        for (int e = 0; e < expiries; ++e) {
+            for (int s = 0; s < 21; ++s) {
+                double strike = 40000.0 + s * 2000.0;
+                for (string type : {"call", "put"}) {
+                    string id = "BTC-E" + to_string(e) + "-" + to_string((int)strike) + (type == "call" ? "-C" : "-P");
+                    result.push_back({{"id", id}, {"base", "BTC"}, {"option", true}, {"inverse", true},
+                                      {"strike", strike}, {"optionType", type}, {"expiry", expiry_at(e)}, {"contractSize", 1.0}});
+                }
+            }
+        }
+        return result;
+    }
+
+    // Quotes every option at the vol implied by its expiry's smile
+    void feed(OptionsChain& chain, int expiries, double bump_expiry0) const {
+        for (int e = 0; e < expiries; ++e) {
+            double t = (expiry_at(e) - now) / (365.0 * 24 * 3600 * 1000);
+            SviParams p = true_smile(e);
+            for (int s = 0; s < 21; ++s) {
+                double strike = 40000.0 + s * 2000.0;
+                double k = log(strike / forward);
+                double iv = sqrt(p.total_variance(k) / t) + (e == 0 ? bump_expiry0 : 0.0);
+                for (double sign : {1.0, -1.0}) {
+                    double lnfk = -k, sqrt_t = sqrt(t), disc = 1.0, premium;
+                    black76::Inputs in;
+                    in.count = 1;
+                    in.forward = &forward;
+                    in.strike = &strike;
+                    in.log_moneyness = &lnfk;
+                    in.time = &t;
+                    in.sqrt_time = &sqrt_t;
+                    in.sign = &sign;
+                    in.discount = &disc;
+                    black76::price(in, &iv, &premium);
+                    string id = "BTC-E" + to_string(e) + "-" + to_string((int)strike) + (sign > 0 ? "-C" : "-P");
+                    chain.on_ticker({{"instrument_name", id}, {"underlying_price", forward}, {"mark_price", premium / forward}});
+                }
+            }
+        }
+    }
+
+public:
+    bool test_fit_smile() {
+        cout << "Testing SurfaceEngine::fit_smile()" << endl;
+
+        double t = 0.1;
+        SviParams truth{0.01, 0.15, -0.4, 0.05, 0.2};
+        SmileQuotes quotes;
+        for (double k = -0.5; k <= 0.5; k += 0.05) {
+            quotes.log_moneyness.push_back(k);
+            quotes.iv.push_back(sqrt(truth.total_variance(k) / t));
+            quotes.weight.push_back(1.0);
+        }
+
+        SmileFit cold = SurfaceEngine::fit_smile(0, t, quotes, nullptr);
+        log_test_result("vol_surface - cold fit recovers smile", cold.rmse < 1e-4, "rmse " + to_string(cold.rmse));
+
+        SmileFit warm = SurfaceEngine::fit_smile(0, t, quotes, &cold.params);
+        log_test_result("vol_surface - warm start stays converged", warm.rmse <= cold.rmse + 1e-9);
+
+        return tests_passed == tests_run;
+    }
+
+    bool test_engine() {
+        cout << "Testing SurfaceEngine::update()" << endl;
+
+        const int expiries = 4;
+        OptionsChain chain("BTC");
+        chain.load_markets(markets(expiries));
+        feed(chain, expiries, 0.0);
+        chain.reprice(now);
+
+        SurfaceEngine engine(2, 0.001);
+        size_t refits = engine.update(chain, now);
+        auto surface = engine.surface();
+        log_test_result("vol_surface - all expiries fitted", refits == expiries && surface->smiles.size() == expiries);
+
+        double worst = 0.0;
+        for (int e = 0; e < expiries; ++e) {
+            const SmileFit* fit = surface->smile(expiry_at(e));
+            double t = (expiry_at(e) - now) / (365.0 * 24 * 3600 * 1000);
+            for (double k = -0.3; k <= 0.3; k += 0.1) {
+                double expected = sqrt(true_smile(e).total_variance(k) / t);
+                worst = max(worst, fit ? abs(fit->implied_vol(k) - expected) : 1.0);
+            }
+        }
+        log_test_result("vol_surface - fitted vols match", worst < 1e-3, "worst error " + to_string(worst));
+
+        log_test_result("vol_surface - unchanged quotes skip refit", engine.update(chain, now) == 0);
+
+        feed(chain, expiries, 0.01);
+        chain.reprice(now);
+        size_t changed = engine.update(chain, now);
+        const SmileFit* bumped = engine.surface()->smile(expiry_at(0));
+        log_test_result("vol_surface - only changed expiry refitted", changed == 1 && bumped && bumped->fits == 2);
+
+        log_test_result("vol_surface - old snapshot untouched", surface->smile(expiry_at(0))->fits == 1);
+        log_test_result("vol_surface - json export", engine.surface()->to_json()["smiles"].size() == expiries);
+
+        return tests_passed == tests_run;
+    }
+
+    int run_all_tests() {
+        cout << " VOL SURFACE TEST" << endl;
+
+        test_fit_smile();
+        test_engine();
+
+        cout << "TEST SUMMARY" << endl;
+        cout << "Tests run: " << tests_run << endl;
+        cout << "Tests passed: " << tests_passed << endl;
+        cout << "Tests failed: " << (tests_run - tests_passed) << endl;
+
+        return tests_passed == tests_run ? 0 : 1;
+    }
+};
+
+int main() {
+    try {
+        VolSurfaceTester tester;
+        return tester.run_all_tests();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,109 @@
+#include "../src/include/frame_recorder.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Indexes or dumps segment files written by FrameRecorder.
+//
+//   frame_dump [--index] [--in|--out] [--connection N] segment.frames...
+//
+// --index prints one summary line per segment; otherwise every frame is
+// printed as "<timestamp_ns> <connection> <in|out> <length> <payload>".
+
+static void usage()
+{
+    cerr << "usage: frame_dump [--index] [--in|--out] [--connection N] segment.frames..." << endl;
+}
+
+int main(int argc, char **argv)
+{
+    bool index = false;
+    int direction = -1;
+    int connection = -1;
+    vector<string> paths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--index")
+        {
+            index = true;
+        }
+        else if (arg == "--in")
+        {
+            direction = FrameRecorder::Inbound;
+        }
+        else if (arg == "--out")
+        {
+            direction = FrameRecorder::Outbound;
+        }
+        else if (arg == "--connection" && i + 1 < argc)
+        {
+            connection = stoi(argv[++i]);
+        }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            usage();
+            return 1;
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty())
+    {
+        usage();
+        return 1;
+    }
+    sort(paths.begin(), paths.end());
+
+    try
+    {
+        for (const auto &path : paths)
+        {
+            FrameReader reader(path);
+            FrameRecord record;
+            uint64_t frames = 0, inbound = 0, outbound = 0, bytes = 0;
+            int64_t first = 0, last = 0;
+
+            while (reader.next(record))
+            {
+                if ((direction >= 0 && record.direction != direction) ||
+                    (connection >= 0 && record.connection != connection))
+                {
+                    continue;
+                }
+                frames++;
+                (record.direction == FrameRecorder::Inbound ? inbound : outbound)++;
+                bytes += record.payload.size();
+                first = first == 0 ? record.timestamp_ns : min(first, record.timestamp_ns);
+                last = max(last, record.timestamp_ns);
+
+                if (!index)
+                {
+                    cout << record.timestamp_ns << " " << record.connection << " "
+                         << (record.direction == FrameRecorder::Inbound ? "in" : "out") << " "
+                         << record.payload.size() << " " << record.payload << "\n";
+                }
+            }
+
+            if (index)
+            {
+                cout << path << " segment=" << reader.header().index << " frames=" << frames
+                     << " in=" << inbound << " out=" << outbound << " bytes=" << bytes
+                     << " first_ns=" << first << " last_ns=" << last << "\n";
+            }
+        }
+    }
+    catch (const exception &e)
+    {
+        cerr << "frame_dump: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
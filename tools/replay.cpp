@@ -0,0 +1,152 @@
+#include "../src/include/book_manager.hpp"
+#include "../src/include/deribit.hpp"
+#include "../src/include/frame_recorder.hpp"
+#include "../src/include/replay.hpp"
+#include <atomic>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Replays a FrameRecorder recording through an offline Deribit client and
+// reports the throughput achieved. Every ticker, trades and book channel
+// seen in the recording is subscribed; books are maintained by a BookManager.
+//
+//   replay [--speed X] [--connection N] [--prefix P] [--workers N] directory
+
+static void usage()
+{
+    cerr << "usage: replay [--speed X] [--connection N] [--prefix P] [--workers N] directory" << endl;
+}
+
+static vector<string> split(const string &channel)
+{
+    vector<string> parts;
+    stringstream stream(channel);
+    string part;
+    while (getline(stream, part, '.'))
+    {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+int main(int argc, char **argv)
+{
+    ReplayOptions options;
+    string prefix = "deribit";
+    string directory;
+    size_t workers = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--speed" && i + 1 < argc)
+        {
+            options.speed = stod(argv[++i]);
+        }
+        else if (arg == "--connection" && i + 1 < argc)
+        {
+            options.connection = stoi(argv[++i]);
+        }
+        else if (arg == "--prefix" && i + 1 < argc)
+        {
+            prefix = argv[++i];
+        }
+        else if (arg == "--workers" && i + 1 < argc)
+        {
+            workers = stoul(argv[++i]);
+        }
+        else if (arg.rfind("--", 0) == 0 || !directory.empty())
+        {
+            usage();
+            return 1;
+        }
+        else
+        {
+            directory = arg;
+        }
+    }
+    if (directory.empty())
+    {
+        usage();
+        return 1;
+    }
+
+    try
+    {
+        auto segments = ReplayDriver::segments(directory, prefix);
+
+        // Collect the channels the recording carries
+        set<string> channels;
+        for (const auto &path : segments)
+        {
+            FrameReader reader(path);
+            FrameRecord record;
+            while (reader.next(record))
+            {
+                if (record.direction != FrameRecorder::Inbound)
+                {
+                    continue;
+                }
+                auto frame = nlohmann::json::parse(record.payload.begin(), record.payload.end(), nullptr, false);
+                if (frame.is_object() && frame.value("method", "") == "subscription")
+                {
+                    channels.insert(frame["params"].value("channel", ""));
+                }
+            }
+        }
+
+        Deribit client({{"offline", true}});
+        BookManager books(workers);
+        books.start();
+        atomic<uint64_t> tickers{0}, trades{0};
+
+        for (const auto &channel : channels)
+        {
+            auto parts = split(channel);
+            if (parts.size() == 3 && parts[0] == "ticker")
+            {
+                client.watch_ticker([&](const nlohmann::json &)
+                                    { tickers++; },
+                                    parts[1], {{"interval", parts[2]}});
+            }
+            else if (parts.size() == 3 && parts[0] == "trades")
+            {
+                client.watch_trades([&](const nlohmann::json &)
+                                    { trades++; },
+                                    parts[1], 0, 0, {{"interval", parts[2]}});
+            }
+            else if (parts.size() == 3 && parts[0] == "book")
+            {
+                client.watch_order_book(books.handler(), parts[1], 0, {{"interval", parts[2]}});
+            }
+            else if (parts.size() == 5 && parts[0] == "book")
+            {
+                client.watch_order_book(books.handler(), parts[1], 0,
+                                        {{"useDepthEndpoint", true}, {"group", parts[2]}, {"depth", parts[3]}, {"interval", parts[4]}});
+            }
+        }
+
+        ReplayStats stats = ReplayDriver(client).run(segments, options);
+        books.stop();
+
+        nlohmann::json report = stats.to_json();
+        report["segments"] = segments.size();
+        report["channels"] = channels.size();
+        report["tickers"] = tickers.load();
+        report["trades"] = trades.load();
+        report["bookUpdates"] = books.processed();
+        report["bookDrops"] = books.dropped();
+        cout << report.dump(2) << endl;
+    }
+    catch (const exception &e)
+    {
+        cerr << "replay: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}